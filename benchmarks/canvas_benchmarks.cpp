@@ -0,0 +1,467 @@
+// Microbenchmarks for the shared canvas code. Every benchmark is sampled a
+// number of times and the results are written as JSON with the ns per
+// operation percentiles of the samples, followed by the memory stats of
+// every allocation tag.
+//
+// Usage: nk_benchmarks [--samples count] [--out file.json]
+
+#include <algorithm>
+#include <canvas_internal.h>
+#include <nk/app.h>
+#include <nk/canvas.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <texture_packer.h>
+#include <utils.h>
+#include <vector>
+
+#define BENCHMARK_WARMUP_SAMPLES  5
+#define BENCHMARK_DEFAULT_SAMPLES 100
+#define BENCHMARK_OPS_PER_SAMPLE  4096
+#define BENCHMARK_IMAGE_NUM       64
+#define BENCHMARK_ATLAS_IMAGE_NUM 256
+
+struct BenchmarkContext {
+    NkApp* app;
+    NkCanvas* canvas;
+    NkCanvasBase* base;
+    NkImage* images[BENCHMARK_IMAGE_NUM];
+    NkImage* atlasImages[BENCHMARK_ATLAS_IMAGE_NUM];
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    NkTextureAtlas* atlas;
+#endif
+    uint32_t rectSizes[BENCHMARK_ATLAS_IMAGE_NUM];
+    NkApp* startupApp;
+};
+
+typedef void (*BenchmarkFunc)(BenchmarkContext& context, uint32_t opNum);
+
+struct Benchmark {
+    const char* name;
+    uint32_t opNum;
+    BenchmarkFunc begin; // Not timed
+    BenchmarkFunc run;
+    BenchmarkFunc end; // Not timed
+};
+
+struct BenchmarkResult {
+    const char* name;
+    uint32_t opNum;
+    double mean;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+static inline float benchX(uint32_t index) { return (float)(index % 64) * 16; }
+
+static inline float benchY(uint32_t index) {
+    return (float)((index / 64) % 40) * 16;
+}
+
+static void beginCanvasFrame(BenchmarkContext& context, uint32_t /*opNum*/) {
+    nk::canvas::beginFrame(context.canvas);
+}
+
+static void endCanvasFrame(BenchmarkContext& context, uint32_t /*opNum*/) {
+    nk::canvas::endFrame(context.canvas);
+}
+
+static void beginMatrixFrame(BenchmarkContext& context, uint32_t /*opNum*/) {
+    nk::canvas::beginFrame(context.canvas);
+    nk::canvas::identity(context.canvas);
+}
+
+static void pushQuad(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        float x = benchX(index);
+        float y = benchY(index);
+        NkCanvasVertex vertices[NK_CANVAS_VERTICES_PER_QUAD] = {
+            {{x, y}, {0.0f, 0.0f}, 0xffffffff},
+            {{x, y + 16}, {0.0f, 1.0f}, 0xffffffff},
+            {{x + 16, y + 16}, {1.0f, 1.0f}, 0xffffffff},
+            {{x + 16, y}, {1.0f, 0.0f}, 0xffffffff},
+        };
+        context.base->pushQuad(vertices, context.base->whiteImage);
+    }
+}
+
+static void drawImagePosition(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              context.images[0]);
+    }
+}
+
+static void drawImageColor(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              0xff00ffff, context.images[0]);
+    }
+}
+
+static void drawImageSize(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              24, 24, context.images[0]);
+    }
+}
+
+static void drawImageSizeColor(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              24, 24, 0xff00ffff, context.images[0]);
+    }
+}
+
+static void drawImageFrame(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index), 4,
+                              4, 8, 8, 0xffffffff, context.images[0]);
+    }
+}
+
+static void drawImageSizeFrame(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              24, 24, 4, 4, 8, 8, 0xffffffff,
+                              context.images[0]);
+    }
+}
+
+static void drawImageTransform(BenchmarkContext& context, uint32_t opNum) {
+    NkImageTransform transform = {0.5f, 8.0f, 8.0f, 1.5f, 1.5f};
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              transform, 0xffffffff, context.images[0]);
+    }
+}
+
+static void drawImageSizeFrameTransform(BenchmarkContext& context,
+                                        uint32_t opNum) {
+    NkImageTransform transform = {0.5f, 8.0f, 8.0f, 1.5f, 1.5f};
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              24, 24, 4, 4, 8, 8, transform, 0xffffffff,
+                              context.images[0]);
+    }
+}
+
+static void drawLine(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        float x = benchX(index);
+        float y = benchY(index);
+        nk::canvas::drawLine(context.canvas, x, y, x + 12, y + 7, 2.0f,
+                             0xffffffff);
+    }
+}
+
+static void pushPopMatrix(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::pushMatrix(context.canvas);
+        nk::canvas::popMatrix(context.canvas);
+    }
+}
+
+static void translate(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::translate(context.canvas, 0.5f, 0.25f);
+    }
+}
+
+static void rotate(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::rotate(context.canvas, 0.01f);
+    }
+}
+
+static void scale(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::scale(context.canvas, 1.0001f, 0.9999f);
+    }
+}
+
+// Every draw switches texture and blend mode. The atlas and bindless backends
+// batch across textures, so the blend mode is what makes every quad start a
+// new batch on all of them.
+static void textureChurn(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        nk::canvas::setBlendMode(context.canvas, (index & 1)
+                                                     ? NkBlendMode::ADDITIVE
+                                                     : NkBlendMode::ALPHA);
+        nk::canvas::drawImage(context.canvas, benchX(index), benchY(index),
+                              context.images[index % BENCHMARK_IMAGE_NUM]);
+    }
+    nk::canvas::setBlendMode(context.canvas, NkBlendMode::ALPHA);
+}
+
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+// The frame atlas is reset in beginFrame and the images are released from it
+// in endFrame, so every sample adds images that aren't in the atlas yet.
+static void atlasAddImage(BenchmarkContext& context, uint32_t opNum) {
+    NkTextureAtlas& atlas = context.base->frameTextureAtlas;
+    for (uint32_t index = 0; index < opNum; ++index) {
+        atlas.addImage(context.atlasImages[index]);
+    }
+}
+
+static void beginAtlasAddRect(BenchmarkContext& context, uint32_t /*opNum*/) {
+    context.atlas->reset();
+}
+
+static void atlasAddRect(BenchmarkContext& context, uint32_t opNum) {
+    for (uint32_t index = 0; index < opNum; ++index) {
+        uint32_t size = context.rectSizes[index];
+        context.atlas->addRect(size, size + 4);
+    }
+}
+#endif
+
+// Time from creating an app until its first frame is presented.
+static void appStartup(BenchmarkContext& context, uint32_t /*opNum*/) {
+    NkAppInfo appInfo{};
+    appInfo.width = 1024;
+    appInfo.height = 640;
+    appInfo.title = "nk_startup";
+    context.startupApp = nk::app::create(appInfo);
+    NkCanvas* canvas = nk::app::canvas(context.startupApp);
+    nk::canvas::beginFrame(canvas);
+    nk::canvas::drawRect(canvas, 0, 0, 16, 16, 0xffffffff);
+    nk::canvas::endFrame(canvas);
+    nk::canvas::present(canvas);
+}
+
+static void endAppStartup(BenchmarkContext& context, uint32_t /*opNum*/) {
+    nk::app::destroy(context.startupApp);
+    context.startupApp = nullptr;
+}
+
+static void emptyJob(void* /*userData*/, uint32_t /*jobIndex*/) {}
+
+static void runEmptyJobs(BenchmarkContext& /*context*/, uint32_t opNum) {
+    NkJobCounter counter{};
+    nk::utils::runJobs(&emptyJob, nullptr, opNum, &counter);
+    nk::utils::waitJobs(&counter);
+}
+
+static const Benchmark benchmarks[] = {
+    {"pushQuad", BENCHMARK_OPS_PER_SAMPLE, beginCanvasFrame, pushQuad,
+     endCanvasFrame},
+    {"drawImage(x, y, image)", BENCHMARK_OPS_PER_SAMPLE, beginCanvasFrame,
+     drawImagePosition, endCanvasFrame},
+    {"drawImage(x, y, color, image)", BENCHMARK_OPS_PER_SAMPLE,
+     beginCanvasFrame, drawImageColor, endCanvasFrame},
+    {"drawImage(x, y, width, height, image)", BENCHMARK_OPS_PER_SAMPLE,
+     beginCanvasFrame, drawImageSize, endCanvasFrame},
+    {"drawImage(x, y, width, height, color, image)", BENCHMARK_OPS_PER_SAMPLE,
+     beginCanvasFrame, drawImageSizeColor, endCanvasFrame},
+    {"drawImage(x, y, frame, color, image)", BENCHMARK_OPS_PER_SAMPLE,
+     beginCanvasFrame, drawImageFrame, endCanvasFrame},
+    {"drawImage(x, y, width, height, frame, color, image)",
+     BENCHMARK_OPS_PER_SAMPLE, beginCanvasFrame, drawImageSizeFrame,
+     endCanvasFrame},
+    {"drawImage(x, y, transform, color, image)", BENCHMARK_OPS_PER_SAMPLE,
+     beginCanvasFrame, drawImageTransform, endCanvasFrame},
+    {"drawImage(x, y, width, height, frame, transform, color, image)",
+     BENCHMARK_OPS_PER_SAMPLE, beginCanvasFrame, drawImageSizeFrameTransform,
+     endCanvasFrame},
+    {"drawLine", BENCHMARK_OPS_PER_SAMPLE, beginCanvasFrame, drawLine,
+     endCanvasFrame},
+    {"pushMatrix + popMatrix", BENCHMARK_OPS_PER_SAMPLE, beginMatrixFrame,
+     pushPopMatrix, endCanvasFrame},
+    {"translate", BENCHMARK_OPS_PER_SAMPLE, beginMatrixFrame, translate,
+     endCanvasFrame},
+    {"rotate", BENCHMARK_OPS_PER_SAMPLE, beginMatrixFrame, rotate,
+     endCanvasFrame},
+    {"scale", BENCHMARK_OPS_PER_SAMPLE, beginMatrixFrame, scale,
+     endCanvasFrame},
+    {"textureChurn", BENCHMARK_OPS_PER_SAMPLE, beginCanvasFrame, textureChurn,
+     endCanvasFrame},
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    {"NkTextureAtlas::addImage", BENCHMARK_ATLAS_IMAGE_NUM, beginCanvasFrame,
+     atlasAddImage, endCanvasFrame},
+    {"NkTextureAtlas::addRect", BENCHMARK_ATLAS_IMAGE_NUM, beginAtlasAddRect,
+     atlasAddRect, nullptr},
+#endif
+    {"startup (create to first present)", 1, nullptr, appStartup,
+     endAppStartup},
+    {"nk::utils::runJobs (empty)", 1024, nullptr, runEmptyJobs, nullptr},
+};
+
+static double percentile(const std::vector<double>& sorted, double value) {
+    size_t index = (size_t)(value * (double)(sorted.size() - 1) + 0.5);
+    return sorted[nk::utils::min(index, sorted.size() - 1)];
+}
+
+static BenchmarkResult runBenchmark(BenchmarkContext& context,
+                                    const Benchmark& benchmark,
+                                    uint32_t sampleNum) {
+    std::vector<double> samples;
+    samples.reserve(sampleNum);
+    for (uint32_t sample = 0; sample < BENCHMARK_WARMUP_SAMPLES + sampleNum;
+         ++sample) {
+        if (benchmark.begin) {
+            benchmark.begin(context, benchmark.opNum);
+        }
+        uint64_t startTime = nk::utils::timeNs();
+        benchmark.run(context, benchmark.opNum);
+        uint64_t endTime = nk::utils::timeNs();
+        if (benchmark.end) {
+            benchmark.end(context, benchmark.opNum);
+        }
+        if (sample >= BENCHMARK_WARMUP_SAMPLES) {
+            samples.push_back((double)(endTime - startTime) / benchmark.opNum);
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result{};
+    result.name = benchmark.name;
+    result.opNum = benchmark.opNum;
+    for (double sample : samples) {
+        result.mean += sample;
+    }
+    result.mean /= (double)samples.size();
+    result.min = samples.front();
+    result.p50 = percentile(samples, 0.50);
+    result.p90 = percentile(samples, 0.90);
+    result.p99 = percentile(samples, 0.99);
+    result.max = samples.back();
+    return result;
+}
+
+static void writeMemoryStats(FILE* file, const char* name,
+                             const NkMemoryTagStats& stats, bool last) {
+    fprintf(file,
+            "    \"%s\": {\"liveBytes\": %zu, \"peakBytes\": %zu, "
+            "\"liveAllocations\": %u, \"totalAllocations\": %llu}%s\n",
+            name, stats.liveBytes, stats.peakBytes, stats.liveAllocationNum,
+            (unsigned long long)stats.totalAllocationNum, last ? "" : ",");
+}
+
+static void writeResults(FILE* file,
+                         const std::vector<BenchmarkResult>& results,
+                         const NkMemoryStats& memoryStats,
+                         uint32_t sampleNum) {
+    fprintf(file, "{\n");
+    fprintf(file, "  \"config\": {\n");
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    fprintf(file, "    \"textureAtlas\": true,\n");
+#else
+    fprintf(file, "    \"textureAtlas\": false,\n");
+#endif
+#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+    fprintf(file, "    \"bindless\": true,\n");
+#else
+    fprintf(file, "    \"bindless\": false,\n");
+#endif
+#if NK_CANVAS_STATS_ENABLED
+    fprintf(file, "    \"stats\": true,\n");
+#else
+    fprintf(file, "    \"stats\": false,\n");
+#endif
+    fprintf(file, "    \"samples\": %u,\n", sampleNum);
+    fprintf(file, "    \"warmupSamples\": %u\n", BENCHMARK_WARMUP_SAMPLES);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (size_t index = 0; index < results.size(); ++index) {
+        const BenchmarkResult& result = results[index];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"opsPerSample\": %u, \"nsPerOp\": "
+                "{\"mean\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+                "\"p99\": %.3f, \"max\": %.3f}}%s\n",
+                result.name, result.opNum, result.mean, result.min, result.p50,
+                result.p90, result.p99, result.max,
+                index + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ],\n");
+    fprintf(file, "  \"memory\": {\n");
+    for (uint32_t tag = 0; tag < (uint32_t)NkMemoryTag::COUNT; ++tag) {
+        writeMemoryStats(file, nk::utils::memoryTagName((NkMemoryTag)tag),
+                         memoryStats.tags[tag], false);
+    }
+    writeMemoryStats(file, "total", memoryStats.total, true);
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+}
+
+int main(int argc, char** argv) {
+    uint32_t sampleNum = BENCHMARK_DEFAULT_SAMPLES;
+    const char* outputPath = nullptr;
+    for (int index = 1; index < argc; ++index) {
+        if (strcmp(argv[index], "--samples") == 0 && index + 1 < argc) {
+            sampleNum = (uint32_t)nk::utils::max(atoi(argv[++index]), 1);
+        } else if (strcmp(argv[index], "--out") == 0 && index + 1 < argc) {
+            outputPath = argv[++index];
+        } else {
+            printf("Usage: nk_benchmarks [--samples count] "
+                   "[--out file.json]\n");
+            return 1;
+        }
+    }
+
+    BenchmarkContext context{};
+    NkAppInfo appInfo{};
+    appInfo.width = 1024;
+    appInfo.height = 640;
+    appInfo.title = "nk_benchmarks";
+    appInfo.jobWorkerNum = NK_JOB_WORKER_NUM_AUTO;
+    context.app = nk::app::create(appInfo);
+    context.canvas = nk::app::canvas(context.app);
+    context.base = nk::canvas_internal::canvasBase(context.canvas);
+
+    std::vector<uint32_t> pixels(64 * 64, 0xffffffff);
+    for (uint32_t index = 0; index < BENCHMARK_IMAGE_NUM; ++index) {
+        context.images[index] =
+            nk::canvas::createImage(context.canvas, 16, 16, pixels.data());
+    }
+    // Sizes between 8 and 64 so the atlas packer has to split rects.
+    uint32_t seed = 0x1234567;
+    for (uint32_t index = 0; index < BENCHMARK_ATLAS_IMAGE_NUM; ++index) {
+        seed = seed * 1664525 + 1013904223;
+        context.rectSizes[index] = 8 + (seed >> 16) % 57;
+        context.atlasImages[index] = nk::canvas::createImage(
+            context.canvas, context.rectSizes[index], context.rectSizes[index],
+            pixels.data());
+    }
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    context.atlas =
+        (NkTextureAtlas*)nk::utils::memZeroAlloc(1, sizeof(NkTextureAtlas),
+                                                 NkMemoryTag::TEXTURE_ATLAS);
+    context.atlas->init(NK_CANVAS_TEXTURE_ATLAS_WIDTH,
+                        NK_CANVAS_TEXTURE_ATLAS_HEIGHT);
+#endif
+
+    std::vector<BenchmarkResult> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        results.push_back(runBenchmark(context, benchmark, sampleNum));
+        fprintf(stderr, "%-64s %10.2f ns/op (p50)\n", benchmark.name,
+                results.back().p50);
+    }
+
+    FILE* file = outputPath ? fopen(outputPath, "wb") : stdout;
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", outputPath);
+        return 1;
+    }
+    writeResults(file, results, nk::utils::memoryStats(), sampleNum);
+    if (file != stdout) {
+        fclose(file);
+    }
+
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    context.atlas->destroy();
+    nk::utils::memFree(context.atlas, NkMemoryTag::TEXTURE_ATLAS);
+#endif
+    for (NkImage* image : context.atlasImages) {
+        nk::canvas::destroyImage(context.canvas, image);
+    }
+    for (NkImage* image : context.images) {
+        nk::canvas::destroyImage(context.canvas, image);
+    }
+    nk::app::destroy(context.app);
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Spawns bouncing sprites and draws them for a fixed number of frames, then
+// prints the frame CPU time and the number of sprites drawn per second.
+// Builds without a window on Linux so it can run headless.
+//
+// Usage: bunnymark [sprite count] [frame count]
+
+#include <nk/app.h>
+#include <nk/canvas.h>
+#include <nk/hid.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../draw_multiple_images/image.h"
+
+#if __EMSCRIPTEN__
+#include <emscripten/html5.h>
+#endif
+
+#define BUNNYMARK_DEFAULT_SPRITES 20000
+#define BUNNYMARK_DEFAULT_FRAMES  600
+#define BUNNYMARK_IMAGE_NUM       4
+#define BUNNYMARK_GRAVITY         0.5f
+
+struct Sprite {
+    float x;
+    float y;
+    float speedX;
+    float speedY;
+    uint32_t color;
+    uint32_t imageIndex;
+};
+
+struct Bunnymark {
+    NkApp* app;
+    NkCanvas* canvas;
+    NkHID* hid;
+    NkImage* images[BUNNYMARK_IMAGE_NUM];
+    std::vector<Sprite> sprites;
+    std::vector<double> frameTimes;
+    uint32_t frameNum;
+};
+
+static float randomFloat() { return (float)rand() / (float)RAND_MAX; }
+
+static void updateSprites(Bunnymark& bunnymark) {
+    float viewWidth = nk::canvas::viewWidth(bunnymark.canvas);
+    float viewHeight = nk::canvas::viewHeight(bunnymark.canvas);
+    for (Sprite& sprite : bunnymark.sprites) {
+        NkImage* image = bunnymark.images[sprite.imageIndex];
+        float maxX = viewWidth - nk::img::width(image) * 0.25f;
+        float maxY = viewHeight - nk::img::height(image) * 0.25f;
+        sprite.x += sprite.speedX;
+        sprite.y += sprite.speedY;
+        sprite.speedY += BUNNYMARK_GRAVITY;
+        if (sprite.x > maxX) {
+            sprite.speedX = -sprite.speedX;
+            sprite.x = maxX;
+        } else if (sprite.x < 0.0f) {
+            sprite.speedX = -sprite.speedX;
+            sprite.x = 0.0f;
+        }
+        if (sprite.y > maxY) {
+            sprite.speedY *= -0.85f;
+            sprite.y = maxY;
+            if (randomFloat() > 0.5f) {
+                sprite.speedY -= randomFloat() * 6.0f;
+            }
+        } else if (sprite.y < 0.0f) {
+            sprite.speedY = 0.0f;
+            sprite.y = 0.0f;
+        }
+    }
+}
+
+static void drawSprites(Bunnymark& bunnymark) {
+    for (const Sprite& sprite : bunnymark.sprites) {
+        NkImage* image = bunnymark.images[sprite.imageIndex];
+        nk::canvas::drawImage(bunnymark.canvas, sprite.x, sprite.y,
+                              nk::img::width(image) * 0.25f,
+                              nk::img::height(image) * 0.25f, sprite.color,
+                              image);
+    }
+}
+
+// Returns false once all the frames have been drawn.
+static bool runFrame(Bunnymark& bunnymark) {
+    nk::app::update(bunnymark.app);
+    if (nk::hid::keyClick(bunnymark.hid, NkKeyCode::ESC)) {
+        nk::app::quit(bunnymark.app);
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    updateSprites(bunnymark);
+    nk::canvas::beginFrame(bunnymark.canvas);
+    drawSprites(bunnymark);
+    nk::canvas::endFrame(bunnymark.canvas);
+    nk::canvas::present(bunnymark.canvas);
+    auto endTime = std::chrono::high_resolution_clock::now();
+    bunnymark.frameTimes[bunnymark.frameNum++] =
+        std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    return bunnymark.frameNum < bunnymark.frameTimes.size() &&
+           !nk::app::shouldQuit(bunnymark.app);
+}
+
+static void printResults(const Bunnymark& bunnymark) {
+    if (bunnymark.frameNum == 0) {
+        return;
+    }
+    std::vector<double> frameTimes(bunnymark.frameTimes.begin(),
+                                   bunnymark.frameTimes.begin() +
+                                       bunnymark.frameNum);
+    std::sort(frameTimes.begin(), frameTimes.end());
+    double totalTime = 0.0;
+    for (double frameTime : frameTimes) {
+        totalTime += frameTime;
+    }
+    double average = totalTime / frameTimes.size();
+    double p50 = frameTimes[(frameTimes.size() - 1) / 2];
+    double p99 = frameTimes[(size_t)((frameTimes.size() - 1) * 0.99)];
+    double spritesPerSecond =
+        (double)bunnymark.sprites.size() * frameTimes.size() /
+        (totalTime / 1000.0);
+    printf("bunnymark: %zu sprites, %u frames\n", bunnymark.sprites.size(),
+           bunnymark.frameNum);
+    printf("frame time: avg %.3f ms, p50 %.3f ms, p99 %.3f ms\n", average, p50,
+           p99);
+    printf("sprites/s: %.0f\n", spritesPerSecond);
+}
+
+int main(int argc, char** argv) {
+    uint32_t spriteNum =
+        argc > 1 ? (uint32_t)atoi(argv[1]) : BUNNYMARK_DEFAULT_SPRITES;
+    uint32_t frameNum =
+        argc > 2 ? (uint32_t)atoi(argv[2]) : BUNNYMARK_DEFAULT_FRAMES;
+    if (frameNum == 0) {
+        printf("Usage: bunnymark [sprite count] [frame count]\n");
+        return 1;
+    }
+
+    static Bunnymark bunnymark{};
+    bunnymark.app = nk::app::create({960, 640, "Bunnymark", false, 0, true});
+    bunnymark.canvas = nk::app::canvas(bunnymark.app);
+    bunnymark.hid = nk::app::hid(bunnymark.app);
+    bunnymark.images[0] = nk::canvas::createImage(
+        bunnymark.canvas, image_img1_width, image_img1_height, image_img1);
+    bunnymark.images[1] = nk::canvas::createImage(
+        bunnymark.canvas, image_img2_width, image_img2_height, image_img2);
+    bunnymark.images[2] = nk::canvas::createImage(
+        bunnymark.canvas, image_img3_width, image_img3_height, image_img3);
+    bunnymark.images[3] = nk::canvas::createImage(
+        bunnymark.canvas, image_img4_width, image_img4_height, image_img4);
+    bunnymark.frameTimes.resize(frameNum);
+
+    // Fixed seed so every run draws the same frames.
+    srand(1234);
+    bunnymark.sprites.resize(spriteNum);
+    for (Sprite& sprite : bunnymark.sprites) {
+        sprite.x = randomFloat() * nk::canvas::viewWidth(bunnymark.canvas);
+        sprite.y = randomFloat() * nk::canvas::viewHeight(bunnymark.canvas);
+        sprite.speedX = randomFloat() * 10.0f;
+        sprite.speedY = randomFloat() * 10.0f - 5.0f;
+        sprite.color = NK_COLOR_RGB_UINT(rand() % 256, rand() % 256,
+                                         rand() % 256);
+        sprite.imageIndex = rand() % BUNNYMARK_IMAGE_NUM;
+    }
+
+#if __EMSCRIPTEN__
+    emscripten_set_main_loop_arg(
+        [](void* userData) {
+            Bunnymark& bunnymark = *(Bunnymark*)userData;
+            if (!runFrame(bunnymark)) {
+                printResults(bunnymark);
+                emscripten_cancel_main_loop();
+            }
+        },
+        &bunnymark, 0, 1);
+#else
+    while (runFrame(bunnymark)) {
+    }
+    printResults(bunnymark);
+
+    for (uint32_t index = 0; index < BUNNYMARK_IMAGE_NUM; ++index) {
+        nk::canvas::destroyImage(bunnymark.canvas, bunnymark.images[index]);
+    }
+    nk::app::destroy(bunnymark.app);
+#endif
+    return 0;
+}
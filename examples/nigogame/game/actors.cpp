@@ -284,17 +284,14 @@ void NcSprite::update(NcGame* game) {
 void NcSprite::render(NcGame* game) {
     NcActor::render(game);
     if (image != nullptr && visible) {
-        NkCanvas* canvas = game->canvas;
-        nk::canvas::pushMatrix(canvas);
-        nk::canvas::translate(canvas, position.x, position.y);
-        nk::canvas::rotate(canvas, rotation);
-        nk::canvas::scale(canvas, scale.x, scale.y);
-        nk::canvas::drawImage(
-            canvas, -currentFrame.width * origin.x,
-            -currentFrame.height * origin.y, currentFrame.width,
-            currentFrame.height, currentFrame.x, currentFrame.y,
-            currentFrame.width, currentFrame.height, color, image);
-        nk::canvas::popMatrix(canvas);
+        NkImageTransform transform = {
+            rotation, currentFrame.width * origin.x,
+            currentFrame.height * origin.y, scale.x, scale.y};
+        nk::canvas::drawImage(game->canvas, position.x, position.y,
+                              currentFrame.width, currentFrame.height,
+                              currentFrame.x, currentFrame.y,
+                              currentFrame.width, currentFrame.height,
+                              transform, color, image);
     }
 }
 NcRect NcSprite::getRect() const {
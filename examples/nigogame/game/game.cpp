@@ -1,6 +1,7 @@
 #include "game.h"
 #include <chrono>
 #include <random>
+#include <stdio.h>
 #include <stdlib.h>
 #include <thread>
 
@@ -35,45 +36,89 @@ NkImage* NcScene::getImage(const std::string& name) {
     return nullptr;
 }
 
-void NcGame::init() {
+void NcGame::init(const char* recordPath, const char* replayPath,
+                  const char* videoPath) {
     app = nk::app::create({600, 900, "NIGO", false, 0, false, false});
     canvas = nk::app::canvas(app);
     hid = nk::app::hid(app);
+    // Recorded sessions need the same random numbers to play back the same.
+    if (recordPath || replayPath) {
+        randomGenerator.seed(NC_GAME_REPLAY_RANDOM_SEED);
+    } else {
+        randomGenerator.seed(std::random_device()());
+    }
+    if (recordPath) {
+        nk::hid::startRecording(hid, recordPath);
+    }
+    replayEnabled = replayPath && nk::hid::startReplay(hid, replayPath);
     currentState = NcSceneState::NONE;
     nextState = NcSceneState::MAIN_MENU;
     currentScene = nullptr;
     gameScale = 2.0f;
     renderTarget = nk::canvas::createRenderTargetImage(
         canvas, 640 / (uint32_t)gameScale, 960 / (uint32_t)gameScale);
-    accumulatedTime = 0.0f;
-    targetFrameTime = 1.0f / 60.0f;
-    startTime = getSeconds();
-    endTime = getSeconds();
+    // One step per update since the HID state only changes in
+    // nk::app::update and clicks would repeat on the extra steps.
+    timestep.stepTime = 1.0 / 60.0;
+    timestep.accumulatedTime = 0.0;
+    timestep.maxStepNum = 1;
+    elapsedTime = timestep.stepTime;
+    videoEnabled = videoPath &&
+                   nk::canvas::beginVideoCapture(canvas, videoPath,
+                                                 NkVideoFormat::Y4M, 60);
     width = nk::img::width(renderTarget);
     height = nk::img::height(renderTarget);
     nk::hid::showCursor(hid, false);
 }
 
 void NcGame::destroy() {
+    if (replayEnabled && !replayFrameTimes.empty()) {
+        std::sort(replayFrameTimes.begin(), replayFrameTimes.end());
+        double totalTime = 0.0;
+        for (double frameTime : replayFrameTimes) {
+            totalTime += frameTime;
+        }
+        // stderr keeps stdout clean when the video is written there.
+        fprintf(stderr,
+                "replay: %zu frames, avg %.3f ms, p50 %.3f ms, max %.3f ms\n",
+                replayFrameTimes.size(), totalTime / replayFrameTimes.size(),
+                replayFrameTimes[(replayFrameTimes.size() - 1) / 2],
+                replayFrameTimes.back());
+    }
+    if (videoEnabled) {
+        nk::canvas::endVideoCapture(canvas);
+    }
     nk::canvas::destroyImage(canvas, renderTarget);
     nk::app::destroy(app);
 }
 
 void NcGame::update() {
-    endTime = getSeconds();
-    elapsedTime = endTime - startTime;
-    startTime = getSeconds();
-
-    accumulatedTime += elapsedTime;
-
-    if (frameCount == 0 || accumulatedTime >= targetFrameTime) {
+    double startTime = getSeconds();
+    // Input is only polled on loops that run a step. A recording then has
+    // one HID frame per step, which is what a replay feeds back, and clicks
+    // can't land on an update that doesn't reach the scene. A replay steps
+    // the game every loop so it isn't bound to real time.
+    double pendingTime =
+        timestep.accumulatedTime + nk::app::timeSinceUpdate(app);
+    uint32_t stepNum = 0;
+    if (frameCount == 0 || replayEnabled ||
+        pendingTime >= timestep.stepTime * (1.0 - NC_GAME_STEP_SNAP)) {
         nk::app::update(app);
+        if (replayEnabled && !nk::hid::replaying(hid)) {
+            nk::app::quit(app);
+        }
         mouse.x = nk::hid::mouseX(hid) / gameScale;
         mouse.y = nk::hid::mouseY(hid) / gameScale;
+        stepNum = nk::app::fixedSteps(app, &timestep);
+        if (stepNum == 0 || replayEnabled) {
+            // A replay runs one step per recorded frame. Otherwise the app
+            // clock landed a hair short of the step this loop measured.
+            timestep.accumulatedTime = 0.0;
+            stepNum = 1;
+        }
+    }
 
-        accumulatedTime -= targetFrameTime;
-        elapsedTime = targetFrameTime;
-
+    for (uint32_t step = 0; step < stepNum; ++step) {
         if (nextState != currentState) {
             if (currentScene) {
                 currentScene->destroy();
@@ -100,7 +145,9 @@ void NcGame::update() {
         if (currentScene) {
             currentScene->update();
         }
+    }
 
+    if (stepNum > 0) {
         // Render Game
         nk::canvas::beginFrame(canvas, renderTarget);
         nk::canvas::drawRect(canvas, 0.0f, 0.0f, width, height,
@@ -113,6 +160,9 @@ void NcGame::update() {
             nk::canvas::popMatrix(canvas);
         }
         nk::canvas::endFrame(canvas);
+        if (videoEnabled) {
+            nk::canvas::captureVideoFrame(canvas, renderTarget);
+        }
     }
 
     // Render Game Texture
@@ -127,11 +177,18 @@ void NcGame::update() {
 
     nk::canvas::present(canvas);
     frameCount++;
+    if (replayEnabled) {
+        replayFrameTimes.push_back((getSeconds() - startTime) * 1000.0);
+    }
 
     if (nk::app::shouldQuit(app)) {
         if (currentScene) {
             currentScene->destroy();
         }
+    } else if (!replayEnabled || videoEnabled) {
+        // The video capture drops frames it can't keep up with, so a
+        // replay that is being recorded runs at the video frame rate.
+        nk::app::limitFrameRate(app, timestep.stepTime);
     }
 }
 
@@ -157,8 +214,6 @@ double NcGame::getSeconds() const {
 float NcGame::getElapsedTime() const { return (float)elapsedTime; }
 
 float NcGame::randomFloat() const {
-    static std::random_device randDevice;
-    static std::mt19937 mtGen(randDevice());
-    static std::uniform_real_distribution<float> udt;
-    return udt(mtGen);
+    std::uniform_real_distribution<float> udt;
+    return udt(randomGenerator);
 }
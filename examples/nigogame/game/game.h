@@ -4,11 +4,14 @@
 #include "moco.h"
 #include "player.h"
 #include "tilemap.h"
+#include <algorithm>
 #include <assert.h>
 #include <chrono>
+#include <math.h>
 #include <nk/app.h>
 #include <nk/canvas.h>
 #include <nk/hid.h>
+#include <random>
 #include <stdint.h>
 #include <unordered_map>
 #include <vector>
@@ -68,8 +71,13 @@ struct NcGameScene : public NcScene {
     float fadeScreen;
 };
 
+#define NC_GAME_REPLAY_RANDOM_SEED 0x4e49474f
+// Same tolerance nk::app::fixedSteps uses to snap frame times to a step.
+#define NC_GAME_STEP_SNAP 0.02
+
 struct NcGame {
-    void init();
+    void init(const char* recordPath, const char* replayPath,
+              const char* videoPath);
     void destroy();
     void update();
     void run();
@@ -96,9 +104,10 @@ private:
     NcSceneState nextState;
     float gameScale;
     uint32_t frameCount;
-    double targetFrameTime;
+    NkFixedTimestep timestep;
     double elapsedTime;
-    double accumulatedTime;
-    double startTime;
-    double endTime;
+    mutable std::mt19937 randomGenerator;
+    bool replayEnabled;
+    bool videoEnabled;
+    std::vector<double> replayFrameTimes;
 };
\ No newline at end of file
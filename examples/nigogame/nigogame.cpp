@@ -3,10 +3,28 @@
 #include <nk/hid.h>
 
 #include "game/game.h"
+#include <string.h>
 
-int main() {
-    NcGame game;
-    game.init();
+// Usage: nigogame [--record <file>] [--replay <file>] [--video <file>]
+// A replay runs the recorded session as fast as possible and prints the
+// frame times when it's done. --video writes the game as a Y4M stream,
+// "-" writes it to stdout so it can be piped into an encoder.
+int main(int argc, char** argv) {
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* videoPath = nullptr;
+    for (int index = 1; index + 1 < argc; index += 2) {
+        if (strcmp(argv[index], "--record") == 0) {
+            recordPath = argv[index + 1];
+        } else if (strcmp(argv[index], "--replay") == 0) {
+            replayPath = argv[index + 1];
+        } else if (strcmp(argv[index], "--video") == 0) {
+            videoPath = argv[index + 1];
+        }
+    }
+
+    static NcGame game;
+    game.init(recordPath, replayPath, videoPath);
     game.run();
     game.destroy();
     return 0;
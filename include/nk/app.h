@@ -26,8 +26,44 @@
 typedef void* (*NkReallocFunc)(void* ptr, size_t size);
 typedef void (*NkFreeFunc)(void* ptr);
 
+// Subsystem that owns an allocation. It's passed to every NkAllocator call so
+// custom allocators can route or track memory per subsystem.
+enum class NkMemoryTag : uint32_t {
+    APP,
+    CANVAS,
+    VERTEX_BUFFER,
+    DRAW_BATCH,
+    INDEX_BUFFER,
+    TEXTURE_ATLAS,
+    IMAGE,
+    HID,
+    CAPTURE,
+    PROFILER,
+    FRAME_ARENA,
+    JOBS,
+    COUNT
+};
+
+typedef void* (*NkAllocatorAllocFunc)(size_t size, size_t alignment,
+                                      NkMemoryTag tag, void* userData);
+typedef void* (*NkAllocatorReallocFunc)(void* ptr, size_t size,
+                                        size_t alignment, NkMemoryTag tag,
+                                        void* userData);
+typedef void (*NkAllocatorFreeFunc)(void* ptr, NkMemoryTag tag,
+                                    void* userData);
+
+struct NkAllocator {
+    NkAllocatorAllocFunc alloc;
+    NkAllocatorReallocFunc realloc; // Must keep the alignment of ptr
+    NkAllocatorFreeFunc free;
+    void* userData;
+};
+
 struct NkApp;
 
+// Starts one job worker per hardware thread, minus the calling thread.
+#define NK_JOB_WORKER_NUM_AUTO 0xffffffff
+
 struct NkAppInfo {
     uint32_t width;
     uint32_t height;
@@ -38,6 +74,27 @@ struct NkAppInfo {
     bool fullScreen;
     NkReallocFunc reallocFunc;
     NkFreeFunc freeFunc;
+    NkAllocator allocator; // Takes precedence over reallocFunc and freeFunc
+    uint32_t jobWorkerNum; // Zero runs jobs on the thread waiting for them
+};
+
+// Runs the simulation at a fixed rate independent of the frame rate. Fill in
+// stepTime and maxStepNum, the accumulator starts at zero.
+struct NkFixedTimestep {
+    double stepTime;        // Seconds per step
+    double accumulatedTime; // Seconds not consumed by a step yet
+    uint32_t maxStepNum;    // Steps per frame before time is dropped, 0 is 1
+};
+
+// How close nk::app::limitFrameRate gets to its deadlines. Jitter is how late
+// a frame was released, sleep and spin are how the wait was spent. All
+// values are in seconds.
+struct NkFrameLimiterStats {
+    uint32_t frameNum;
+    double averageJitter;
+    double maxJitter;
+    double averageSleep;
+    double averageSpin;
 };
 
 namespace nk {
@@ -53,6 +110,21 @@ namespace nk {
         bool shouldResize(const NkApp* app, uint32_t* newWidth,
                           uint32_t* newHeight);
         void quit(NkApp* app);
+        // Seconds between the last two calls to nk::app::update.
+        double frameTime(const NkApp* app);
+        // Seconds since the last call to nk::app::update.
+        double timeSinceUpdate(const NkApp* app);
+        // Adds the frame time to the accumulator and returns how many fixed
+        // steps to run this frame.
+        uint32_t fixedSteps(const NkApp* app, NkFixedTimestep* timestep);
+        // Fraction of a step left in the accumulator, for interpolating
+        // between the previous and the current simulation state.
+        float fixedStepAlpha(const NkFixedTimestep* timestep);
+        // Sleeps and then spins until targetFrameTime seconds have passed
+        // since the previous call. Does nothing on the web, where the
+        // browser paces frames.
+        void limitFrameRate(NkApp* app, double targetFrameTime);
+        NkFrameLimiterStats frameLimiterStats(const NkApp* app);
 
     } // namespace app
 
@@ -9,6 +9,82 @@ enum class NkImageFormat {
     R8G8B8A8_UNORM
 };
 
+enum class NkVideoFormat {
+    Y4M,
+    PPM,
+    RAW_RGBA
+};
+
+enum class NkBlendMode {
+    ALPHA,
+    ADDITIVE,
+    MULTIPLY,
+    NONE
+};
+
+struct NkCanvasFrameStats {
+    uint32_t quadNum;
+    uint32_t culledQuadNum;
+    uint32_t drawBatchNum;
+    uint32_t vertexBufferNum;
+    uint64_t uploadedBytes;
+    uint32_t atlasImageAddNum;
+    uint32_t atlasImageEvictNum;
+    float atlasOccupancy; // 0.0 to 1.0
+    float beginFrameTime; // Milliseconds
+    float drawTime;       // Between beginFrame and endFrame
+    float endFrameTime;
+    float presentTime;
+    float frameTime;
+    uint32_t skippedFrameNum; // Total since the canvas was created
+};
+
+// Receives the pixels of nk::canvas::readPixelsAsync as R8G8B8A8 rows that
+// start rowPitch bytes apart. The pointer is only valid during the call.
+typedef void (*NkReadPixelsFunc)(void* userData, const void* pixels,
+                                 uint32_t width, uint32_t height,
+                                 uint32_t rowPitch);
+
+struct NkImageTransform {
+    float rotation;
+    float originX, originY;
+    float scaleX, scaleY;
+};
+
+struct NkSpriteDesc {
+    float x, y;
+    float width, height;
+    float frameX, frameY;
+    float frameWidth, frameHeight;
+    uint32_t color;
+};
+
+struct NkSpriteArrays {
+    const float* x;
+    const float* y;
+    const float* width;
+    const float* height;
+    const float* frameX;      // Optional. Null frames draw the whole image
+    const float* frameY;      // Optional
+    const float* frameWidth;  // Optional
+    const float* frameHeight; // Optional
+    const uint32_t* color;    // Optional. Null draws untinted
+};
+
+struct NkRectDesc {
+    float x, y;
+    float width, height;
+    uint32_t color;
+};
+
+struct NkRectArrays {
+    const float* x;
+    const float* y;
+    const float* width;
+    const float* height;
+    const uint32_t* color;
+};
+
 namespace nk {
 
     namespace canvas {
@@ -19,6 +95,10 @@ namespace nk {
         void translate(NkCanvas* canvas, float x, float y);
         void rotate(NkCanvas* canvas, float rad);
         void scale(NkCanvas* canvas, float x, float y);
+        void pushClipRect(NkCanvas* canvas, float x, float y, float width,
+                          float height);
+        void popClipRect(NkCanvas* canvas);
+        void setBlendMode(NkCanvas* canvas, NkBlendMode blendMode);
         void drawLine(NkCanvas* canvas, float x0, float y0, float x1, float y1,
                       float lineWidth, uint32_t color);
         void drawRect(NkCanvas* canvas, float x, float y, float width,
@@ -37,16 +117,50 @@ namespace nk {
                        float height, float frameX, float frameY,
                        float frameWidth, float frameHeight, uint32_t color,
                        NkImage* image);
+        void drawImage(NkCanvas* canvas, float x, float y,
+                       const NkImageTransform& transform, uint32_t color,
+                       NkImage* image);
+        void drawImage(NkCanvas* canvas, float x, float y, float width,
+                       float height, float frameX, float frameY,
+                       float frameWidth, float frameHeight,
+                       const NkImageTransform& transform, uint32_t color,
+                       NkImage* image);
+        void drawImages(NkCanvas* canvas, const NkSpriteDesc* sprites,
+                        uint32_t count, NkImage* image);
+        void drawImages(NkCanvas* canvas, const NkSpriteArrays& sprites,
+                        uint32_t count, NkImage* image);
+        void drawRects(NkCanvas* canvas, const NkRectDesc* rects,
+                       uint32_t count);
+        void drawRects(NkCanvas* canvas, const NkRectArrays& rects,
+                       uint32_t count);
+        void drawPerfOverlay(NkCanvas* canvas, float x, float y);
         void beginFrame(NkCanvas* canvas, float r = 0.0f, float g = 0.0f,
                         float b = 0.0f, float a = 1.0f);
         void beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r = 0.0f,
                         float g = 0.0f, float b = 0.0f, float a = 1.0f);
         void endFrame(NkCanvas* canvas);
         void present(NkCanvas* canvas);
+        const NkCanvasFrameStats& frameStats(NkCanvas* canvas);
+        void setSkipIdenticalFrames(NkCanvas* canvas, bool enabled);
+        bool beginCapture(NkCanvas* canvas, const char* path);
+        void endCapture(NkCanvas* canvas);
         float viewWidth(NkCanvas* canvas);
         float viewHeight(NkCanvas* canvas);
         NkImage* createRenderTargetImage(NkCanvas* canvas, uint32_t width,
                                          uint32_t height);
+        // Copies the render target as drawn by the frames ended so far
+        // without waiting for the GPU. The callback runs from a later
+        // beginFrame once the copy is done. Returns false when the image
+        // isn't a render target or too many reads are in flight.
+        bool readPixelsAsync(NkCanvas* canvas, NkImage* image,
+                             NkReadPixelsFunc callback, void* userData);
+        // Streams frames of a render target to a file from a background
+        // thread. A path of "-" writes to stdout and "|command" pipes the
+        // frames into the command.
+        bool beginVideoCapture(NkCanvas* canvas, const char* path,
+                               NkVideoFormat format, uint32_t frameRate);
+        bool captureVideoFrame(NkCanvas* canvas, NkImage* renderTarget);
+        void endVideoCapture(NkCanvas* canvas);
         NkImage*
         createImage(NkCanvas* canvas, uint32_t width, uint32_t height,
                     const void* pixels,
@@ -108,6 +108,30 @@ enum class NkMouseButton : uint32_t {
     RIGHT = 2
 };
 
+enum class NkInputEventType : uint32_t {
+    KEY_DOWN,
+    KEY_UP,
+    CHAR,
+    MOUSE_MOVE,
+    MOUSE_DOWN,
+    MOUSE_UP,
+    MOUSE_WHEEL
+};
+
+// Only the fields of the event type are valid. timeNs is when the platform
+// received the event, on the same clock as nk::utils::timeNs.
+struct NkInputEvent {
+    NkInputEventType type;
+    uint64_t timeNs;
+    NkKeyCode keyCode;    // KEY_DOWN and KEY_UP
+    uint32_t character;   // CHAR
+    NkMouseButton button; // MOUSE_DOWN and MOUSE_UP
+    float mouseX;         // MOUSE_MOVE, MOUSE_DOWN and MOUSE_UP
+    float mouseY;
+    float wheelDeltaX; // MOUSE_WHEEL
+    float wheelDeltaY;
+};
+
 namespace nk {
 
     namespace hid {
@@ -123,6 +147,16 @@ namespace nk {
         bool cursorVisible(NkHID* hid);
         float mouseX(NkHID* hid);
         float mouseY(NkHID* hid);
+        // Pops the oldest input event. Returns false when there are none.
+        bool pollEvent(NkHID* hid, NkInputEvent* event);
+        // Writes the events applied by every app update to a file.
+        bool startRecording(NkHID* hid, const char* path);
+        void stopRecording(NkHID* hid);
+        // Feeds a recording back one app update at a time instead of the
+        // platform events. replaying returns false once it's over.
+        bool startReplay(NkHID* hid, const char* path);
+        void stopReplay(NkHID* hid);
+        bool replaying(NkHID* hid);
 
     } // namespace hid
 
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace nk {
+
+    namespace profiler {
+
+        bool writeChromeTrace(const char* path);
+        void reset();
+
+    } // namespace profiler
+
+} // namespace nk
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <nk/app.h>
+
+struct NkMemoryTagStats {
+    size_t liveBytes;
+    size_t peakBytes;
+    uint32_t liveAllocationNum;
+    uint64_t totalAllocationNum;
+};
+
+struct NkMemoryStats {
+    NkMemoryTagStats tags[(uint32_t)NkMemoryTag::COUNT];
+    NkMemoryTagStats total;
+};
+
+typedef void (*NkJobFunc)(void* userData, uint32_t jobIndex);
+
+// Number of jobs that haven't finished yet. Zero initialise it, pass it to
+// nk::utils::runJobs and nk::utils::waitJobs until it drops back to zero.
+struct NkJobCounter {
+    std::atomic<uint32_t> pendingJobNum;
+};
+
+namespace nk {
+
+    namespace utils {
+
+        void* frameAlloc(size_t size, size_t alignment = 16);
+        // Monotonic time in nanoseconds.
+        uint64_t timeNs();
+        NkMemoryStats memoryStats();
+        const char* memoryTagName(NkMemoryTag tag);
+        void runJobs(NkJobFunc func, void* userData, uint32_t jobNum,
+                     NkJobCounter* counter);
+        void waitJobs(NkJobCounter* counter);
+        uint32_t jobWorkerNum();
+
+    } // namespace utils
+
+} // namespace nk
@@ -0,0 +1,517 @@
+#include "canvas_capture.h"
+#include "canvas_internal.h"
+#include "utils.h"
+#include <string.h>
+
+static size_t imagePixelDataSize(uint32_t width, uint32_t height,
+                                 NkImageFormat format) {
+    switch (format) {
+    case NkImageFormat::R8G8B8A8_UNORM:
+        return (size_t)width * height * sizeof(uint32_t);
+    }
+    return 0;
+}
+
+bool NkCanvasCapture::begin(const char* path) {
+    if (active()) {
+        end();
+    }
+    file = fopen(path, "wb");
+    if (!file) {
+        NK_LOG("Error: Failed to open %s for writing the canvas capture.",
+               path);
+        return false;
+    }
+    NkCanvasCaptureFileHeader fileHeader = {NK_CANVAS_CAPTURE_MAGIC,
+                                            NK_CANVAS_CAPTURE_VERSION};
+    fwrite(&fileHeader, sizeof(fileHeader), 1, file);
+    nextImageId = 1;
+    runNum = 0;
+    // Quads are only tracked from the next beginFrame so the first captured
+    // frame is complete.
+    recording = false;
+    return true;
+}
+
+void NkCanvasCapture::end() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    nk::utils::memFree(imageKeys, NkMemoryTag::CAPTURE);
+    nk::utils::memFree(imageIds, NkMemoryTag::CAPTURE);
+    nk::utils::memFree(runs, NkMemoryTag::CAPTURE);
+    nk::utils::memFree(frameData, NkMemoryTag::CAPTURE);
+    imageKeys = nullptr;
+    imageIds = nullptr;
+    imageCapacity = 0;
+    imageNum = 0;
+    runs = nullptr;
+    runNum = 0;
+    runMax = 0;
+    frameData = nullptr;
+    frameDataMax = 0;
+    recording = false;
+}
+
+void NkCanvasCapture::beginFrame() {
+    runNum = 0;
+    recording = active();
+}
+
+void NkCanvasCapture::addQuads(NkCanvasBase& base, NkImage* image,
+                               uint32_t quadNum) {
+    if (!recording || quadNum == 0) {
+        return;
+    }
+    uint32_t id = imageId(image);
+    if (runNum > 0 && runs[runNum - 1].run.imageId == id) {
+        runs[runNum - 1].run.quadNum += quadNum;
+        return;
+    }
+    if (runNum + 1 > runMax) {
+        runMax = runMax > 0 ? runMax * 2 : 64;
+        runs = (NkCanvasCaptureRun*)nk::utils::memRealloc(
+            runs, sizeof(NkCanvasCaptureRun) * runMax, NkMemoryTag::CAPTURE);
+        NK_ASSERT_EXIT(runs != nullptr,
+                       "Error: Failed to allocate canvas capture runs.");
+    }
+    NkCanvasTexCoordMapping mapping = base.texCoordMapping(image);
+    NkCanvasCaptureRun& run = runs[runNum++];
+    run.run.imageId = id;
+    run.run.quadNum = quadNum;
+    run.uOffset = mapping.uOffset;
+    run.vOffset = mapping.vOffset;
+    run.uSize = mapping.uScale * nk::img::width(image);
+    run.vSize = mapping.vScale * nk::img::height(image);
+}
+
+void NkCanvasCapture::removeQuads(uint32_t quadNum) {
+    if (!recording || quadNum == 0) {
+        return;
+    }
+    NK_ASSERT(runNum > 0 && runs[runNum - 1].run.quadNum >= quadNum,
+              "Error: Releasing more quads than captured.");
+    runs[runNum - 1].run.quadNum -= quadNum;
+}
+
+void NkCanvasCapture::imageCreated(NkImage* image, const void* pixels,
+                                   NkImageFormat format, bool renderTarget) {
+    if (!active() || !image) {
+        return;
+    }
+    NkCanvasCaptureImage captureImage{};
+    captureImage.imageId = nextImageId++;
+    captureImage.width = (uint32_t)nk::img::width(image);
+    captureImage.height = (uint32_t)nk::img::height(image);
+    captureImage.format = format;
+    captureImage.renderTarget = renderTarget ? 1 : 0;
+    captureImage.pixelDataSize =
+        pixels ? (uint32_t)imagePixelDataSize(captureImage.width,
+                                              captureImage.height, format)
+               : 0;
+    insertImage(image, captureImage.imageId);
+    writeRecord(NkCanvasCaptureRecordType::IMAGE_CREATE, &captureImage,
+                sizeof(captureImage), pixels, captureImage.pixelDataSize);
+}
+
+void NkCanvasCapture::imageDestroyed(NkImage* image) {
+    if (!active()) {
+        return;
+    }
+    uint32_t* slot = findImageSlot(image);
+    if (!slot) {
+        return;
+    }
+    NkCanvasCaptureImageDestroy imageDestroy = {*slot};
+    writeRecord(NkCanvasCaptureRecordType::IMAGE_DESTROY, &imageDestroy,
+                sizeof(imageDestroy));
+    eraseImage(image);
+}
+
+void NkCanvasCapture::writeFrame(NkCanvasBase& base, NkImage* renderTarget,
+                                 const float* clearColor) {
+    if (!recording) {
+        return;
+    }
+    NkCanvasDrawBatchInternalArray& drawBatchArray =
+        base.drawBatchArray[base.currentFrameIndex];
+
+    NkCanvasCaptureFrame frame{};
+    frame.renderTargetId = renderTarget ? imageId(renderTarget, true) : 0;
+    memcpy(frame.clearColor, clearColor, sizeof(frame.clearColor));
+    frame.viewWidth = base.width();
+    frame.viewHeight = base.height();
+    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
+        const NkCanvasDrawBatchInternal& drawBatch =
+            drawBatchArray.drawBatches[index];
+        if (drawBatch.count > 0) {
+            frame.batchNum++;
+            frame.quadNum += drawBatch.count / NK_CANVAS_INDICES_PER_QUAD;
+        }
+    }
+    for (uint32_t index = 0; index < runNum; ++index) {
+        if (runs[index].run.quadNum > 0) {
+            frame.runNum++;
+        }
+    }
+
+    size_t batchesSize = frame.batchNum * sizeof(NkCanvasCaptureBatch);
+    size_t runsSize = frame.runNum * sizeof(NkCanvasCaptureImageRun);
+    size_t verticesSize = (size_t)frame.quadNum *
+                          NK_CANVAS_VERTICES_PER_QUAD *
+                          sizeof(NkCanvasCaptureVertex);
+    size_t frameDataSize = batchesSize + runsSize + verticesSize;
+    if (frameDataSize > frameDataMax) {
+        frameDataMax = nk::utils::max(frameDataSize, frameDataMax * 2);
+        frameData = (uint8_t*)nk::utils::memRealloc(frameData, frameDataMax,
+                                                    NkMemoryTag::CAPTURE);
+        NK_ASSERT_EXIT(frameData != nullptr,
+                       "Error: Failed to allocate canvas capture frame.");
+    }
+
+    NkCanvasCaptureBatch* batches = (NkCanvasCaptureBatch*)frameData;
+    NkCanvasCaptureImageRun* imageRuns =
+        (NkCanvasCaptureImageRun*)(frameData + batchesSize);
+    NkCanvasCaptureVertex* vertices =
+        (NkCanvasCaptureVertex*)(frameData + batchesSize + runsSize);
+
+    for (uint32_t index = 0; index < runNum; ++index) {
+        if (runs[index].run.quadNum > 0) {
+            *imageRuns++ = runs[index].run;
+        }
+    }
+
+    uint32_t runIndex = 0;
+    uint32_t runQuadNum = runNum > 0 ? runs[0].run.quadNum : 0;
+    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
+        const NkCanvasDrawBatchInternal& drawBatch =
+            drawBatchArray.drawBatches[index];
+        if (drawBatch.count == 0) {
+            continue;
+        }
+        uint32_t quadNum = drawBatch.count / NK_CANVAS_INDICES_PER_QUAD;
+        NkCanvasCaptureBatch& batch = *batches++;
+        batch.blendMode = drawBatch.blendMode;
+        batch.scissorEnabled = drawBatch.scissorEnabled ? 1 : 0;
+        batch.scissor[0] = drawBatch.scissor.x0;
+        batch.scissor[1] = drawBatch.scissor.y0;
+        batch.scissor[2] = drawBatch.scissor.x1;
+        batch.scissor[3] = drawBatch.scissor.y1;
+        batch.quadNum = quadNum;
+
+        const NkCanvasVertex* source =
+            &drawBatch.buffer->vertices[drawBatch.bufferOffset];
+        for (uint32_t quad = 0; quad < quadNum; ++quad) {
+            while (runQuadNum == 0 && runIndex + 1 < runNum) {
+                runQuadNum = runs[++runIndex].run.quadNum;
+            }
+            const NkCanvasCaptureRun& run = runs[runIndex];
+            for (uint32_t vertex = 0; vertex < NK_CANVAS_VERTICES_PER_QUAD;
+                 ++vertex, ++source, ++vertices) {
+                vertices->position[0] = source->position[0];
+                vertices->position[1] = source->position[1];
+                vertices->texCoord[0] =
+                    (source->texCoord[0] - run.uOffset) / run.uSize;
+                vertices->texCoord[1] =
+                    (source->texCoord[1] - run.vOffset) / run.vSize;
+                vertices->color = source->color;
+            }
+            runQuadNum--;
+        }
+    }
+
+    writeRecord(NkCanvasCaptureRecordType::FRAME, &frame, sizeof(frame),
+                frameData, (uint32_t)frameDataSize);
+    runNum = 0;
+}
+
+uint32_t NkCanvasCapture::imageId(NkImage* image, bool renderTarget) {
+    uint32_t* slot = findImageSlot(image);
+    if (slot) {
+        return *slot;
+    }
+    // Image created before the capture started. The pixels are gone by now
+    // so it's recorded without them.
+    imageCreated(image, nullptr, NkImageFormat::R8G8B8A8_UNORM, renderTarget);
+    return nextImageId - 1;
+}
+
+static inline uint32_t imageHash(NkImage* image, uint32_t capacity) {
+    uint64_t key = (uint64_t)(uintptr_t)image;
+    return (uint32_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & (capacity - 1);
+}
+
+uint32_t* NkCanvasCapture::findImageSlot(NkImage* image) {
+    if (imageCapacity == 0) {
+        return nullptr;
+    }
+    for (uint32_t index = imageHash(image, imageCapacity);;
+         index = (index + 1) & (imageCapacity - 1)) {
+        if (imageKeys[index] == image) {
+            return &imageIds[index];
+        }
+        if (imageKeys[index] == nullptr) {
+            return nullptr;
+        }
+    }
+}
+
+void NkCanvasCapture::insertImage(NkImage* image, uint32_t id) {
+    if (uint32_t* slot = findImageSlot(image)) {
+        *slot = id;
+        return;
+    }
+    // Keep the load factor under 0.5
+    if ((imageNum + 1) * 2 > imageCapacity) {
+        NkImage** oldKeys = imageKeys;
+        uint32_t* oldIds = imageIds;
+        uint32_t oldCapacity = imageCapacity;
+        imageCapacity = imageCapacity > 0 ? imageCapacity * 2 : 64;
+        imageKeys = (NkImage**)nk::utils::memZeroAlloc(imageCapacity,
+                                                       sizeof(NkImage*),
+                                                       NkMemoryTag::CAPTURE);
+        imageIds = (uint32_t*)nk::utils::memZeroAlloc(imageCapacity,
+                                                      sizeof(uint32_t),
+                                                      NkMemoryTag::CAPTURE);
+        NK_ASSERT_EXIT(imageKeys != nullptr && imageIds != nullptr,
+                       "Error: Failed to allocate canvas capture images.");
+        imageNum = 0;
+        for (uint32_t index = 0; index < oldCapacity; ++index) {
+            if (oldKeys[index]) {
+                insertImage(oldKeys[index], oldIds[index]);
+            }
+        }
+        nk::utils::memFree(oldKeys, NkMemoryTag::CAPTURE);
+        nk::utils::memFree(oldIds, NkMemoryTag::CAPTURE);
+    }
+    uint32_t index = imageHash(image, imageCapacity);
+    while (imageKeys[index] != nullptr) {
+        index = (index + 1) & (imageCapacity - 1);
+    }
+    imageKeys[index] = image;
+    imageIds[index] = id;
+    imageNum++;
+}
+
+void NkCanvasCapture::eraseImage(NkImage* image) {
+    uint32_t* slot = findImageSlot(image);
+    if (!slot) {
+        return;
+    }
+    // Backward shift deletion so lookups never need tombstones.
+    uint32_t hole = (uint32_t)(slot - imageIds);
+    uint32_t index = hole;
+    while (true) {
+        index = (index + 1) & (imageCapacity - 1);
+        if (imageKeys[index] == nullptr) {
+            break;
+        }
+        uint32_t home = imageHash(imageKeys[index], imageCapacity);
+        // Move the entry into the hole if its home slot isn't in (hole, index]
+        bool movable = hole <= index ? (home <= hole || home > index)
+                                     : (home <= hole && home > index);
+        if (movable) {
+            imageKeys[hole] = imageKeys[index];
+            imageIds[hole] = imageIds[index];
+            hole = index;
+        }
+    }
+    imageKeys[hole] = nullptr;
+    imageIds[hole] = 0;
+    imageNum--;
+}
+
+void NkCanvasCapture::writeRecord(NkCanvasCaptureRecordType type,
+                                  const void* data, uint32_t size,
+                                  const void* extraData, uint32_t extraSize) {
+    NkCanvasCaptureRecordHeader recordHeader = {type, size + extraSize};
+    fwrite(&recordHeader, sizeof(recordHeader), 1, file);
+    fwrite(data, size, 1, file);
+    if (extraSize > 0) {
+        fwrite(extraData, extraSize, 1, file);
+    }
+}
+
+bool NkCanvasCaptureReader::open(const char* path) {
+    file = fopen(path, "rb");
+    data = nullptr;
+    dataMax = 0;
+    if (!file) {
+        NK_LOG("Error: Failed to open canvas capture %s.", path);
+        return false;
+    }
+    NkCanvasCaptureFileHeader fileHeader{};
+    if (fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 ||
+        fileHeader.magic != NK_CANVAS_CAPTURE_MAGIC ||
+        fileHeader.version != NK_CANVAS_CAPTURE_VERSION) {
+        NK_LOG("Error: %s is not a valid canvas capture.", path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void NkCanvasCaptureReader::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    nk::utils::memFree(data, NkMemoryTag::CAPTURE);
+    data = nullptr;
+    dataMax = 0;
+}
+
+bool NkCanvasCaptureReader::next() {
+    if (!file || fread(&header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    if (header.size > dataMax) {
+        dataMax = header.size;
+        data = (uint8_t*)nk::utils::memRealloc(data, dataMax,
+                                               NkMemoryTag::CAPTURE);
+        NK_ASSERT_EXIT(data != nullptr,
+                       "Error: Failed to allocate canvas capture record.");
+    }
+    if (fread(data, 1, header.size, file) != header.size) {
+        NK_LOG("Error: Truncated canvas capture record.");
+        return false;
+    }
+
+    size_t expectedSize = 0;
+    switch (header.type) {
+    case NkCanvasCaptureRecordType::IMAGE_CREATE:
+        expectedSize = sizeof(NkCanvasCaptureImage);
+        if (header.size >= expectedSize) {
+            expectedSize += image().pixelDataSize;
+        }
+        break;
+    case NkCanvasCaptureRecordType::IMAGE_DESTROY:
+        expectedSize = sizeof(NkCanvasCaptureImageDestroy);
+        break;
+    case NkCanvasCaptureRecordType::FRAME:
+        expectedSize = sizeof(NkCanvasCaptureFrame);
+        if (header.size >= expectedSize) {
+            expectedSize +=
+                frame().batchNum * sizeof(NkCanvasCaptureBatch) +
+                frame().runNum * sizeof(NkCanvasCaptureImageRun) +
+                (size_t)frame().quadNum * NK_CANVAS_VERTICES_PER_QUAD *
+                    sizeof(NkCanvasCaptureVertex);
+        }
+        break;
+    default:
+        NK_LOG("Error: Unknown canvas capture record type %u.",
+               (uint32_t)header.type);
+        return false;
+    }
+    if (header.size != expectedSize) {
+        NK_LOG("Error: Invalid canvas capture record size.");
+        return false;
+    }
+    if (header.type == NkCanvasCaptureRecordType::FRAME) {
+        // replayFrame walks the batches and the runs together, so both must
+        // cover exactly the quads stored in the record.
+        uint64_t batchQuadNum = 0;
+        for (uint32_t index = 0; index < frame().batchNum; ++index) {
+            batchQuadNum += batches()[index].quadNum;
+        }
+        uint64_t runQuadNum = 0;
+        for (uint32_t index = 0; index < frame().runNum; ++index) {
+            runQuadNum += runs()[index].quadNum;
+        }
+        if (batchQuadNum != frame().quadNum || runQuadNum != frame().quadNum) {
+            NK_LOG("Error: Invalid canvas capture frame quad count.");
+            return false;
+        }
+    }
+    return true;
+}
+
+const NkCanvasCaptureBatch* NkCanvasCaptureReader::batches() const {
+    return (const NkCanvasCaptureBatch*)(data + sizeof(NkCanvasCaptureFrame));
+}
+
+const NkCanvasCaptureImageRun* NkCanvasCaptureReader::runs() const {
+    return (const NkCanvasCaptureImageRun*)(batches() + frame().batchNum);
+}
+
+const NkCanvasCaptureVertex* NkCanvasCaptureReader::vertices() const {
+    return (const NkCanvasCaptureVertex*)(runs() + frame().runNum);
+}
+
+void nk::canvas_capture::replayFrame(NkCanvas* canvas,
+                                     const NkCanvasCaptureReader& reader,
+                                     NkImage* const* images,
+                                     uint32_t imageNum) {
+    NkCanvasBase& base = *nk::canvas_internal::canvasBase(canvas);
+    const NkCanvasCaptureFrame& frame = reader.frame();
+    const NkCanvasCaptureBatch* batches = reader.batches();
+    const NkCanvasCaptureImageRun* runs = reader.runs();
+    const NkCanvasCaptureVertex* source = reader.vertices();
+    NkBlendMode lastBlendMode = base.blendMode;
+
+    uint32_t runIndex = 0;
+    uint32_t runQuadNum = frame.runNum > 0 ? runs[0].quadNum : 0;
+    for (uint32_t index = 0; index < frame.batchNum; ++index) {
+        const NkCanvasCaptureBatch& batch = batches[index];
+        NkCanvasClipMode clipMode = NkCanvasClipMode::NONE;
+        base.blendMode = batch.blendMode;
+        if (batch.scissorEnabled) {
+            // Vertices are already transformed and clipped, the clip stack is
+            // only used to give the batch the same scissor rect.
+            base.clipStack.pushClipRect({batch.scissor[0], batch.scissor[1],
+                                         batch.scissor[2], batch.scissor[3]});
+            clipMode = NkCanvasClipMode::SCISSOR;
+        }
+
+        uint32_t batchQuadNum = batch.quadNum;
+        while (batchQuadNum > 0) {
+            while (runQuadNum == 0 && runIndex + 1 < frame.runNum) {
+                runQuadNum = runs[++runIndex].quadNum;
+            }
+            if (runQuadNum == 0) {
+                break;
+            }
+            uint32_t imageId = runs[runIndex].imageId;
+            NkImage* image = imageId < imageNum && images[imageId]
+                                 ? images[imageId]
+                                 : base.whiteImage;
+            NkCanvasTexCoordMapping mapping = base.texCoordMapping(image);
+            float uSize = mapping.uScale * nk::img::width(image);
+            float vSize = mapping.vScale * nk::img::height(image);
+#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+            uint32_t quadTextureId = base.textureId(image);
+#endif
+
+            uint32_t replayQuadNum = nk::utils::min(batchQuadNum, runQuadNum);
+            while (replayQuadNum > 0) {
+                uint32_t quadNum = 0;
+                NkCanvasVertex* vertices =
+                    base.allocQuads(image, replayQuadNum, &quadNum, clipMode);
+                for (uint32_t vertex = 0;
+                     vertex < quadNum * NK_CANVAS_VERTICES_PER_QUAD;
+                     ++vertex, ++source) {
+                    vertices[vertex].position[0] = source->position[0];
+                    vertices[vertex].position[1] = source->position[1];
+                    vertices[vertex].texCoord[0] =
+                        mapping.uOffset + source->texCoord[0] * uSize;
+                    vertices[vertex].texCoord[1] =
+                        mapping.vOffset + source->texCoord[1] * vSize;
+                    vertices[vertex].color = source->color;
+#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+                    vertices[vertex].textureId = quadTextureId;
+#endif
+                }
+                replayQuadNum -= quadNum;
+                batchQuadNum -= quadNum;
+                runQuadNum -= quadNum;
+            }
+        }
+
+        if (batch.scissorEnabled) {
+            base.clipStack.popClipRect();
+        }
+    }
+
+    base.blendMode = lastBlendMode;
+}
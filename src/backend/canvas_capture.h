@@ -0,0 +1,165 @@
+#pragma once
+
+#include <nk/canvas.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define NK_CANVAS_CAPTURE_MAGIC   0x50434b4e // "NKCP"
+#define NK_CANVAS_CAPTURE_VERSION 1
+
+struct NkCanvasBase;
+
+enum class NkCanvasCaptureRecordType : uint32_t {
+    IMAGE_CREATE,
+    IMAGE_DESTROY,
+    FRAME
+};
+
+// A capture file is a NkCanvasCaptureFileHeader followed by records. Every
+// record starts with a NkCanvasCaptureRecordHeader holding the size of the
+// data that follows it.
+struct NkCanvasCaptureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct NkCanvasCaptureRecordHeader {
+    NkCanvasCaptureRecordType type;
+    uint32_t size;
+};
+
+// IMAGE_CREATE record, followed by pixelDataSize bytes of pixels. Images that
+// were created before the capture started are recorded without pixels.
+struct NkCanvasCaptureImage {
+    uint32_t imageId;
+    uint32_t width;
+    uint32_t height;
+    NkImageFormat format;
+    uint32_t renderTarget;
+    uint32_t pixelDataSize;
+};
+
+// IMAGE_DESTROY record
+struct NkCanvasCaptureImageDestroy {
+    uint32_t imageId;
+};
+
+// FRAME record, followed by batchNum NkCanvasCaptureBatch, runNum
+// NkCanvasCaptureImageRun and quadNum * 4 NkCanvasCaptureVertex.
+struct NkCanvasCaptureFrame {
+    uint32_t renderTargetId; // 0 when drawing to the back buffer
+    float clearColor[4];
+    float viewWidth;
+    float viewHeight;
+    uint32_t batchNum;
+    uint32_t runNum;
+    uint32_t quadNum;
+};
+
+struct NkCanvasCaptureBatch {
+    NkBlendMode blendMode;
+    uint32_t scissorEnabled;
+    float scissor[4]; // x0, y0, x1, y1
+    uint32_t quadNum;
+};
+
+// Consecutive quads sampling the same image. Batches don't carry this on the
+// atlas and bindless backends so it's tracked separately.
+struct NkCanvasCaptureImageRun {
+    uint32_t imageId;
+    uint32_t quadNum;
+};
+
+// Vertex with texture coordinates relative to the image instead of the
+// texture atlas so the stream can be replayed on any backend.
+struct NkCanvasCaptureVertex {
+    float position[2];
+    float texCoord[2];
+    uint32_t color;
+};
+
+struct NkCanvasCaptureRun {
+    NkCanvasCaptureImageRun run;
+    float uOffset, vOffset;
+    float uSize, vSize;
+};
+
+struct NkCanvasCapture {
+
+    bool begin(const char* path);
+    void end();
+    inline bool active() const { return file != nullptr; }
+    void beginFrame();
+    void addQuads(NkCanvasBase& base, NkImage* image, uint32_t quadNum);
+    void removeQuads(uint32_t quadNum);
+    void imageCreated(NkImage* image, const void* pixels,
+                      NkImageFormat format, bool renderTarget);
+    void imageDestroyed(NkImage* image);
+    void writeFrame(NkCanvasBase& base, NkImage* renderTarget,
+                    const float* clearColor);
+
+    uint32_t imageId(NkImage* image, bool renderTarget = false);
+    uint32_t* findImageSlot(NkImage* image);
+    void insertImage(NkImage* image, uint32_t id);
+    void eraseImage(NkImage* image);
+    void writeRecord(NkCanvasCaptureRecordType type, const void* data,
+                     uint32_t size, const void* extraData = nullptr,
+                     uint32_t extraSize = 0);
+
+    FILE* file;
+    // Open addressing map from image to capture id. The canvas is zero
+    // allocated so this can't be a std::unordered_map.
+    NkImage** imageKeys;
+    uint32_t* imageIds;
+    uint32_t imageCapacity;
+    uint32_t imageNum;
+    uint32_t nextImageId;
+    NkCanvasCaptureRun* runs;
+    uint32_t runNum;
+    uint32_t runMax;
+    uint8_t* frameData;
+    size_t frameDataMax;
+    bool recording;
+};
+
+struct NkCanvasCaptureReader {
+
+    bool open(const char* path);
+    void close();
+    bool next();
+    inline NkCanvasCaptureRecordType type() const { return header.type; }
+    inline const NkCanvasCaptureImage& image() const {
+        return *(const NkCanvasCaptureImage*)data;
+    }
+    inline const void* pixels() const {
+        return data + sizeof(NkCanvasCaptureImage);
+    }
+    inline const NkCanvasCaptureImageDestroy& imageDestroy() const {
+        return *(const NkCanvasCaptureImageDestroy*)data;
+    }
+    inline const NkCanvasCaptureFrame& frame() const {
+        return *(const NkCanvasCaptureFrame*)data;
+    }
+    const NkCanvasCaptureBatch* batches() const;
+    const NkCanvasCaptureImageRun* runs() const;
+    const NkCanvasCaptureVertex* vertices() const;
+
+    FILE* file;
+    NkCanvasCaptureRecordHeader header;
+    uint8_t* data;
+    uint32_t dataMax;
+};
+
+namespace nk {
+
+    namespace canvas_capture {
+
+        // Pushes the quads of a FRAME record into the canvas. images is
+        // indexed by the image ids of the capture, missing images are drawn
+        // with the canvas white image.
+        void replayFrame(NkCanvas* canvas, const NkCanvasCaptureReader& reader,
+                         NkImage* const* images, uint32_t imageNum);
+
+    } // namespace canvas_capture
+
+} // namespace nk
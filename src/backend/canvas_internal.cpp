@@ -1,50 +1,244 @@
 #include "canvas_internal.h"
+#include <atomic>
 #include <stdlib.h>
 #include <string.h>
 
-void NkCanvasVertexBufferAllocator::init() {
-    vertexBuffers = (NkCanvasVertexBuffer*)nk::utils::memZeroAlloc(
-        NK_CANVAS_MAX_VERTEX_BUFFERS, sizeof(NkCanvasVertexBuffer));
-    vertexBufferNum = 0;
-    vertexBufferMax = 0;
+static void destroyRingVertexBuffer(NkCanvasVertexBuffer* vertexBuffer) {
+    nk::utils::memFree(vertexBuffer->vertices, NkMemoryTag::VERTEX_BUFFER);
+    nk::canvas_internal::destroyVertexBuffer(vertexBuffer);
+    nk::utils::memFree(vertexBuffer, NkMemoryTag::VERTEX_BUFFER);
 }
 
-void NkCanvasVertexBufferAllocator::destroy() {
-    for (uint32_t index = 0; index < vertexBufferMax; ++index) {
-        nk::utils::memFree(vertexBuffers[index].vertices);
-        nk::canvas_internal::destroyVertexBuffer(&vertexBuffers[index]);
+void NkCanvasVertexRingBuffer::init() {
+    buffer = nullptr;
+    ranges = (NkCanvasVertexRange*)nk::utils::memRealloc(
+        nullptr,
+        sizeof(NkCanvasVertexRange) * NK_CANVAS_VERTEX_RING_BUFFER_INITIAL_RANGES,
+        NkMemoryTag::VERTEX_BUFFER);
+    rangeNum = 0;
+    rangeMax = NK_CANVAS_VERTEX_RING_BUFFER_INITIAL_RANGES;
+    frameRangeFirst = 0;
+    openRangeMax = 0;
+    head = 0;
+    orphans = nullptr;
+    orphanNum = 0;
+    orphanMax = 0;
+    allocatedBufferNum = 0;
+}
+
+void NkCanvasVertexRingBuffer::destroy() {
+    for (uint32_t index = 0; index < orphanNum; ++index) {
+        destroyRingVertexBuffer(orphans[index].buffer);
+    }
+    if (buffer) {
+        destroyRingVertexBuffer(buffer);
+        buffer = nullptr;
+    }
+    nk::utils::memFree(ranges, NkMemoryTag::VERTEX_BUFFER);
+    nk::utils::memFree(orphans, NkMemoryTag::VERTEX_BUFFER);
+}
+
+void NkCanvasVertexRingBuffer::retire(uint64_t completedFenceValue) {
+    closeRange();
+    uint32_t retiredNum = 0;
+    while (retiredNum < rangeNum && ranges[retiredNum].fenceValue != 0 &&
+           ranges[retiredNum].fenceValue <= completedFenceValue) {
+        retiredNum++;
+    }
+    if (retiredNum > 0) {
+        memmove(ranges, &ranges[retiredNum],
+                (rangeNum - retiredNum) * sizeof(NkCanvasVertexRange));
+        rangeNum -= retiredNum;
+    }
+    frameRangeFirst = rangeNum;
+
+    for (uint32_t index = 0; index < orphanNum;) {
+        if (orphans[index].fenceValue != 0 &&
+            orphans[index].fenceValue <= completedFenceValue) {
+            destroyRingVertexBuffer(orphans[index].buffer);
+            orphans[index] = orphans[--orphanNum];
+        } else {
+            ++index;
+        }
+    }
+}
+
+void NkCanvasVertexRingBuffer::fence(uint64_t fenceValue) {
+    closeRange();
+    for (uint32_t index = frameRangeFirst; index < rangeNum; ++index) {
+        ranges[index].fenceValue = fenceValue;
+    }
+    for (uint32_t index = 0; index < orphanNum; ++index) {
+        if (orphans[index].fenceValue == 0) {
+            orphans[index].fenceValue = fenceValue;
+        }
+    }
+    frameRangeFirst = rangeNum;
+}
+
+NkCanvasVertexRange*
+NkCanvasVertexRingBuffer::allocateRange(uint32_t vertexCount) {
+    closeRange();
+    uint32_t offset = 0;
+    uint32_t available = 0;
+    if (!findSpace(vertexCount, &offset, &available)) {
+        grow(vertexCount);
+        offset = 0;
+        available = buffer->vertexCapacity;
+    }
+    addRange({buffer, offset, 0, 0});
+    openRangeMax = nk::utils::min<uint32_t>(
+        available, NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER);
+    return &ranges[rangeNum - 1];
+}
+
+uint32_t
+NkCanvasVertexRingBuffer::rangeSpace(const NkCanvasVertexRange* range) const {
+    return openRangeMax - range->count;
+}
+
+uint32_t NkCanvasVertexRingBuffer::frameRangeNum() const {
+    return rangeNum - frameRangeFirst;
+}
+
+NkCanvasVertexRange& NkCanvasVertexRingBuffer::frameRange(uint32_t index) {
+    return ranges[frameRangeFirst + index];
+}
+
+void NkCanvasVertexRingBuffer::closeRange() {
+    if (openRangeMax == 0) {
+        return;
+    }
+    NkCanvasVertexRange& range = ranges[rangeNum - 1];
+    if (range.count == 0) {
+        rangeNum--;
+    } else if (range.buffer == buffer) {
+        head = range.offset + range.count;
+    }
+    openRangeMax = 0;
+}
+
+bool NkCanvasVertexRingBuffer::findSpace(uint32_t vertexCount,
+                                         uint32_t* outOffset,
+                                         uint32_t* outAvailable) const {
+    if (!buffer) {
+        return false;
+    }
+    uint32_t capacity = buffer->vertexCapacity;
+    const NkCanvasVertexRange* oldest = nullptr;
+    for (uint32_t index = 0; index < rangeNum; ++index) {
+        if (ranges[index].buffer == buffer) {
+            oldest = &ranges[index];
+            break;
+        }
+    }
+    if (!oldest) {
+        *outOffset = 0;
+        *outAvailable = capacity;
+        return vertexCount <= capacity;
+    }
+    // Live vertices span [tail, head) or, once wrapped, [tail, capacity) and
+    // [0, head).
+    uint32_t tail = oldest->offset;
+    if (head > tail) {
+        if (capacity - head >= vertexCount) {
+            *outOffset = head;
+            *outAvailable = capacity - head;
+            return true;
+        }
+        if (tail >= vertexCount) {
+            *outOffset = 0;
+            *outAvailable = tail;
+            return true;
+        }
+        return false;
     }
-    nk::utils::memFree(vertexBuffers);
+    if (tail - head >= vertexCount) {
+        *outOffset = head;
+        *outAvailable = tail - head;
+        return true;
+    }
+    return false;
 }
 
-void NkCanvasVertexBufferAllocator::reset() { vertexBufferNum = 0; }
+void NkCanvasVertexRingBuffer::grow(uint32_t vertexCount) {
+    uint32_t capacity = buffer ? buffer->vertexCapacity * 2
+                               : NK_CANVAS_VERTEX_RING_BUFFER_INITIAL_SIZE;
+    while (capacity < vertexCount) {
+        capacity *= 2;
+    }
+    if (buffer) {
+        bool inUse = false;
+        for (uint32_t index = 0; index < rangeNum && !inUse; ++index) {
+            inUse = ranges[index].buffer == buffer;
+        }
+        if (inUse) {
+            addOrphan(buffer);
+        } else {
+            destroyRingVertexBuffer(buffer);
+        }
+    }
+    buffer = (NkCanvasVertexBuffer*)nk::utils::memZeroAlloc(
+        1, sizeof(NkCanvasVertexBuffer), NkMemoryTag::VERTEX_BUFFER);
+    if (!buffer) {
+        NK_PANIC("Error: Failed to allocate canvas vertex buffer.");
+        return;
+    }
+    buffer->vertices = (NkCanvasVertex*)nk::utils::memRealloc(
+        nullptr, capacity * sizeof(NkCanvasVertex), NkMemoryTag::VERTEX_BUFFER);
+    if (!buffer->vertices) {
+        NK_PANIC("Error: Failed to allocate canvas vertices.");
+        return;
+    }
+    buffer->vertexCapacity = capacity;
+    allocatedBufferNum++;
+    nk::canvas_internal::initVertexBuffer(buffer,
+                                          capacity * sizeof(NkCanvasVertex));
+    head = 0;
+}
 
-NkCanvasVertexBuffer* NkCanvasVertexBufferAllocator::allocate() {
-    NK_ASSERT(vertexBufferNum + 1 < NK_CANVAS_MAX_VERTEX_BUFFERS,
-              "Error: Exceeded the limit of %u vertex buffers per frame.",
-              NK_CANVAS_MAX_VERTEX_BUFFERS);
-    NkCanvasVertexBuffer& vertexBuffer = vertexBuffers[vertexBufferNum++];
-    if (!vertexBuffer.gpuVertexBuffer) {
-        vertexBuffer.vertices = (NkCanvasVertex*)nk::utils::memRealloc(
-            nullptr,
-            NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER * sizeof(NkCanvasVertex));
-        nk::canvas_internal::initVertexBuffer(&vertexBuffer);
+void NkCanvasVertexRingBuffer::addRange(const NkCanvasVertexRange& range) {
+    if (rangeNum + 1 > rangeMax) {
+        rangeMax *= 2;
+        NkCanvasVertexRange* newRanges =
+            (NkCanvasVertexRange*)nk::utils::memRealloc(
+                ranges, sizeof(NkCanvasVertexRange) * rangeMax,
+                NkMemoryTag::VERTEX_BUFFER);
+        if (!newRanges) {
+            NK_PANIC("Error: realloc returned null");
+            return;
+        }
+        ranges = newRanges;
     }
-    vertexBuffer.vertexCount = 0;
-    if (vertexBufferNum > vertexBufferMax) {
-        vertexBufferMax = vertexBufferNum;
+    ranges[rangeNum++] = range;
+}
+
+void NkCanvasVertexRingBuffer::addOrphan(NkCanvasVertexBuffer* orphan) {
+    if (orphanNum + 1 > orphanMax) {
+        orphanMax = orphanMax > 0 ? orphanMax * 2 : 4;
+        NkCanvasVertexRange* newOrphans =
+            (NkCanvasVertexRange*)nk::utils::memRealloc(
+                orphans, sizeof(NkCanvasVertexRange) * orphanMax,
+                NkMemoryTag::VERTEX_BUFFER);
+        if (!newOrphans) {
+            NK_PANIC("Error: realloc returned null");
+            return;
+        }
+        orphans = newOrphans;
     }
-    return &vertexBuffer;
+    orphans[orphanNum++] = {orphan, 0, orphan->vertexCapacity, 0};
 }
 
 void NkCanvasDrawBatchInternalArray::init() {
-    drawBatches = (NkCanvasDrawBatchInternal*)nk::utils::memZeroAlloc(
-        NK_CANVAS_MAX_BATCHES, sizeof(NkCanvasDrawBatchInternal));
+    // Allocated on the first add since most canvases never come close to
+    // NK_CANVAS_MAX_BATCHES.
+    drawBatches = nullptr;
     drawBatchNum = 0;
+    drawBatchMax = 0;
 }
 
 void NkCanvasDrawBatchInternalArray::destroy() {
-    nk::utils::memFree(drawBatches);
+    nk::utils::memFree(drawBatches, NkMemoryTag::DRAW_BATCH);
 }
 
 void NkCanvasDrawBatchInternalArray::reset() { drawBatchNum = 0; }
@@ -54,6 +248,20 @@ void NkCanvasDrawBatchInternalArray::add(
     NK_ASSERT(drawBatchNum + 1 < NK_CANVAS_MAX_BATCHES,
               "Error: Exceeded the limit of %u draw batches per frame.",
               NK_CANVAS_MAX_BATCHES);
+    if (drawBatchNum + 1 > drawBatchMax) {
+        uint32_t newMax =
+            drawBatchMax > 0 ? drawBatchMax * 2 : NK_CANVAS_INITIAL_BATCHES;
+        NkCanvasDrawBatchInternal* newDrawBatches =
+            (NkCanvasDrawBatchInternal*)nk::utils::memRealloc(
+                drawBatches, sizeof(NkCanvasDrawBatchInternal) * newMax,
+                NkMemoryTag::DRAW_BATCH);
+        if (!newDrawBatches) {
+            NK_PANIC("Error: realloc returned null");
+            return;
+        }
+        drawBatches = newDrawBatches;
+        drawBatchMax = newMax;
+    }
     drawBatches[drawBatchNum++] = drawBatch;
 }
 
@@ -64,43 +272,107 @@ NkCanvasDrawBatchInternal* NkCanvasDrawBatchInternalArray::last() {
     return nullptr;
 }
 
-void NkCanvasBase::init(NkCanvas* canvas, float width, float height) {
-    for (uint32_t index = 0; index < NK_CANVAS_MAX_FRAMES; ++index) {
-        vertexBufferAllocator[index].init();
-        drawBatchArray[index].init();
-        nk::canvas_internal::initFrameSyncPoint(&gpuFrameSyncPoint[index]);
+bool NkCanvasReadbackQueue::push(NkCanvas* canvas, NkImage* image,
+                                 NkReadPixelsFunc callback, void* userData) {
+    if (!image || !callback) {
+        return false;
+    }
+    if (readbackNum >= NK_CANVAS_MAX_READBACKS) {
+        NK_LOG("WARNING: Too many pixel reads in flight, the read was "
+               "ignored.");
+        return false;
+    }
+    NkGPUHandle gpuReadback =
+        nk::canvas_internal::beginReadback(canvas, image);
+    if (!gpuReadback) {
+        NK_LOG("Error: Only render target images can be read back.");
+        return false;
     }
-    indices = (uint32_t*)nk::utils::memZeroAlloc(NK_CANVAS_MAX_INDICES,
-                                                 NK_CANVAS_INDEX_SIZE);
+    NkCanvasReadback& readback = readbacks[readbackNum++];
+    readback.gpuReadback = gpuReadback;
+    readback.image = image;
+    readback.callback = callback;
+    readback.userData = userData;
+    readback.width = (uint32_t)nk::img::width(image);
+    readback.height = (uint32_t)nk::img::height(image);
+    return true;
+}
 
-    if (!indices) {
-        NK_PANIC("Error: Failed to allocate resource for canvas.");
-        return;
+void NkCanvasReadbackQueue::poll() {
+    uint32_t completedNum = 0;
+    for (; completedNum < readbackNum; ++completedNum) {
+        NkCanvasReadback& readback = readbacks[completedNum];
+        uint32_t rowPitch = 0;
+        const void* pixels =
+            nk::canvas_internal::mapReadback(readback.gpuReadback, &rowPitch);
+        if (!pixels) {
+            break;
+        }
+        readback.callback(readback.userData, pixels, readback.width,
+                          readback.height, rowPitch);
+        nk::canvas_internal::destroyReadback(readback.gpuReadback);
+    }
+    if (completedNum > 0) {
+        readbackNum -= completedNum;
+        memmove(readbacks, readbacks + completedNum,
+                readbackNum * sizeof(NkCanvasReadback));
+    }
+}
+
+void NkCanvasReadbackQueue::imageDestroyed(NkImage* image) {
+    // The callback never runs for reads of a destroyed image.
+    uint32_t keptNum = 0;
+    for (uint32_t index = 0; index < readbackNum; ++index) {
+        if (readbacks[index].image == image) {
+            nk::canvas_internal::destroyReadback(readbacks[index].gpuReadback);
+        } else {
+            readbacks[keptNum++] = readbacks[index];
+        }
+    }
+    readbackNum = keptNum;
+}
+
+void NkCanvasReadbackQueue::cancel(void* userData) {
+    uint32_t keptNum = 0;
+    for (uint32_t index = 0; index < readbackNum; ++index) {
+        if (readbacks[index].userData == userData) {
+            nk::canvas_internal::destroyReadback(readbacks[index].gpuReadback);
+        } else {
+            readbacks[keptNum++] = readbacks[index];
+        }
+    }
+    readbackNum = keptNum;
+}
+
+void NkCanvasReadbackQueue::destroy() {
+    for (uint32_t index = 0; index < readbackNum; ++index) {
+        nk::canvas_internal::destroyReadback(readbacks[index].gpuReadback);
     }
+    readbackNum = 0;
+}
 
-    for (uint32_t index = 0, vertex = 0; index < NK_CANVAS_MAX_INDICES;
-         index += NK_CANVAS_INDICES_PER_QUAD) {
-        uint32_t v0 = vertex;
-        uint32_t v1 = vertex + 1;
-        uint32_t v2 = vertex + 2;
-        uint32_t v3 = vertex + 3;
-        indices[index + 0] = v0;
-        indices[index + 1] = v1;
-        indices[index + 2] = v2;
-        indices[index + 3] = v0;
-        indices[index + 4] = v2;
-        indices[index + 5] = v3;
-        vertex += 4;
+void NkCanvasBase::init(NkCanvas* canvas, float width, float height) {
+    vertexRingBuffer.init();
+    for (uint32_t index = 0; index < NK_CANVAS_MAX_FRAMES; ++index) {
+        drawBatchArray[index].init();
+        nk::canvas_internal::initFrameSyncPoint(&gpuFrameSyncPoint[index]);
     }
+    indices = nullptr;
+    indexedQuadNum = 0;
+    indicesUploaded = true; // Nothing to upload until the first quad
     nk::canvas_internal::initIndexBuffer(&gpuIndexBuffer);
     whiteImage = nullptr;
     resolution[0] = width;
     resolution[1] = height;
-    currVertexBuffer = nullptr;
+    currVertexRange = nullptr;
     lastFrameIndex = 0;
     currentFrame = 1;
     matrixStack.init();
+    clipStack.init();
+    blendMode = NkBlendMode::ALPHA;
     currDrawBatch = nullptr;
+    frameEnded = true; // Starts the first frame
+    backBufferDrawn = false;
     this->canvas = canvas;
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
     frameTextureAtlas.init(NK_CANVAS_TEXTURE_ATLAS_WIDTH,
@@ -112,10 +384,13 @@ void NkCanvasBase::destroy(NkCanvas* canvas) {
     for (uint32_t index = 0; index < NK_CANVAS_MAX_FRAMES; ++index) {
         nk::canvas_internal::waitFrameSyncPoint(gpuFrameSyncPoint[index],
                                                 gpuFrameWaitValue[index]);
-        vertexBufferAllocator[index].destroy();
         drawBatchArray[index].destroy();
         nk::canvas_internal::destroyFrameSyncPoint(&gpuFrameSyncPoint[index]);
     }
+    vertexRingBuffer.destroy();
+    capture.end();
+    video.end(*this);
+    readbacks.destroy();
 
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
     frameTextureAtlas.destroy();
@@ -123,7 +398,7 @@ void NkCanvasBase::destroy(NkCanvas* canvas) {
 #endif
     nk::canvas_internal::destroyIndexBuffer(&gpuIndexBuffer);
     nk::canvas::destroyImage(canvas, whiteImage);
-    nk::utils::memFree(indices);
+    nk::utils::memFree(indices, NkMemoryTag::INDEX_BUFFER);
 }
 
 void NkCanvasBase::waitCurrentFrame() {
@@ -138,45 +413,109 @@ void NkCanvasBase::signalCurrentFrame() {
     gpuFrameWaitValue[currentFrameIndex] = currentFrame;
 }
 
-NkCanvasVertexBuffer* NkCanvasBase::allocateVertexBuffer() {
-    NkCanvasVertexBuffer* vertexBuffer =
-        vertexBufferAllocator[currentFrameIndex].allocate();
-    vertexBuffer->vertexCount = 0;
-    return vertexBuffer;
+NkCanvasVertexRange* NkCanvasBase::allocateVertexRange() {
+    return vertexRingBuffer.allocateRange(NK_CANVAS_VERTICES_PER_QUAD);
+}
+
+void NkCanvasBase::growIndices(uint32_t indexNum) {
+    uint32_t quadNum = (uint32_t)nk::utils::nextPowerOfTwo(
+        nk::utils::max<uint32_t>(indexNum / NK_CANVAS_INDICES_PER_QUAD,
+                                 NK_CANVAS_MIN_INDEXED_QUADS));
+    quadNum = nk::utils::min<uint32_t>(quadNum, NK_CANVAS_MAX_QUADS_PER_BATCH);
+    if (quadNum <= indexedQuadNum) {
+        return;
+    }
+    size_t indexByteSize =
+        (size_t)quadNum * NK_CANVAS_INDICES_PER_QUAD * NK_CANVAS_INDEX_SIZE;
+    NK_CANVAS_INDEX_TYPE* newIndices =
+        (NK_CANVAS_INDEX_TYPE*)nk::utils::memRealloc(
+            indices, indexByteSize, NkMemoryTag::INDEX_BUFFER);
+    if (!newIndices) {
+        NK_PANIC("Error: Failed to allocate canvas indices.");
+        return;
+    }
+    indices = newIndices;
+    for (uint32_t quad = indexedQuadNum; quad < quadNum; ++quad) {
+        NK_CANVAS_INDEX_TYPE vertex = quad * NK_CANVAS_VERTICES_PER_QUAD;
+        NK_CANVAS_INDEX_TYPE* quadIndices =
+            &indices[quad * NK_CANVAS_INDICES_PER_QUAD];
+        quadIndices[0] = vertex;
+        quadIndices[1] = vertex + 1;
+        quadIndices[2] = vertex + 2;
+        quadIndices[3] = vertex;
+        quadIndices[4] = vertex + 2;
+        quadIndices[5] = vertex + 3;
+    }
+    indexedQuadNum = quadNum;
+    indicesUploaded = false;
 }
 
 const void* NkCanvasBase::indexBufferData() const {
     return (const void*)indices;
 }
 
-void NkCanvasBase::pushQuad(const NkCanvasVertex* vertices, NkImage* image) {
-    NK_ASSERT(image != nullptr, "Error: Passing null image to canvas");
-    if (!currVertexBuffer ||
-        currVertexBuffer->vertexCount + NK_CANVAS_VERTICES_PER_QUAD >
-            NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER) {
-        bool shouldAddNewBatch = currVertexBuffer != nullptr;
-        currVertexBuffer = allocateVertexBuffer();
-        if (shouldAddNewBatch) {
-            currDrawBatch = nextDrawBatch(image);
-        }
-    }
+size_t NkCanvasBase::indexBufferSize() const {
+    return (size_t)indexedQuadNum * NK_CANVAS_INDICES_PER_QUAD *
+           NK_CANVAS_INDEX_SIZE;
+}
 
-    if (!currDrawBatch
-#if !NK_CANVAS_TEXTURE_ATLAS_ENABLED && !NK_CANVAS_BINDLESS_RESOURCE_ENABLED
-        || currDrawBatch->image != image
+// Writes an axis aligned quad transformed by the matrix. Only the first corner
+// goes through the full transform, the others are offsets along the matrix
+// axes.
+static inline void writeQuad(NkCanvasVertex* vertices,
+                             const NkCanvasMatrix& matrix, float x, float y,
+                             float width, float height, float u0, float v0,
+                             float u1, float v1, uint32_t color,
+                             uint32_t textureId) {
+    float x0 = matrix.a * x + matrix.c * y + matrix.tx;
+    float y0 = matrix.b * x + matrix.d * y + matrix.ty;
+    float rightX = matrix.a * width;
+    float rightY = matrix.b * width;
+    float downX = matrix.c * height;
+    float downY = matrix.d * height;
+    vertices[0] = {{x0, y0}, {u0, v0}, color};
+    vertices[1] = {{x0 + downX, y0 + downY}, {u0, v1}, color};
+    vertices[2] = {{x0 + downX + rightX, y0 + downY + rightY}, {u1, v1}, color};
+    vertices[3] = {{x0 + rightX, y0 + rightY}, {u1, v0}, color};
+#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+    vertices[0].textureId = textureId;
+    vertices[1].textureId = textureId;
+    vertices[2].textureId = textureId;
+    vertices[3].textureId = textureId;
 #endif
-    ) {
-        currDrawBatch = nextDrawBatch(image);
-    }
+}
 
-    NkCanvasVertex* writeVertices = allocVertices();
-    memcpy(writeVertices, vertices,
+static inline bool isAxisAligned(const NkCanvasVertex* vertices) {
+    return vertices[0].position[0] == vertices[1].position[0] &&
+           vertices[2].position[0] == vertices[3].position[0] &&
+           vertices[0].position[1] == vertices[3].position[1] &&
+           vertices[1].position[1] == vertices[2].position[1];
+}
+
+void NkCanvasBase::pushQuad(const NkCanvasVertex* vertices, NkImage* image) {
+    NkCanvasVertex quad[NK_CANVAS_VERTICES_PER_QUAD];
+    memcpy(quad, vertices,
            NK_CANVAS_VERTICES_PER_QUAD * sizeof(NkCanvasVertex));
     NkCanvasMatrix& matrix = currentMatrix();
-    matrix.multiply(writeVertices[0].position[0], writeVertices[0].position[1]);
-    matrix.multiply(writeVertices[1].position[0], writeVertices[1].position[1]);
-    matrix.multiply(writeVertices[2].position[0], writeVertices[2].position[1]);
-    matrix.multiply(writeVertices[3].position[0], writeVertices[3].position[1]);
+    matrix.multiply(quad[0].position[0], quad[0].position[1]);
+    matrix.multiply(quad[1].position[0], quad[1].position[1]);
+    matrix.multiply(quad[2].position[0], quad[2].position[1]);
+    matrix.multiply(quad[3].position[0], quad[3].position[1]);
+
+    NkCanvasClipMode quadClipMode = NkCanvasClipMode::NONE;
+    if (clipStack.enabled()) {
+        quadClipMode = isAxisAligned(quad) ? NkCanvasClipMode::CPU
+                                           : NkCanvasClipMode::SCISSOR;
+        if (!clipQuad(quad, quadClipMode)) {
+            NK_CANVAS_STAT_ADD(*this, culledQuadNum, 1);
+            return;
+        }
+    }
+
+    uint32_t quadNum = 0;
+    NkCanvasVertex* writeVertices = allocQuads(image, 1, &quadNum, quadClipMode);
+    memcpy(writeVertices, quad,
+           NK_CANVAS_VERTICES_PER_QUAD * sizeof(NkCanvasVertex));
 
 #if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
     uint32_t textureId = nk::canvas_internal::addImageToTable(canvas, image);
@@ -185,36 +524,184 @@ void NkCanvasBase::pushQuad(const NkCanvasVertex* vertices, NkImage* image) {
     writeVertices[2].textureId = textureId;
     writeVertices[3].textureId = textureId;
 #endif
-
-    currDrawBatch->count += NK_CANVAS_INDICES_PER_QUAD;
 }
 
 NkCanvasDrawBatchInternal*
 NkCanvasBase::addDrawBatch(const NkCanvasDrawBatchInternal& drawBatch) {
+    NK_CANVAS_STAT_ADD(*this, drawBatchNum, 1);
     drawBatchArray[currentFrameIndex].add(drawBatch);
     return drawBatchArray[currentFrameIndex].last();
 }
 
-NkCanvasDrawBatchInternal* NkCanvasBase::nextDrawBatch(NkImage* image) {
+NkCanvasDrawBatchInternal* NkCanvasBase::nextDrawBatch(NkImage* image,
+                                                       bool scissorEnabled) {
     NkCanvasDrawBatchInternal drawBatch{};
     drawBatch.image = image;
-    drawBatch.buffer = currVertexBuffer;
-    drawBatch.bufferOffset = currVertexBuffer->vertexCount;
+    drawBatch.buffer = currVertexRange->buffer;
+    drawBatch.bufferOffset = currVertexRange->offset + currVertexRange->count;
     drawBatch.count = 0;
+    drawBatch.blendMode = blendMode;
+    drawBatch.scissorEnabled = scissorEnabled;
+    if (scissorEnabled) {
+        drawBatch.scissor = clipStack.current();
+    }
 
     return addDrawBatch(drawBatch);
 }
 
-NkCanvasVertex* NkCanvasBase::allocVertices() {
-    NK_ASSERT(currVertexBuffer->vertexCount + NK_CANVAS_VERTICES_PER_QUAD <=
-                  NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER,
-              "Error: Can't allocate more vertices.")
+NkCanvasVertex* NkCanvasBase::allocQuads(NkImage* image, uint32_t quadNum,
+                                         uint32_t* outQuadNum,
+                                         NkCanvasClipMode clipMode) {
+    NK_ASSERT(image != nullptr, "Error: Passing null image to canvas");
+    bool scissorEnabled = clipMode == NkCanvasClipMode::SCISSOR;
+    if (!currVertexRange ||
+        vertexRingBuffer.rangeSpace(currVertexRange) <
+            NK_CANVAS_VERTICES_PER_QUAD) {
+        // A batch can't span two vertex ranges.
+        currVertexRange = allocateVertexRange();
+        currDrawBatch = nextDrawBatch(image, scissorEnabled);
+    }
+
+    if (!currDrawBatch
+#if !NK_CANVAS_TEXTURE_ATLAS_ENABLED && !NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+        || currDrawBatch->image != image
+#endif
+        || currDrawBatch->blendMode != blendMode ||
+        currDrawBatch->scissorEnabled != scissorEnabled ||
+        currDrawBatch->count >= NK_CANVAS_MAX_INDICES ||
+        (scissorEnabled &&
+         memcmp(&currDrawBatch->scissor, &clipStack.current(),
+                sizeof(NkCanvasClipRect)) != 0)) {
+        currDrawBatch = nextDrawBatch(image, scissorEnabled);
+    }
+
+    uint32_t allocQuadNum = nk::utils::min<uint32_t>(
+        quadNum, vertexRingBuffer.rangeSpace(currVertexRange) /
+                     NK_CANVAS_VERTICES_PER_QUAD);
+    allocQuadNum = nk::utils::min<uint32_t>(
+        allocQuadNum, (NK_CANVAS_MAX_INDICES - currDrawBatch->count) /
+                          NK_CANVAS_INDICES_PER_QUAD);
     NkCanvasVertex* vertices =
-        &currVertexBuffer->vertices[currVertexBuffer->vertexCount];
-    currVertexBuffer->vertexCount += NK_CANVAS_VERTICES_PER_QUAD;
+        &currVertexRange->buffer
+             ->vertices[currVertexRange->offset + currVertexRange->count];
+    currVertexRange->count += allocQuadNum * NK_CANVAS_VERTICES_PER_QUAD;
+    currDrawBatch->count += allocQuadNum * NK_CANVAS_INDICES_PER_QUAD;
+    if (currDrawBatch->count > indexedQuadNum * NK_CANVAS_INDICES_PER_QUAD) {
+        growIndices(currDrawBatch->count);
+    }
+    NK_CANVAS_STAT_ADD(*this, quadNum, allocQuadNum);
+    if (capture.recording) {
+        capture.addQuads(*this, image, allocQuadNum);
+    }
+    *outQuadNum = allocQuadNum;
     return vertices;
 }
 
+void NkCanvasBase::releaseQuads(uint32_t quadNum) {
+    currVertexRange->count -= quadNum * NK_CANVAS_VERTICES_PER_QUAD;
+    currDrawBatch->count -= quadNum * NK_CANVAS_INDICES_PER_QUAD;
+#if NK_CANVAS_STATS_ENABLED
+    frameStats.quadNum -= quadNum;
+    frameStats.culledQuadNum += quadNum;
+#endif
+    if (capture.recording) {
+        capture.removeQuads(quadNum);
+    }
+}
+
+NkCanvasClipMode NkCanvasBase::clipMode(const NkCanvasMatrix& matrix) const {
+    if (!clipStack.enabled()) {
+        return NkCanvasClipMode::NONE;
+    }
+    return matrix.b == 0.0f && matrix.c == 0.0f ? NkCanvasClipMode::CPU
+                                                : NkCanvasClipMode::SCISSOR;
+}
+
+bool NkCanvasBase::clipQuad(NkCanvasVertex* vertices,
+                            NkCanvasClipMode clipMode) const {
+    if (clipMode == NkCanvasClipMode::NONE) {
+        return true;
+    }
+    const NkCanvasClipRect& clip = clipStack.current();
+    if (clipMode == NkCanvasClipMode::SCISSOR) {
+        // The scissor does the clipping, only drop quads that are fully out.
+        float minX = vertices[0].position[0];
+        float minY = vertices[0].position[1];
+        float maxX = minX;
+        float maxY = minY;
+        for (uint32_t index = 1; index < NK_CANVAS_VERTICES_PER_QUAD; ++index) {
+            minX = nk::utils::min(minX, vertices[index].position[0]);
+            minY = nk::utils::min(minY, vertices[index].position[1]);
+            maxX = nk::utils::max(maxX, vertices[index].position[0]);
+            maxY = nk::utils::max(maxY, vertices[index].position[1]);
+        }
+        return minX < clip.x1 && maxX > clip.x0 && minY < clip.y1 &&
+               maxY > clip.y0;
+    }
+
+    // Axis aligned quad: vertices 0 and 1 share x, 0 and 3 share y.
+    float x0 = vertices[0].position[0];
+    float y0 = vertices[0].position[1];
+    float x1 = vertices[2].position[0];
+    float y1 = vertices[2].position[1];
+    float clippedX0 = nk::utils::clamp(x0, clip.x0, clip.x1);
+    float clippedY0 = nk::utils::clamp(y0, clip.y0, clip.y1);
+    float clippedX1 = nk::utils::clamp(x1, clip.x0, clip.x1);
+    float clippedY1 = nk::utils::clamp(y1, clip.y0, clip.y1);
+    if (clippedX0 == clippedX1 || clippedY0 == clippedY1) {
+        return false;
+    }
+    if (clippedX0 == x0 && clippedY0 == y0 && clippedX1 == x1 &&
+        clippedY1 == y1) {
+        return true;
+    }
+    float u0 = vertices[0].texCoord[0];
+    float v0 = vertices[0].texCoord[1];
+    float du = (vertices[2].texCoord[0] - u0) / (x1 - x0);
+    float dv = (vertices[2].texCoord[1] - v0) / (y1 - y0);
+    float clippedU0 = u0 + (clippedX0 - x0) * du;
+    float clippedV0 = v0 + (clippedY0 - y0) * dv;
+    float clippedU1 = u0 + (clippedX1 - x0) * du;
+    float clippedV1 = v0 + (clippedY1 - y0) * dv;
+    vertices[0].position[0] = clippedX0;
+    vertices[0].position[1] = clippedY0;
+    vertices[0].texCoord[0] = clippedU0;
+    vertices[0].texCoord[1] = clippedV0;
+    vertices[1].position[0] = clippedX0;
+    vertices[1].position[1] = clippedY1;
+    vertices[1].texCoord[0] = clippedU0;
+    vertices[1].texCoord[1] = clippedV1;
+    vertices[2].position[0] = clippedX1;
+    vertices[2].position[1] = clippedY1;
+    vertices[2].texCoord[0] = clippedU1;
+    vertices[2].texCoord[1] = clippedV1;
+    vertices[3].position[0] = clippedX1;
+    vertices[3].position[1] = clippedY0;
+    vertices[3].texCoord[0] = clippedU1;
+    vertices[3].texCoord[1] = clippedV0;
+    return true;
+}
+
+NkCanvasTexCoordMapping NkCanvasBase::texCoordMapping(NkImage* image) {
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    NkTextureAtlasRect textureRect = frameTextureAtlas.addImage(image);
+    return {(float)textureRect.x / frameTextureAtlas.width,
+            (float)textureRect.y / frameTextureAtlas.height,
+            1.0f / frameTextureAtlas.width, 1.0f / frameTextureAtlas.height};
+#else
+    return {0.0f, 0.0f, 1.0f / nk::img::width(image),
+            1.0f / nk::img::height(image)};
+#endif
+}
+
+uint32_t NkCanvasBase::textureId(NkImage* image) {
+#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+    return nk::canvas_internal::addImageToTable(canvas, image);
+#else
+    return 0;
+#endif
+}
+
 void NkCanvasBase::pushMatrix() { matrixStack.pushMatrix(); }
 
 void NkCanvasBase::popMatrix() { matrixStack.popMatrix(); }
@@ -231,11 +718,44 @@ NkCanvasMatrix& NkCanvasBase::currentMatrix() {
     return matrixStack.currentMatrix();
 }
 
+void NkCanvasBase::pushClipRect(float x, float y, float width, float height) {
+    // The rect goes through the current matrix, rotated rects clip to their
+    // bounds.
+    NkCanvasMatrix& matrix = currentMatrix();
+    float cornersX[] = {x, x + width, x + width, x};
+    float cornersY[] = {y, y, y + height, y + height};
+    NkCanvasClipRect clipRect{};
+    for (uint32_t index = 0; index < 4; ++index) {
+        matrix.multiply(cornersX[index], cornersY[index]);
+    }
+    clipRect.x0 = clipRect.x1 = cornersX[0];
+    clipRect.y0 = clipRect.y1 = cornersY[0];
+    for (uint32_t index = 1; index < 4; ++index) {
+        clipRect.x0 = nk::utils::min(clipRect.x0, cornersX[index]);
+        clipRect.y0 = nk::utils::min(clipRect.y0, cornersY[index]);
+        clipRect.x1 = nk::utils::max(clipRect.x1, cornersX[index]);
+        clipRect.y1 = nk::utils::max(clipRect.y1, cornersY[index]);
+    }
+    clipStack.pushClipRect(clipRect);
+}
+
+void NkCanvasBase::popClipRect() { clipStack.popClipRect(); }
+
+void NkCanvasBase::setBlendMode(NkBlendMode mode) { blendMode = mode; }
+
 float NkCanvasBase::width() const { return resolution[0]; }
 
 float NkCanvasBase::height() const { return resolution[1]; }
 
 void NkCanvasBase::beginFrame(NkCanvas* canvas) {
+    // Every pass, so loops that only draw into render targets log too.
+    nk::utils::flushLog();
+    if (frameEnded) {
+        nk::utils::resetFrameArena(&frameArenaFrame);
+        publishFrameStats();
+        frameEnded = false;
+    }
+    NK_CANVAS_STAT_SCOPED_TIMER(*this, beginFrameTime);
     if (!whiteImage) {
         const uint32_t pixels[] = {0xffffffff, 0xffffffff, 0xffffffff,
                                    0xffffffff};
@@ -250,24 +770,154 @@ void NkCanvasBase::beginFrame(NkCanvas* canvas) {
     nk::canvas_internal::waitFrameSyncPoint(
         gpuFrameSyncPoint[currentFrameIndex],
         gpuFrameWaitValue[currentFrameIndex]);
-    vertexBufferAllocator[currentFrameIndex].reset();
+    vertexRingBuffer.retire(gpuFrameWaitValue[currentFrameIndex]);
+    readbacks.poll();
     drawBatchArray[currentFrameIndex].reset();
     memset(&currDrawBatch, 0, sizeof(currDrawBatch));
+    capture.beginFrame();
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
     frameTextureAtlas.reset();
 #endif
+#if NK_CANVAS_STATS_ENABLED
+    // The draws are timed as one span up to endFrame. Reading the clock in
+    // every draw call cost more than the cheaper draws themselves.
+    recordStartTime = nk::utils::timeNs();
+#endif
+}
+
+void NkCanvasBase::endFrame(NkCanvas* canvas, NkImage* renderTarget) {
+#if NK_CANVAS_STATS_ENABLED
+    frameStats.drawTime +=
+        (float)((double)(nk::utils::timeNs() - recordStartTime) / 1.0e6);
+#endif
+    if (!renderTarget) {
+        backBufferDrawn = true;
+    }
+    if (!renderTarget || !backBufferDrawn) {
+        frameEnded = true;
+    }
+}
+
+void NkCanvasBase::publishFrameStats() {
+#if NK_CANVAS_STATS_ENABLED
+    // Publish at the start of the pass after a back buffer frame so
+    // frameStats() always returns a complete frame, including the endFrame
+    // and present timings and the render target passes drawn before it.
+    uint64_t now = nk::utils::timeNs();
+    if (frameStartTime > 0) {
+        frameStats.frameTime =
+            (float)((double)(now - frameStartTime) / 1.0e6);
+    }
+    frameStartTime = now;
+    frameTimeHistory[frameTimeHistoryIndex] = frameStats.frameTime;
+    frameTimeHistoryIndex =
+        (frameTimeHistoryIndex + 1) % NK_CANVAS_PERF_OVERLAY_HISTORY;
+
+    lastFrameStats = frameStats;
+    lastFrameStats.vertexBufferNum = vertexRingBuffer.allocatedBufferNum;
+    lastFrameStats.skippedFrameNum = skippedFrameNum;
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    uint64_t usedArea = 0;
+    for (uint32_t index = 0; index < frameTextureAtlas.usedRects.rectNum;
+         ++index) {
+        const NkTextureAtlasRect& rect = frameTextureAtlas.usedRects[index];
+        usedArea += (uint64_t)rect.width * rect.height;
+    }
+    lastFrameStats.atlasOccupancy =
+        (float)usedArea /
+        ((float)frameTextureAtlas.width * frameTextureAtlas.height);
+    lastFrameStats.atlasImageAddNum = frameTextureAtlas.addedImageNum;
+    lastFrameStats.atlasImageEvictNum = frameTextureAtlas.evictedImageNum;
+    frameTextureAtlas.addedImageNum = 0;
+    frameTextureAtlas.evictedImageNum = 0;
+#endif
+    memset(&frameStats, 0, sizeof(frameStats));
+#endif
+}
+
+static inline uint64_t hashWord(uint64_t hash, uint64_t word) {
+    hash ^= word * 0x9e3779b97f4a7c15ULL;
+    hash = (hash << 27) | (hash >> 37);
+    return hash * 0xbf58476d1ce4e5b9ULL;
 }
 
-void NkCanvasBase::endFrame(NkCanvas* canvas) {}
+static uint64_t hashData(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = hashWord(hash, word);
+        bytes += sizeof(uint64_t);
+    }
+    if (size > 0) {
+        uint64_t word = 0;
+        memcpy(&word, bytes, size);
+        hash = hashWord(hash, word);
+    }
+    return hash;
+}
+
+uint64_t NkCanvasBase::frameDataHash(const float* clearColor) {
+    NkCanvasDrawBatchInternalArray& drawBatchArray =
+        this->drawBatchArray[currentFrameIndex];
+    uint64_t hash = hashData(0, resolution, sizeof(resolution));
+    hash = hashData(hash, clearColor, sizeof(float) * 4);
+    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
+        const NkCanvasDrawBatchInternal& drawBatch =
+            drawBatchArray.drawBatches[index];
+        if (drawBatch.count == 0) {
+            continue;
+        }
+        // Hash the fields one by one, the struct has padding and the buffer
+        // offset changes every frame.
+        hash = hashWord(hash, (uint64_t)(uintptr_t)drawBatch.image);
+        hash = hashWord(hash, drawBatch.count);
+        hash = hashWord(hash, (uint64_t)drawBatch.blendMode);
+        if (drawBatch.scissorEnabled) {
+            hash = hashData(hash, &drawBatch.scissor,
+                            sizeof(drawBatch.scissor));
+        }
+        uint32_t vertexNum = drawBatch.count / NK_CANVAS_INDICES_PER_QUAD *
+                             NK_CANVAS_VERTICES_PER_QUAD;
+        hash = hashData(hash,
+                        &drawBatch.buffer->vertices[drawBatch.bufferOffset],
+                        vertexNum * sizeof(NkCanvasVertex));
+    }
+    return hash;
+}
+
+bool NkCanvasBase::skipFrame(NkImage* renderTarget, const float* clearColor) {
+    frameSkipped = false;
+    if (!skipIdenticalFrames) {
+        return false;
+    }
+    if (renderTarget) {
+        // The back buffer frame could sample the render target, so it has to
+        // be drawn again.
+        frameHashValid = false;
+        return false;
+    }
+    uint64_t hash = frameDataHash(clearColor);
+    frameSkipped = frameHashValid && hash == frameHash;
+    frameHash = hash;
+    frameHashValid = true;
+    if (frameSkipped) {
+        skippedFrameNum++;
+    }
+    return frameSkipped;
+}
+
+void NkCanvasBase::invalidateFrameHash() { frameHashValid = false; }
 
 void NkCanvasBase::swapFrame(NkCanvas* canvas) {
     lastFrameIndex = currentFrameIndex;
     nk::canvas_internal::signalFrameSyncPoint(
         canvas, gpuFrameSyncPoint[currentFrameIndex], currentFrame);
     gpuFrameWaitValue[currentFrameIndex] = currentFrame;
+    vertexRingBuffer.fence(currentFrame);
     currentFrame++;
     currentFrameIndex = currentFrame % NK_CANVAS_MAX_FRAMES;
-    currVertexBuffer = nullptr;
+    currVertexRange = nullptr;
 }
 
 void NkCanvasBase::drawLine(float x0, float y0, float x1, float y1,
@@ -369,3 +1019,361 @@ void NkCanvasBase::drawImage(float x, float y, float width, float height,
                                   {{x + width, y}, {u1, v0}, color}};
     pushQuad(vertices, image);
 }
+
+void NkCanvasBase::drawImage(float x, float y,
+                             const NkImageTransform& transform, uint32_t color,
+                             NkImage* image) {
+    float width = nk::img::width(image);
+    float height = nk::img::height(image);
+    drawImage(x, y, width, height, 0, 0, width, height, transform, color,
+              image);
+}
+
+void NkCanvasBase::drawImage(float x, float y, float width, float height,
+                             float frameX, float frameY, float frameWidth,
+                             float frameHeight,
+                             const NkImageTransform& transform, uint32_t color,
+                             NkImage* image) {
+    // Same as translate(x, y), rotate, scale on the current matrix but without
+    // touching the matrix stack.
+    NkCanvasMatrix& matrix = currentMatrix();
+    float cr = cosf(transform.rotation);
+    float sr = sinf(transform.rotation);
+    float la = cr * transform.scaleX;
+    float lb = sr * transform.scaleX;
+    float lc = -sr * transform.scaleY;
+    float ld = cr * transform.scaleY;
+    NkCanvasMatrix spriteMatrix;
+    spriteMatrix.a = matrix.a * la + matrix.c * lb;
+    spriteMatrix.b = matrix.b * la + matrix.d * lb;
+    spriteMatrix.c = matrix.a * lc + matrix.c * ld;
+    spriteMatrix.d = matrix.b * lc + matrix.d * ld;
+    spriteMatrix.tx = matrix.a * x + matrix.c * y + matrix.tx;
+    spriteMatrix.ty = matrix.b * x + matrix.d * y + matrix.ty;
+
+    NkCanvasTexCoordMapping mapping = texCoordMapping(image);
+    float u0 = mapping.uOffset + frameX * mapping.uScale;
+    float v0 = mapping.vOffset + frameY * mapping.vScale;
+    float u1 = u0 + frameWidth * mapping.uScale;
+    float v1 = v0 + frameHeight * mapping.vScale;
+    NkCanvasVertex quad[NK_CANVAS_VERTICES_PER_QUAD];
+    writeQuad(quad, spriteMatrix, -transform.originX, -transform.originY,
+              width, height, u0, v0, u1, v1, color, textureId(image));
+    NkCanvasClipMode quadClipMode = clipMode(spriteMatrix);
+    if (!clipQuad(quad, quadClipMode)) {
+        NK_CANVAS_STAT_ADD(*this, culledQuadNum, 1);
+        return;
+    }
+    uint32_t quadNum = 0;
+    NkCanvasVertex* vertices = allocQuads(image, 1, &quadNum, quadClipMode);
+    memcpy(vertices, quad,
+           NK_CANVAS_VERTICES_PER_QUAD * sizeof(NkCanvasVertex));
+}
+
+void NkCanvasBase::drawImages(const NkSpriteDesc* sprites, uint32_t count,
+                              NkImage* image) {
+    NkCanvasTexCoordMapping mapping = texCoordMapping(image);
+    uint32_t spriteTextureId = textureId(image);
+    const NkCanvasMatrix matrix = currentMatrix();
+    NkCanvasClipMode spriteClipMode = clipMode(matrix);
+    for (uint32_t first = 0; first < count;) {
+        uint32_t quadNum = 0;
+        NkCanvasVertex* vertices =
+            allocQuads(image, count - first, &quadNum, spriteClipMode);
+        NkCanvasVertex* writeVertices = vertices;
+        const NkSpriteDesc* batchSprites = &sprites[first];
+        for (uint32_t index = 0; index < quadNum; ++index) {
+            const NkSpriteDesc& sprite = batchSprites[index];
+            float u0 = mapping.uOffset + sprite.frameX * mapping.uScale;
+            float v0 = mapping.vOffset + sprite.frameY * mapping.vScale;
+            float u1 = u0 + sprite.frameWidth * mapping.uScale;
+            float v1 = v0 + sprite.frameHeight * mapping.vScale;
+            writeQuad(writeVertices, matrix, sprite.x, sprite.y, sprite.width,
+                      sprite.height, u0, v0, u1, v1, sprite.color,
+                      spriteTextureId);
+            if (clipQuad(writeVertices, spriteClipMode)) {
+                writeVertices += NK_CANVAS_VERTICES_PER_QUAD;
+            }
+        }
+        releaseQuads(quadNum - (uint32_t)(writeVertices - vertices) /
+                                   NK_CANVAS_VERTICES_PER_QUAD);
+        first += quadNum;
+    }
+}
+
+void NkCanvasBase::drawImages(const NkSpriteArrays& sprites, uint32_t count,
+                              NkImage* image) {
+    NkCanvasTexCoordMapping mapping = texCoordMapping(image);
+    uint32_t spriteTextureId = textureId(image);
+    const NkCanvasMatrix matrix = currentMatrix();
+    NkCanvasClipMode spriteClipMode = clipMode(matrix);
+    bool hasFrames = sprites.frameX && sprites.frameY && sprites.frameWidth &&
+                     sprites.frameHeight;
+    float imageU1 = mapping.uOffset + nk::img::width(image) * mapping.uScale;
+    float imageV1 = mapping.vOffset + nk::img::height(image) * mapping.vScale;
+    for (uint32_t first = 0; first < count;) {
+        uint32_t quadNum = 0;
+        NkCanvasVertex* vertices =
+            allocQuads(image, count - first, &quadNum, spriteClipMode);
+        NkCanvasVertex* writeVertices = vertices;
+        for (uint32_t index = first, last = first + quadNum; index < last;
+             ++index) {
+            float u0 = mapping.uOffset;
+            float v0 = mapping.vOffset;
+            float u1 = imageU1;
+            float v1 = imageV1;
+            if (hasFrames) {
+                u0 += sprites.frameX[index] * mapping.uScale;
+                v0 += sprites.frameY[index] * mapping.vScale;
+                u1 = u0 + sprites.frameWidth[index] * mapping.uScale;
+                v1 = v0 + sprites.frameHeight[index] * mapping.vScale;
+            }
+            uint32_t color = sprites.color ? sprites.color[index] : 0xffffffff;
+            writeQuad(writeVertices, matrix, sprites.x[index],
+                      sprites.y[index], sprites.width[index],
+                      sprites.height[index], u0, v0, u1, v1, color,
+                      spriteTextureId);
+            if (clipQuad(writeVertices, spriteClipMode)) {
+                writeVertices += NK_CANVAS_VERTICES_PER_QUAD;
+            }
+        }
+        releaseQuads(quadNum - (uint32_t)(writeVertices - vertices) /
+                                   NK_CANVAS_VERTICES_PER_QUAD);
+        first += quadNum;
+    }
+}
+
+void NkCanvasBase::drawRects(const NkRectDesc* rects, uint32_t count) {
+    NkCanvasTexCoordMapping mapping = texCoordMapping(whiteImage);
+    uint32_t rectTextureId = textureId(whiteImage);
+    const NkCanvasMatrix matrix = currentMatrix();
+    NkCanvasClipMode rectClipMode = clipMode(matrix);
+    float u0 = mapping.uOffset;
+    float v0 = mapping.vOffset;
+    float u1 = u0 + NK_CANVAS_WHITE_IMAGE_WIDTH * mapping.uScale;
+    float v1 = v0 + NK_CANVAS_WHITE_IMAGE_HEIGHT * mapping.vScale;
+    for (uint32_t first = 0; first < count;) {
+        uint32_t quadNum = 0;
+        NkCanvasVertex* vertices =
+            allocQuads(whiteImage, count - first, &quadNum, rectClipMode);
+        NkCanvasVertex* writeVertices = vertices;
+        const NkRectDesc* batchRects = &rects[first];
+        for (uint32_t index = 0; index < quadNum; ++index) {
+            const NkRectDesc& rect = batchRects[index];
+            writeQuad(writeVertices, matrix, rect.x, rect.y, rect.width,
+                      rect.height, u0, v0, u1, v1, rect.color, rectTextureId);
+            if (clipQuad(writeVertices, rectClipMode)) {
+                writeVertices += NK_CANVAS_VERTICES_PER_QUAD;
+            }
+        }
+        releaseQuads(quadNum - (uint32_t)(writeVertices - vertices) /
+                                   NK_CANVAS_VERTICES_PER_QUAD);
+        first += quadNum;
+    }
+}
+
+void NkCanvasBase::drawRects(const NkRectArrays& rects, uint32_t count) {
+    NkCanvasTexCoordMapping mapping = texCoordMapping(whiteImage);
+    uint32_t rectTextureId = textureId(whiteImage);
+    const NkCanvasMatrix matrix = currentMatrix();
+    NkCanvasClipMode rectClipMode = clipMode(matrix);
+    float u0 = mapping.uOffset;
+    float v0 = mapping.vOffset;
+    float u1 = u0 + NK_CANVAS_WHITE_IMAGE_WIDTH * mapping.uScale;
+    float v1 = v0 + NK_CANVAS_WHITE_IMAGE_HEIGHT * mapping.vScale;
+    for (uint32_t first = 0; first < count;) {
+        uint32_t quadNum = 0;
+        NkCanvasVertex* vertices =
+            allocQuads(whiteImage, count - first, &quadNum, rectClipMode);
+        NkCanvasVertex* writeVertices = vertices;
+        for (uint32_t index = first, last = first + quadNum; index < last;
+             ++index) {
+            writeQuad(writeVertices, matrix, rects.x[index], rects.y[index],
+                      rects.width[index], rects.height[index], u0, v0, u1, v1,
+                      rects.color[index], rectTextureId);
+            if (clipQuad(writeVertices, rectClipMode)) {
+                writeVertices += NK_CANVAS_VERTICES_PER_QUAD;
+            }
+        }
+        releaseQuads(quadNum - (uint32_t)(writeVertices - vertices) /
+                                   NK_CANVAS_VERTICES_PER_QUAD);
+        first += quadNum;
+    }
+}
+
+#if NK_CANVAS_STATS_ENABLED
+// 3x5 pixel glyphs, one row per 3 bits starting from the top row. Only the
+// characters used by the performance overlay are defined.
+struct NkCanvasPerfOverlayGlyph {
+    char character;
+    uint16_t bits;
+};
+
+static const NkCanvasPerfOverlayGlyph perfOverlayGlyphs[] = {
+    {'0', 0b111'101'101'101'111},
+    {'1', 0b010'110'010'010'111},
+    {'2', 0b111'001'111'100'111},
+    {'3', 0b111'001'111'001'111},
+    {'4', 0b101'101'111'001'001},
+    {'5', 0b111'100'111'001'111},
+    {'6', 0b111'100'111'101'111},
+    {'7', 0b111'001'001'001'001},
+    {'8', 0b111'101'111'101'111},
+    {'9', 0b111'101'111'001'111},
+    {'.', 0b000'000'000'000'010},
+    {'%', 0b101'001'010'100'101},
+    {'A', 0b010'101'111'101'101},
+    {'B', 0b110'101'110'101'110},
+    {'C', 0b011'100'100'100'011},
+    {'D', 0b110'101'101'101'110},
+    {'H', 0b101'101'111'101'101},
+    {'L', 0b100'100'100'100'111},
+    {'M', 0b101'111'111'101'101},
+    {'Q', 0b010'101'101'110'011},
+    {'S', 0b011'100'010'001'110},
+    {'T', 0b111'010'010'010'010},
+    {'U', 0b101'101'101'101'111},
+};
+
+static uint16_t perfOverlayGlyph(char c) {
+    for (const NkCanvasPerfOverlayGlyph& glyph : perfOverlayGlyphs) {
+        if (glyph.character == c) {
+            return glyph.bits;
+        }
+    }
+    return 0;
+}
+
+static uint32_t addPerfOverlayText(NkRectDesc* rects, uint32_t rectNum,
+                                   float x, float y, const char* text,
+                                   uint32_t color) {
+    const float pixelSize = NK_CANVAS_PERF_OVERLAY_PIXEL_SIZE;
+    for (; *text; ++text, x += pixelSize * 4.0f) {
+        uint16_t glyph = perfOverlayGlyph(*text);
+        for (uint32_t row = 0; row < 5; ++row) {
+            uint32_t bits = (glyph >> ((4 - row) * 3)) & 0b111;
+            // Merge horizontal runs of pixels into a single rect.
+            for (uint32_t col = 0; col < 3;) {
+                if (!(bits & (0b100 >> col))) {
+                    col++;
+                    continue;
+                }
+                uint32_t runStart = col;
+                while (col < 3 && (bits & (0b100 >> col))) {
+                    col++;
+                }
+                if (rectNum < NK_CANVAS_PERF_OVERLAY_MAX_RECTS) {
+                    rects[rectNum++] = {x + runStart * pixelSize,
+                                        y + row * pixelSize,
+                                        (col - runStart) * pixelSize,
+                                        pixelSize, color};
+                }
+            }
+        }
+    }
+    return rectNum;
+}
+
+void NkCanvasBase::drawPerfOverlay(float x, float y) {
+    const float pixelSize = NK_CANVAS_PERF_OVERLAY_PIXEL_SIZE;
+    const float padding = pixelSize * 2.0f;
+    const float lineHeight = pixelSize * 7.0f;
+    const float graphWidth = (float)NK_CANVAS_PERF_OVERLAY_HISTORY;
+    const float graphHeight = NK_CANVAS_PERF_OVERLAY_GRAPH_HEIGHT;
+    const uint32_t textColor = NK_COLOR_RGB_UINT(0xff, 0xff, 0xff);
+    const NkCanvasFrameStats& stats = lastFrameStats;
+
+    // Too large for the stack, drawRects copies the rects out right away.
+    NkRectDesc* rects = (NkRectDesc*)nk::utils::frameAlloc(
+        NK_CANVAS_PERF_OVERLAY_MAX_RECTS * sizeof(NkRectDesc),
+        alignof(NkRectDesc));
+    uint32_t rectNum = 0;
+    rects[rectNum++] = {x, y, graphWidth + padding * 2.0f,
+                        lineHeight * 4.0f + graphHeight + padding * 3.0f,
+                        NK_COLOR_RGBA_UINT(0x00, 0x00, 0x00, 0xc0)};
+
+    float textX = x + padding;
+    float textY = y + padding;
+    rectNum = addPerfOverlayText(
+        rects, rectNum, textX, textY,
+        nk::utils::tempString("MS %.2f", stats.frameTime), textColor);
+    textY += lineHeight;
+    rectNum = addPerfOverlayText(
+        rects, rectNum, textX, textY,
+        nk::utils::tempString("BATCH %u", stats.drawBatchNum), textColor);
+    textY += lineHeight;
+    rectNum = addPerfOverlayText(
+        rects, rectNum, textX, textY,
+        nk::utils::tempString("QUAD %u", stats.quadNum), textColor);
+    textY += lineHeight;
+    rectNum = addPerfOverlayText(
+        rects, rectNum, textX, textY,
+        nk::utils::tempString("ATLAS %u%%",
+                              (uint32_t)(stats.atlasOccupancy * 100.0f)),
+        textColor);
+    textY += lineHeight;
+
+    // Frame time graph, one bar per back buffer frame with the oldest on the
+    // left. Bars are scaled so the full height is two 60Hz frames.
+    float graphX = x + padding;
+    float graphY = textY + padding;
+    float graphBottom = graphY + graphHeight;
+    for (uint32_t index = 0; index < NK_CANVAS_PERF_OVERLAY_HISTORY &&
+                             rectNum < NK_CANVAS_PERF_OVERLAY_MAX_RECTS;
+         ++index) {
+        float frameTime =
+            frameTimeHistory[(frameTimeHistoryIndex + index) %
+                             NK_CANVAS_PERF_OVERLAY_HISTORY];
+        float barHeight = nk::utils::min(
+            frameTime / (NK_CANVAS_PERF_OVERLAY_TARGET_MS * 2.0f), 1.0f) *
+                          graphHeight;
+        uint32_t barColor =
+            frameTime <= NK_CANVAS_PERF_OVERLAY_TARGET_MS
+                ? NK_COLOR_RGB_UINT(0x00, 0xff, 0x00)
+                : (frameTime <= NK_CANVAS_PERF_OVERLAY_TARGET_MS * 2.0f
+                       ? NK_COLOR_RGB_UINT(0xff, 0xff, 0x00)
+                       : NK_COLOR_RGB_UINT(0xff, 0x00, 0x00));
+        rects[rectNum++] = {graphX + index, graphBottom - barHeight, 1.0f,
+                            barHeight, barColor};
+    }
+    if (rectNum < NK_CANVAS_PERF_OVERLAY_MAX_RECTS) {
+        rects[rectNum++] = {graphX, graphY + graphHeight * 0.5f, graphWidth,
+                            1.0f, NK_COLOR_RGBA_UINT(0xff, 0xff, 0xff, 0x80)};
+    }
+
+    // Draw in screen space with the default state so the whole overlay ends
+    // up in a single draw batch.
+    NkCanvasMatrix lastMatrix = matrixStack.current;
+    uint32_t lastClipDepth = clipStack.depth;
+    NkBlendMode lastBlendMode = blendMode;
+    matrixStack.loadIdentity();
+    clipStack.depth = 0;
+    blendMode = NkBlendMode::ALPHA;
+    drawRects(rects, rectNum);
+    matrixStack.current = lastMatrix;
+    clipStack.depth = lastClipDepth;
+    blendMode = lastBlendMode;
+}
+#else
+void NkCanvasBase::drawPerfOverlay(float x, float y) {
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true, std::memory_order_relaxed)) {
+        NK_LOG("WARNING: Performance overlay needs frame stats. Build with "
+               "the NK_CANVAS_STATS CMake option to draw it.");
+    }
+}
+#endif
+
+NkCanvasScissorRect
+nk::canvas_internal::scissorRect(const NkCanvasDrawBatchInternal& drawBatch,
+                                 float viewWidth, float viewHeight) {
+    if (!drawBatch.scissorEnabled) {
+        return {0, 0, (uint32_t)viewWidth, (uint32_t)viewHeight};
+    }
+    float x0 = nk::utils::clamp(floorf(drawBatch.scissor.x0), 0.0f, viewWidth);
+    float y0 = nk::utils::clamp(floorf(drawBatch.scissor.y0), 0.0f, viewHeight);
+    float x1 = nk::utils::clamp(ceilf(drawBatch.scissor.x1), x0, viewWidth);
+    float y1 = nk::utils::clamp(ceilf(drawBatch.scissor.y1), y0, viewHeight);
+    return {(uint32_t)x0, (uint32_t)y0, (uint32_t)(x1 - x0),
+            (uint32_t)(y1 - y0)};
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "canvas_capture.h"
+#include "canvas_video.h"
 #include "texture_packer.h"
 #include "utils.h"
 #include <math.h>
@@ -11,33 +13,88 @@
     (1 << 16) // Seems to be a good balance
 #define NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER                                    \
     (NK_CANVAS_MAX_DRAW_ELEMENTS_PER_BUFFER * NK_CANVAS_VERTICES_PER_QUAD)
-#define NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER_BYTE_SIZE                          \
-    (NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER * sizeof(NkCanvasVertex))
-#define NK_CANVAS_MAX_VERTEX_BUFFERS (1 << 7)
+#define NK_CANVAS_VERTEX_RING_BUFFER_INITIAL_SIZE                              \
+    ((1 << 12) * NK_CANVAS_VERTICES_PER_QUAD)
+#define NK_CANVAS_VERTEX_RING_BUFFER_INITIAL_RANGES 16
+#if NK_CANVAS_16BIT_INDICES_ENABLED
+// Batches are split so that their vertices can be addressed with 16 bits.
+#define NK_CANVAS_INDEX_TYPE          uint16_t
+#define NK_CANVAS_MAX_QUADS_PER_BATCH (1 << 14)
+#else
+#define NK_CANVAS_INDEX_TYPE          uint32_t
+#define NK_CANVAS_MAX_QUADS_PER_BATCH NK_CANVAS_MAX_DRAW_ELEMENTS_PER_BUFFER
+#endif
 #define NK_CANVAS_MAX_INDICES                                                  \
-    (NK_CANVAS_MAX_DRAW_ELEMENTS_PER_BUFFER * NK_CANVAS_INDICES_PER_QUAD)
-#define NK_CANVAS_INDEX_TYPE uint32_t
+    (NK_CANVAS_MAX_QUADS_PER_BATCH * NK_CANVAS_INDICES_PER_QUAD)
 #define NK_CANVAS_INDEX_SIZE (sizeof(NK_CANVAS_INDEX_TYPE))
 #define NK_CANVAS_MAX_INDICES_BYTE_SIZE                                        \
     (NK_CANVAS_MAX_INDICES * NK_CANVAS_INDEX_SIZE)
-#define NK_CANVAS_MAX_BATCHES            (1 << 12)
-#define NK_CANVAS_MAX_MATRIX_STACK_DEPTH (1 << 10)
-#define NK_CANVAS_MAX_FRAMES             2
-#define NK_CANVAS_WHITE_IMAGE_WIDTH      2
-#define NK_CANVAS_WHITE_IMAGE_HEIGHT     2
+#define NK_CANVAS_MAX_BATCHES               (1 << 12)
+#define NK_CANVAS_INITIAL_BATCHES           (1 << 6)
+#define NK_CANVAS_MIN_INDEXED_QUADS         (1 << 10)
+#define NK_CANVAS_MAX_MATRIX_STACK_DEPTH    (1 << 10)
+#define NK_CANVAS_MAX_CLIP_STACK_DEPTH      (1 << 6)
+#define NK_CANVAS_MAX_FRAMES                2
+#define NK_CANVAS_WHITE_IMAGE_WIDTH         2
+#define NK_CANVAS_WHITE_IMAGE_HEIGHT        2
+#define NK_CANVAS_BLEND_MODE_COUNT          4
+#define NK_CANVAS_PERF_OVERLAY_HISTORY      128
+#define NK_CANVAS_PERF_OVERLAY_MAX_RECTS    1024
+#define NK_CANVAS_PERF_OVERLAY_PIXEL_SIZE   2.0f
+#define NK_CANVAS_PERF_OVERLAY_GRAPH_HEIGHT 48.0f
+#define NK_CANVAS_PERF_OVERLAY_TARGET_MS    16.67f
+#define NK_CANVAS_MAX_READBACKS             16
 
 #ifdef NK_CANVAS_BINDLESS_RESOURCE_ENABLED
 #undef NK_CANVAS_BINDLESS_RESOURCE_ENABLED
 #define NK_CANVAS_BINDLESS_RESOURCE_ENABLED 1
 #endif
 
+#ifdef NK_CANVAS_STATS_ENABLED
+#undef NK_CANVAS_STATS_ENABLED
+#define NK_CANVAS_STATS_ENABLED 1
+#endif
+
+#if NK_CANVAS_STATS_ENABLED
+struct NkCanvasStatTimer final {
+    NkCanvasStatTimer(float* target)
+        : target(target), start(nk::utils::timeNs()) {}
+    ~NkCanvasStatTimer() {
+        *target += (float)((double)(nk::utils::timeNs() - start) / 1.0e6);
+    }
+    float* target;
+    uint64_t start;
+};
+#define NK_CANVAS_STAT_ADD(base, field, value) (base).frameStats.field += (value)
+#define NK_CANVAS_STAT_SCOPED_TIMER(base, field)                               \
+    NkCanvasStatTimer _canvasStatTimer(&(base).frameStats.field)
+#else
+#define NK_CANVAS_STAT_ADD(base, field, value)
+#define NK_CANVAS_STAT_SCOPED_TIMER(base, field)
+#endif
+
 typedef void* NkGPUHandle;
 
+struct NkCanvasClipRect {
+    float x0, y0, x1, y1;
+};
+
+struct NkCanvasScissorRect {
+    uint32_t x, y, width, height;
+};
+
+// NONE: no clip rect. CPU: axis aligned quads are clipped before they are
+// written. SCISSOR: everything else, quads are clipped by the batch scissor.
+enum class NkCanvasClipMode { NONE, CPU, SCISSOR };
+
 struct NkCanvasDrawBatchInternal {
     NkImage* image;
     struct NkCanvasVertexBuffer* buffer;
     uint32_t bufferOffset;
     uint32_t count;
+    bool scissorEnabled;
+    NkCanvasClipRect scissor;
+    NkBlendMode blendMode;
 };
 
 struct NkCanvasVertex {
@@ -49,12 +106,27 @@ struct NkCanvasVertex {
 #endif
 };
 
+// Maps image pixel coordinates to texture coordinates: u = uOffset + x * uScale
+struct NkCanvasTexCoordMapping {
+    float uOffset, vOffset;
+    float uScale, vScale;
+};
+
 struct NkCanvasVertexBuffer {
     void* gpuVertexBuffer;
-    uint32_t vertexCount;
+    uint32_t vertexCapacity;
     NkCanvasVertex* vertices;
 };
 
+// Contiguous run of vertices sub-allocated from a vertex buffer. The range is
+// in flight until the GPU signals fenceValue (0 while still being recorded).
+struct NkCanvasVertexRange {
+    NkCanvasVertexBuffer* buffer;
+    uint32_t offset;
+    uint32_t count;
+    uint64_t fenceValue;
+};
+
 struct NkCanvasDrawBatchInternalArray {
 
     void init();
@@ -65,20 +137,43 @@ struct NkCanvasDrawBatchInternalArray {
 
     NkCanvasDrawBatchInternal* drawBatches;
     uint32_t drawBatchNum;
+    uint32_t drawBatchMax;
 };
 
-struct NkCanvasVertexBufferAllocator {
+struct NkCanvasVertexRingBuffer {
 
     void init();
     void destroy();
-    void reset();
-    NkCanvasVertexBuffer* allocate();
+    void retire(uint64_t completedFenceValue);
+    void fence(uint64_t fenceValue);
+    NkCanvasVertexRange* allocateRange(uint32_t vertexCount);
+    uint32_t rangeSpace(const NkCanvasVertexRange* range) const;
+    uint32_t frameRangeNum() const;
+    NkCanvasVertexRange& frameRange(uint32_t index);
 
-    uint32_t vertexBufferNum;
+    NkCanvasVertexBuffer* buffer;
+    uint32_t allocatedBufferNum;
 
 private:
-    NkCanvasVertexBuffer* vertexBuffers;
-    uint32_t vertexBufferMax;
+    void closeRange();
+    bool findSpace(uint32_t vertexCount, uint32_t* outOffset,
+                   uint32_t* outAvailable) const;
+    void grow(uint32_t vertexCount);
+    void addRange(const NkCanvasVertexRange& range);
+    void addOrphan(NkCanvasVertexBuffer* orphan);
+
+    // FIFO of ranges still referenced by the GPU. Ranges written during the
+    // current frame start at frameRangeFirst.
+    NkCanvasVertexRange* ranges;
+    uint32_t rangeNum;
+    uint32_t rangeMax;
+    uint32_t frameRangeFirst;
+    uint32_t openRangeMax;
+    uint32_t head;
+    // Buffers replaced by a larger one, kept alive until their last fence.
+    NkCanvasVertexRange* orphans;
+    uint32_t orphanNum;
+    uint32_t orphanMax;
 };
 
 struct NkCanvasMatrix {
@@ -166,19 +261,83 @@ struct NkCanvasMatrixStack {
     uint32_t depth;
 };
 
+struct NkCanvasClipStack {
+
+    inline void init() { depth = 0; }
+    inline void pushClipRect(const NkCanvasClipRect& rect) {
+        if (depth < NK_CANVAS_MAX_CLIP_STACK_DEPTH) {
+            NkCanvasClipRect clipRect = rect;
+            if (depth > 0) {
+                const NkCanvasClipRect& parent = rects[depth - 1];
+                clipRect.x0 = nk::utils::max(clipRect.x0, parent.x0);
+                clipRect.y0 = nk::utils::max(clipRect.y0, parent.y0);
+                clipRect.x1 = nk::utils::min(clipRect.x1, parent.x1);
+                clipRect.y1 = nk::utils::min(clipRect.y1, parent.y1);
+            }
+            clipRect.x1 = nk::utils::max(clipRect.x0, clipRect.x1);
+            clipRect.y1 = nk::utils::max(clipRect.y0, clipRect.y1);
+            rects[depth++] = clipRect;
+        }
+    }
+    inline void popClipRect() {
+        if (depth > 0) {
+            depth--;
+        }
+    }
+    inline bool enabled() const { return depth > 0; }
+    inline const NkCanvasClipRect& current() const { return rects[depth - 1]; }
+
+    NkCanvasClipRect rects[NK_CANVAS_MAX_CLIP_STACK_DEPTH];
+    uint32_t depth;
+};
+
+struct NkCanvasReadback {
+    NkGPUHandle gpuReadback;
+    NkImage* image;
+    NkReadPixelsFunc callback;
+    void* userData;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Render target reads waiting for the GPU. They complete in the order they
+// were requested so frames read back every frame stay in sequence.
+struct NkCanvasReadbackQueue {
+
+    bool push(NkCanvas* canvas, NkImage* image, NkReadPixelsFunc callback,
+              void* userData);
+    void poll();
+    void imageDestroyed(NkImage* image);
+    void cancel(void* userData);
+    void destroy();
+
+    NkCanvasReadback readbacks[NK_CANVAS_MAX_READBACKS];
+    uint32_t readbackNum;
+};
+
 struct NkCanvasBase {
 
     void init(NkCanvas* canvas, float width, float height);
     void destroy(NkCanvas* canvas);
     void waitCurrentFrame();
     void signalCurrentFrame();
-    NkCanvasVertexBuffer* allocateVertexBuffer();
+    NkCanvasVertexRange* allocateVertexRange();
+    void growIndices(uint32_t indexNum);
     const void* indexBufferData() const;
+    size_t indexBufferSize() const;
     void pushQuad(const NkCanvasVertex* vertices, NkImage* image);
     NkCanvasDrawBatchInternal*
     addDrawBatch(const NkCanvasDrawBatchInternal& drawBatch);
-    NkCanvasDrawBatchInternal* nextDrawBatch(NkImage* image);
-    NkCanvasVertex* allocVertices();
+    NkCanvasDrawBatchInternal* nextDrawBatch(NkImage* image,
+                                             bool scissorEnabled);
+    NkCanvasVertex* allocQuads(NkImage* image, uint32_t quadNum,
+                               uint32_t* outQuadNum,
+                               NkCanvasClipMode clipMode);
+    void releaseQuads(uint32_t quadNum);
+    NkCanvasClipMode clipMode(const NkCanvasMatrix& matrix) const;
+    bool clipQuad(NkCanvasVertex* vertices, NkCanvasClipMode clipMode) const;
+    NkCanvasTexCoordMapping texCoordMapping(NkImage* image);
+    uint32_t textureId(NkImage* image);
     float width() const;
     float height() const;
     void pushMatrix();
@@ -188,8 +347,15 @@ struct NkCanvasBase {
     void scale(float x, float y);
     void loadIdentity();
     NkCanvasMatrix& currentMatrix();
+    void pushClipRect(float x, float y, float width, float height);
+    void popClipRect();
+    void setBlendMode(NkBlendMode mode);
+    void publishFrameStats();
+    uint64_t frameDataHash(const float* clearColor);
+    bool skipFrame(NkImage* renderTarget, const float* clearColor);
+    void invalidateFrameHash();
     void beginFrame(NkCanvas* canvas);
-    void endFrame(NkCanvas* canvas);
+    void endFrame(NkCanvas* canvas, NkImage* renderTarget);
     void swapFrame(NkCanvas* canvas);
     void drawLine(float x0, float y0, float x1, float y1, float lineWidth,
                   uint32_t color);
@@ -205,6 +371,19 @@ struct NkCanvasBase {
     void drawImage(float x, float y, float width, float height, float frameX,
                    float frameY, float frameWidth, float frameHeight,
                    uint32_t color, NkImage* image);
+    void drawImage(float x, float y, const NkImageTransform& transform,
+                   uint32_t color, NkImage* image);
+    void drawImage(float x, float y, float width, float height, float frameX,
+                   float frameY, float frameWidth, float frameHeight,
+                   const NkImageTransform& transform, uint32_t color,
+                   NkImage* image);
+    void drawImages(const NkSpriteDesc* sprites, uint32_t count,
+                    NkImage* image);
+    void drawImages(const NkSpriteArrays& sprites, uint32_t count,
+                    NkImage* image);
+    void drawRects(const NkRectDesc* rects, uint32_t count);
+    void drawRects(const NkRectArrays& rects, uint32_t count);
+    void drawPerfOverlay(float x, float y);
 
 public:
     NkCanvas* canvas;
@@ -213,16 +392,41 @@ public:
     uint64_t currentFrameIndex;
     uint64_t lastFrameIndex;
     bool indicesUploaded;
-    NkCanvasVertexBufferAllocator vertexBufferAllocator[NK_CANVAS_MAX_FRAMES];
+    NkCanvasVertexRingBuffer vertexRingBuffer;
     NkCanvasDrawBatchInternalArray drawBatchArray[NK_CANVAS_MAX_FRAMES];
     NkGPUHandle gpuFrameSyncPoint[NK_CANVAS_MAX_FRAMES];
     uint64_t gpuFrameWaitValue[NK_CANVAS_MAX_FRAMES];
-    NkCanvasVertexBuffer* currVertexBuffer;
+    NkCanvasVertexRange* currVertexRange;
     NkCanvasDrawBatchInternal* currDrawBatch;
     uint64_t currentFrame;
     float resolution[2];
     NkCanvasMatrixStack matrixStack;
+    NkCanvasClipStack clipStack;
+    NkBlendMode blendMode;
+    NkCanvasFrameStats frameStats;
+    NkCanvasFrameStats lastFrameStats;
+    uint64_t frameStartTime;
+    // Set when a back buffer frame ends. The passes drawn up to the next one
+    // make up one frame for the stats and the frame arena. Canvases that
+    // never draw to the back buffer end a frame with every pass.
+    bool frameEnded;
+    bool backBufferDrawn;
+    uint64_t recordStartTime;
+    float frameTimeHistory[NK_CANVAS_PERF_OVERLAY_HISTORY];
+    uint32_t frameTimeHistoryIndex;
+    uint64_t frameArenaFrame;
+    NkCanvasCapture capture;
+    NkCanvasReadbackQueue readbacks;
+    NkCanvasVideoCapture video;
+    bool skipIdenticalFrames;
+    bool frameSkipped;
+    bool frameHashValid;
+    uint64_t frameHash;
+    uint32_t skippedFrameNum;
+    // Indices are generated up to the largest batch drawn so far and
+    // indicesUploaded is cleared every time they grow.
     NK_CANVAS_INDEX_TYPE* indices;
+    uint32_t indexedQuadNum;
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
     NkTextureAtlas frameTextureAtlas;
 #endif
@@ -232,9 +436,8 @@ namespace nk {
 
     namespace canvas_internal {
 
-        void initVertexBuffer(
-            NkCanvasVertexBuffer* vertexBuffer,
-            size_t bufferSize = NK_CANVAS_MAX_DRAW_VERTS_PER_BUFFER_BYTE_SIZE);
+        void initVertexBuffer(NkCanvasVertexBuffer* vertexBuffer,
+                              size_t bufferSize);
         void initIndexBuffer(void** gpuIndexBuffer);
         void destroyVertexBuffer(NkCanvasVertexBuffer* vertexBuffer);
         void destroyIndexBuffer(void** gpuIndexBuffer);
@@ -244,12 +447,22 @@ namespace nk {
         void initFrameSyncPoint(NkGPUHandle* gpuSyncPoint);
         void destroyFrameSyncPoint(NkGPUHandle* gpuSyncPoint);
         NkCanvasBase* canvasBase(NkCanvas* canvas);
+        // Starts copying a render target into CPU readable memory. Returns
+        // nullptr when the image can't be read.
+        NkGPUHandle beginReadback(NkCanvas* canvas, NkImage* image);
+        // Returns the copied pixels, or nullptr while the GPU is still
+        // working on them.
+        const void* mapReadback(NkGPUHandle gpuReadback, uint32_t* rowPitch);
+        void destroyReadback(NkGPUHandle gpuReadback);
+        NkCanvasScissorRect scissorRect(const NkCanvasDrawBatchInternal& drawBatch,
+                                        float viewWidth, float viewHeight);
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
         void initTextureAtlasResource(NkCanvas* canvas,
                                       NkTextureAtlas& textureAtlas);
         void destroyTextureAtlasResource(NkTextureAtlas& textureAtlas);
         void setTextureAtlasState(NkImage* image,
                                   const NkTextureAtlasRect& rect);
+        void clearTextureAtlasState(NkImage* image);
         bool isImageInTextureAtlas(NkImage* image);
         const NkTextureAtlasRect& textureRect(NkImage* image);
 #endif
@@ -0,0 +1,330 @@
+#include "canvas_internal.h"
+#include "canvas_video.h"
+#include "utils.h"
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#if NK_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <io.h>
+#define NK_CANVAS_VIDEO_POPEN(command) _popen(command, "wb")
+#define NK_CANVAS_VIDEO_PCLOSE(file)   _pclose(file)
+#else
+#define NK_CANVAS_VIDEO_POPEN(command) popen(command, "w")
+#define NK_CANVAS_VIDEO_PCLOSE(file)   pclose(file)
+#endif
+
+// Same as the job system, the web build only gets a writer thread when it's
+// compiled with pthreads. Otherwise frames are written from the callback.
+#if NK_PLATFORM_WEB && !defined(__EMSCRIPTEN_PTHREADS__)
+#define NK_CANVAS_VIDEO_THREADS_ENABLED 0
+#else
+#define NK_CANVAS_VIDEO_THREADS_ENABLED 1
+#endif
+
+enum class NkCanvasVideoOutput {
+    PATH,
+    STANDARD_OUTPUT,
+    PROCESS
+};
+
+struct NkCanvasVideoFrame {
+    uint8_t* pixels; // Tightly packed R8G8B8A8 rows
+    size_t pixelsMax;
+};
+
+struct NkCanvasVideoStream {
+    FILE* file;
+    NkCanvasVideoOutput output;
+    NkVideoFormat format;
+    uint32_t frameRate;
+    // Set by the first frame. Every following frame has to match it.
+    uint32_t width;
+    uint32_t height;
+    // Bounded FIFO shared with the writer thread. The render thread fills
+    // frames[writeIndex] before publishing it and the writer only releases
+    // a frame once it's written, so the pixels are copied without the lock.
+    NkCanvasVideoFrame frames[NK_CANVAS_VIDEO_QUEUE_CAPACITY];
+    uint64_t readIndex;
+    uint64_t writeIndex;
+    bool quit;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+#if NK_CANVAS_VIDEO_THREADS_ENABLED
+    std::thread writer;
+#endif
+    // Only touched by the writer
+    uint8_t* convertedPixels;
+    uint64_t writtenFrameNum;
+    bool writeFailed;
+    // Only touched by the render thread
+    uint32_t droppedFrameNum;
+    bool sizeMismatchLogged;
+};
+
+// BT.601 limited range, which is what encoders assume for Y4M input.
+static void convertToYUV444(const uint8_t* pixels, uint32_t rowPitch,
+                            uint32_t width, uint32_t height, uint8_t* planes) {
+    size_t planeSize = (size_t)width * height;
+    uint8_t* yPlane = planes;
+    uint8_t* uPlane = planes + planeSize;
+    uint8_t* vPlane = planes + planeSize * 2;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + (size_t)y * rowPitch;
+        for (uint32_t x = 0; x < width; ++x) {
+            int32_t r = row[x * 4 + 0];
+            int32_t g = row[x * 4 + 1];
+            int32_t b = row[x * 4 + 2];
+            *yPlane++ =
+                (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            *uPlane++ =
+                (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            *vPlane++ =
+                (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static void convertToRGB(const uint8_t* pixels, uint32_t rowPitch,
+                         uint32_t width, uint32_t height, uint8_t* rgb) {
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + (size_t)y * rowPitch;
+        for (uint32_t x = 0; x < width; ++x) {
+            *rgb++ = row[x * 4 + 0];
+            *rgb++ = row[x * 4 + 1];
+            *rgb++ = row[x * 4 + 2];
+        }
+    }
+}
+
+static void writeFrame(NkCanvasVideoStream* stream, const uint8_t* pixels,
+                       uint32_t rowPitch) {
+    if (stream->writeFailed) {
+        return;
+    }
+    uint32_t width = stream->width;
+    uint32_t height = stream->height;
+    size_t convertedSize = (size_t)width * height * 3;
+    if (stream->format != NkVideoFormat::RAW_RGBA &&
+        !stream->convertedPixels) {
+        stream->convertedPixels = (uint8_t*)nk::utils::memRealloc(
+            nullptr, convertedSize, NkMemoryTag::CAPTURE);
+        if (!stream->convertedPixels) {
+            NK_LOG("Error: Failed to allocate the video conversion buffer.");
+            stream->writeFailed = true;
+            return;
+        }
+    }
+
+    FILE* file = stream->file;
+    switch (stream->format) {
+    case NkVideoFormat::Y4M:
+        if (stream->writtenFrameNum == 0) {
+            fprintf(file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", width,
+                    height, stream->frameRate);
+        }
+        convertToYUV444(pixels, rowPitch, width, height,
+                        stream->convertedPixels);
+        fputs("FRAME\n", file);
+        fwrite(stream->convertedPixels, 1, convertedSize, file);
+        break;
+    case NkVideoFormat::PPM:
+        convertToRGB(pixels, rowPitch, width, height, stream->convertedPixels);
+        fprintf(file, "P6\n%u %u\n255\n", width, height);
+        fwrite(stream->convertedPixels, 1, convertedSize, file);
+        break;
+    case NkVideoFormat::RAW_RGBA:
+        for (uint32_t y = 0; y < height; ++y) {
+            fwrite(pixels + (size_t)y * rowPitch, 1, (size_t)width * 4, file);
+        }
+        break;
+    }
+    if (ferror(file)) {
+        NK_LOG("Error: Failed to write video frame %llu, the rest of the "
+               "video capture is dropped.",
+               (unsigned long long)stream->writtenFrameNum);
+        stream->writeFailed = true;
+        return;
+    }
+    stream->writtenFrameNum++;
+}
+
+#if NK_CANVAS_VIDEO_THREADS_ENABLED
+static void writerMain(NkCanvasVideoStream* stream) {
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    for (;;) {
+        stream->wakeUp.wait(lock, [stream]() {
+            return stream->readIndex != stream->writeIndex || stream->quit;
+        });
+        // Frames queued before quitting are still written out.
+        if (stream->readIndex == stream->writeIndex) {
+            break;
+        }
+        NkCanvasVideoFrame& frame =
+            stream->frames[stream->readIndex % NK_CANVAS_VIDEO_QUEUE_CAPACITY];
+        lock.unlock();
+        writeFrame(stream, frame.pixels, stream->width * 4);
+        lock.lock();
+        stream->readIndex++;
+    }
+}
+#endif
+
+static void videoFramePixels(void* userData, const void* pixels,
+                             uint32_t width, uint32_t height,
+                             uint32_t rowPitch) {
+    NkCanvasVideoStream* stream = (NkCanvasVideoStream*)userData;
+    if (stream->width == 0) {
+        stream->width = width;
+        stream->height = height;
+    } else if (width != stream->width || height != stream->height) {
+        if (!stream->sizeMismatchLogged) {
+            NK_LOG("WARNING: Video frames have to be %ux%u like the first "
+                   "one, %ux%u frames are dropped.",
+                   stream->width, stream->height, width, height);
+            stream->sizeMismatchLogged = true;
+        }
+        stream->droppedFrameNum++;
+        return;
+    }
+
+#if NK_CANVAS_VIDEO_THREADS_ENABLED
+    uint64_t writeIndex;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (stream->writeIndex - stream->readIndex >=
+            NK_CANVAS_VIDEO_QUEUE_CAPACITY) {
+            // The writer fell behind. Dropping keeps the canvas running at
+            // full speed.
+            stream->droppedFrameNum++;
+            return;
+        }
+        writeIndex = stream->writeIndex;
+    }
+    NkCanvasVideoFrame& frame =
+        stream->frames[writeIndex % NK_CANVAS_VIDEO_QUEUE_CAPACITY];
+    size_t rowSize = (size_t)width * 4;
+    size_t frameSize = rowSize * height;
+    if (frame.pixelsMax < frameSize) {
+        uint8_t* framePixels = (uint8_t*)nk::utils::memRealloc(
+            frame.pixels, frameSize, NkMemoryTag::CAPTURE);
+        if (!framePixels) {
+            stream->droppedFrameNum++;
+            return;
+        }
+        frame.pixels = framePixels;
+        frame.pixelsMax = frameSize;
+    }
+    for (uint32_t y = 0; y < height; ++y) {
+        memcpy(frame.pixels + y * rowSize,
+               (const uint8_t*)pixels + (size_t)y * rowPitch, rowSize);
+    }
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->writeIndex++;
+    }
+    stream->wakeUp.notify_one();
+#else
+    writeFrame(stream, (const uint8_t*)pixels, rowPitch);
+#endif
+}
+
+bool NkCanvasVideoCapture::begin(NkCanvasBase& base, const char* path,
+                                 NkVideoFormat format, uint32_t frameRate) {
+    if (active()) {
+        end(base);
+    }
+    NkCanvasVideoOutput output = NkCanvasVideoOutput::PATH;
+    FILE* file = nullptr;
+    if (strcmp(path, "-") == 0) {
+        output = NkCanvasVideoOutput::STANDARD_OUTPUT;
+        file = stdout;
+#if NK_PLATFORM_WINDOWS
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    } else if (path[0] == '|') {
+        output = NkCanvasVideoOutput::PROCESS;
+#if NK_PLATFORM_WEB
+        NK_LOG("Error: Video capture can't pipe to a process on the web.");
+        return false;
+#else
+        file = NK_CANVAS_VIDEO_POPEN(path + 1);
+#endif
+    } else {
+        file = fopen(path, "wb");
+    }
+    if (!file) {
+        NK_LOG("Error: Failed to open %s for writing the video capture.",
+               path);
+        return false;
+    }
+
+    stream = (NkCanvasVideoStream*)nk::utils::memZeroAlloc(
+        1, sizeof(NkCanvasVideoStream), NkMemoryTag::CAPTURE,
+        alignof(NkCanvasVideoStream));
+    NK_ASSERT_EXIT(stream != nullptr,
+                   "Error: Failed to allocate the video capture.");
+    new (stream) NkCanvasVideoStream();
+    stream->file = file;
+    stream->output = output;
+    stream->format = format;
+    stream->frameRate = frameRate > 0 ? frameRate : 60;
+#if NK_CANVAS_VIDEO_THREADS_ENABLED
+    stream->writer = std::thread(writerMain, stream);
+#endif
+    return true;
+}
+
+void NkCanvasVideoCapture::end(NkCanvasBase& base) {
+    if (!stream) {
+        return;
+    }
+    // Frames that are still being read back are lost.
+    base.readbacks.cancel(stream);
+#if NK_CANVAS_VIDEO_THREADS_ENABLED
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->quit = true;
+    }
+    stream->wakeUp.notify_one();
+    stream->writer.join();
+#endif
+    if (stream->droppedFrameNum > 0) {
+        NK_LOG("WARNING: %u video frames were dropped.",
+               stream->droppedFrameNum);
+    }
+    switch (stream->output) {
+    case NkCanvasVideoOutput::PATH:
+        fclose(stream->file);
+        break;
+    case NkCanvasVideoOutput::STANDARD_OUTPUT:
+        fflush(stream->file);
+        break;
+    case NkCanvasVideoOutput::PROCESS:
+#if !NK_PLATFORM_WEB
+        NK_CANVAS_VIDEO_PCLOSE(stream->file);
+#endif
+        break;
+    }
+    for (uint32_t index = 0; index < NK_CANVAS_VIDEO_QUEUE_CAPACITY; ++index) {
+        nk::utils::memFree(stream->frames[index].pixels, NkMemoryTag::CAPTURE);
+    }
+    nk::utils::memFree(stream->convertedPixels, NkMemoryTag::CAPTURE);
+    stream->~NkCanvasVideoStream();
+    nk::utils::memFree(stream, NkMemoryTag::CAPTURE);
+    stream = nullptr;
+}
+
+bool NkCanvasVideoCapture::captureFrame(NkCanvasBase& base,
+                                        NkImage* renderTarget) {
+    if (!stream) {
+        NK_LOG("Error: Video capture hasn't been started.");
+        return false;
+    }
+    return base.readbacks.push(base.canvas, renderTarget, videoFramePixels,
+                               stream);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <nk/canvas.h>
+#include <stdint.h>
+
+#define NK_CANVAS_VIDEO_QUEUE_CAPACITY 4
+
+struct NkCanvasBase;
+struct NkCanvasVideoStream;
+
+// Streams render target frames to a file or pipe. Frames are read back with
+// nk::canvas::readPixelsAsync and written by a background thread, a frame
+// that finds the queue full is dropped instead of stalling the canvas.
+struct NkCanvasVideoCapture {
+
+    bool begin(NkCanvasBase& base, const char* path, NkVideoFormat format,
+               uint32_t frameRate);
+    void end(NkCanvasBase& base);
+    inline bool active() const { return stream != nullptr; }
+    bool captureFrame(NkCanvasBase& base, NkImage* renderTarget);
+
+    NkCanvasVideoStream* stream;
+};
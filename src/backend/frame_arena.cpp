@@ -0,0 +1,137 @@
+#include "utils.h"
+#include <atomic>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+
+#define NK_UTILS_FRAME_ARENA_INITIAL_SIZE (256 * 1024)
+#define NK_UTILS_FRAME_ARENA_COUNT        2
+
+struct NkFrameArenaBlock {
+    NkFrameArenaBlock* next;
+    size_t capacity;
+    std::atomic<size_t> offset;
+    alignas(16) uint8_t data[1];
+};
+
+// Linear allocator reset once per frame. There are two arenas so memory
+// allocated during a frame is still valid while the next one is being
+// recorded.
+struct NkFrameArena {
+    std::atomic<NkFrameArenaBlock*> block;
+    size_t capacity; // Sum of all the blocks
+};
+
+static NkFrameArena frameArenas[NK_UTILS_FRAME_ARENA_COUNT] = {};
+static std::atomic<uint32_t> currentFrameArena{0};
+static std::mutex frameArenaMutex;
+static uint64_t frameArenaFrame = 1;
+static uint32_t frameArenaRefCount = 0;
+
+static NkFrameArenaBlock* allocateFrameArenaBlock(size_t capacity,
+                                                  NkFrameArenaBlock* next) {
+    NkFrameArenaBlock* block = (NkFrameArenaBlock*)nk::utils::memRealloc(
+        nullptr, offsetof(NkFrameArenaBlock, data) + capacity,
+        NkMemoryTag::FRAME_ARENA);
+    NK_ASSERT_EXIT(block != nullptr,
+                   "Error: Failed to allocate frame arena block.");
+    block->next = next;
+    block->capacity = capacity;
+    new (&block->offset) std::atomic<size_t>(0);
+    return block;
+}
+
+static void freeFrameArenaBlocks(NkFrameArenaBlock* block) {
+    while (block) {
+        NkFrameArenaBlock* next = block->next;
+        nk::utils::memFree(block, NkMemoryTag::FRAME_ARENA);
+        block = next;
+    }
+}
+
+void* nk::utils::frameAlloc(size_t size, size_t alignment) {
+    NK_ASSERT(isPowerOfTwo(alignment),
+              "Error: Frame allocation alignment must be a power of two.");
+    NkFrameArena& arena =
+        frameArenas[currentFrameArena.load(std::memory_order_relaxed)];
+    size_t paddedSize = size + alignment - 1;
+    while (true) {
+        NkFrameArenaBlock* block = arena.block.load(std::memory_order_acquire);
+        if (block) {
+            size_t offset =
+                block->offset.fetch_add(paddedSize, std::memory_order_relaxed);
+            if (offset + paddedSize <= block->capacity) {
+                return alignPtr(&block->data[offset], alignment);
+            }
+        }
+        // Out of space, chain a larger block. The old blocks stay alive until
+        // the arena is reset since they can still be in use.
+        std::lock_guard<std::mutex> lock(frameArenaMutex);
+        if (arena.block.load(std::memory_order_relaxed) == block) {
+            size_t capacity = block ? block->capacity * 2
+                                    : NK_UTILS_FRAME_ARENA_INITIAL_SIZE;
+            capacity = max(capacity, paddedSize);
+            arena.block.store(allocateFrameArenaBlock(capacity, block),
+                              std::memory_order_release);
+            arena.capacity += capacity;
+        }
+    }
+}
+
+void nk::utils::initFrameArena() {
+    std::lock_guard<std::mutex> lock(frameArenaMutex);
+    frameArenaRefCount++;
+}
+
+void nk::utils::resetFrameArena(uint64_t* lastFrame) {
+    std::lock_guard<std::mutex> lock(frameArenaMutex);
+    if (*lastFrame != frameArenaFrame) {
+        // Another canvas already started this frame.
+        *lastFrame = frameArenaFrame;
+        return;
+    }
+    *lastFrame = ++frameArenaFrame;
+    uint32_t next = (currentFrameArena.load(std::memory_order_relaxed) + 1) %
+                    NK_UTILS_FRAME_ARENA_COUNT;
+    NkFrameArena& arena = frameArenas[next];
+    NkFrameArenaBlock* block = arena.block.load(std::memory_order_relaxed);
+    if (block && block->next) {
+        // Merge the blocks so the arena doesn't need to grow next time.
+        freeFrameArenaBlocks(block);
+        block = allocateFrameArenaBlock(arena.capacity, nullptr);
+        arena.block.store(block, std::memory_order_relaxed);
+    } else if (block) {
+        block->offset.store(0, std::memory_order_relaxed);
+    }
+    currentFrameArena.store(next, std::memory_order_release);
+}
+
+void nk::utils::destroyFrameArena() {
+    std::lock_guard<std::mutex> lock(frameArenaMutex);
+    NK_ASSERT(frameArenaRefCount > 0, "Error: Frame arena isn't running.");
+    if (--frameArenaRefCount > 0) {
+        return;
+    }
+    for (NkFrameArena& arena : frameArenas) {
+        freeFrameArenaBlocks(arena.block.load(std::memory_order_relaxed));
+        arena.block.store(nullptr, std::memory_order_relaxed);
+        arena.capacity = 0;
+    }
+}
+
+const char* nk::utils::tempString(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int length = vsnprintf(nullptr, 0, fmt, argsCopy);
+    va_end(argsCopy);
+    char* buffer = (char*)frameAlloc(length > 0 ? length + 1 : 1, 1);
+    if (length > 0) {
+        vsnprintf(buffer, length + 1, fmt, args);
+    } else {
+        buffer[0] = 0;
+    }
+    va_end(args);
+    return buffer;
+}
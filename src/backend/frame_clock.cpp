@@ -0,0 +1,133 @@
+#include "frame_clock.h"
+#include "utils.h"
+#include <math.h>
+#include <thread>
+
+#define NK_FRAME_CLOCK_INITIAL_SLEEP_MARGIN 1000000ULL // 1ms
+#define NK_FRAME_CLOCK_MIN_SLEEP_MARGIN     100000ULL  // 0.1ms
+#define NK_FRAME_CLOCK_STEP_SNAP            0.02       // Fraction of a step
+
+void NkFrameClock::tick() {
+    if (virtualFrameTime != 0) {
+        lastTickTime += virtualFrameTime;
+        frameTime = (double)virtualFrameTime / 1.0e9;
+        return;
+    }
+    uint64_t now = nk::utils::timeNs();
+    frameTime =
+        lastTickTime != 0 ? (double)(now - lastTickTime) / 1.0e9 : 0.0;
+    lastTickTime = now;
+}
+
+double NkFrameClock::timeSinceTick() const {
+    // The virtual clock only moves on ticks, so the next tick is always a
+    // whole frame away.
+    if (virtualFrameTime != 0) {
+        return (double)virtualFrameTime / 1.0e9;
+    }
+    if (lastTickTime == 0) {
+        return 0.0;
+    }
+    return (double)(nk::utils::timeNs() - lastTickTime) / 1.0e9;
+}
+
+void NkFrameClock::limit(double targetFrameTime) {
+    if (virtualFrameTime != 0) {
+        limitedFrameNum++;
+        return;
+    }
+    uint64_t now = nk::utils::timeNs();
+    uint64_t targetNs = (uint64_t)(targetFrameTime * 1.0e9);
+    if (deadline == 0 || targetNs == 0) {
+        // Nothing to wait for on the first frame.
+        deadline = now + targetNs;
+        return;
+    }
+    if (sleepMargin == 0) {
+        sleepMargin = NK_FRAME_CLOCK_INITIAL_SLEEP_MARGIN;
+    }
+
+    // Sleep while the remaining time is larger than what the scheduler
+    // usually oversleeps by. The margin grows with every oversleep and
+    // slowly decays back, so it follows the timer resolution of the system.
+    uint64_t sleepStart = now;
+    while (now < deadline && deadline - now > sleepMargin) {
+        uint64_t request = deadline - now - sleepMargin;
+        nk::utils::sleepNs(request);
+        uint64_t woken = nk::utils::timeNs();
+        uint64_t overslept = woken - now > request ? woken - now - request : 0;
+        sleepMargin -= sleepMargin / 64;
+        sleepMargin = nk::utils::max<uint64_t>(sleepMargin, overslept);
+        sleepMargin = nk::utils::max<uint64_t>(
+            sleepMargin, NK_FRAME_CLOCK_MIN_SLEEP_MARGIN);
+        now = woken;
+    }
+    uint64_t spinStart = now;
+    while (now < deadline) {
+        std::this_thread::yield();
+        now = nk::utils::timeNs();
+    }
+
+    uint64_t jitter = now - deadline;
+    limitedFrameNum++;
+    totalJitter += jitter;
+    maxJitter = nk::utils::max<uint64_t>(maxJitter, jitter);
+    totalSleep += spinStart - sleepStart;
+    totalSpin += now - spinStart;
+
+    // Keep a steady cadence from deadline to deadline. A frame that ran
+    // over by more than a whole frame starts a new cadence instead of
+    // rushing the following frames to catch up.
+    deadline = jitter > targetNs ? now + targetNs : deadline + targetNs;
+}
+
+NkFrameLimiterStats NkFrameClock::stats() const {
+    NkFrameLimiterStats result = {};
+    result.frameNum = limitedFrameNum;
+    if (limitedFrameNum > 0) {
+        double frameNum = (double)limitedFrameNum;
+        result.averageJitter = (double)totalJitter / 1.0e9 / frameNum;
+        result.maxJitter = (double)maxJitter / 1.0e9;
+        result.averageSleep = (double)totalSleep / 1.0e9 / frameNum;
+        result.averageSpin = (double)totalSpin / 1.0e9 / frameNum;
+    }
+    return result;
+}
+
+uint32_t nk::app::fixedSteps(const NkApp* app, NkFixedTimestep* timestep) {
+    NK_ASSERT(timestep->stepTime > 0.0,
+              "Error: Fixed timestep needs a step time.");
+    uint32_t maxStepNum = nk::utils::max<uint32_t>(timestep->maxStepNum, 1);
+    // A paced loop runs close to whole steps but its jitter would make the
+    // accumulator alternate between zero and two steps. Frame times that
+    // are almost a whole number of steps are snapped to it.
+    double frameTime = nk::app::frameTime(app);
+    double wholeSteps = floor(frameTime / timestep->stepTime + 0.5);
+    double snappedTime = wholeSteps * timestep->stepTime;
+    if (wholeSteps > 0.0 &&
+        fabs(frameTime - snappedTime) <
+            timestep->stepTime * NK_FRAME_CLOCK_STEP_SNAP) {
+        frameTime = snappedTime;
+    }
+    timestep->accumulatedTime += frameTime;
+    uint32_t stepNum = 0;
+    while (timestep->accumulatedTime >= timestep->stepTime &&
+           stepNum < maxStepNum) {
+        timestep->accumulatedTime -= timestep->stepTime;
+        stepNum++;
+    }
+    // Drop the whole steps that couldn't be simulated so a long stall
+    // doesn't turn into a burst of steps over the next frames.
+    if (timestep->accumulatedTime >= timestep->stepTime) {
+        timestep->accumulatedTime =
+            fmod(timestep->accumulatedTime, timestep->stepTime);
+    }
+    return stepNum;
+}
+
+float nk::app::fixedStepAlpha(const NkFixedTimestep* timestep) {
+    if (timestep->stepTime <= 0.0) {
+        return 0.0f;
+    }
+    return (float)(timestep->accumulatedTime / timestep->stepTime);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <nk/app.h>
+#include <stdint.h>
+
+// Measures the time between app updates and paces frames for
+// nk::app::limitFrameRate. The app is zero allocated, which is a valid
+// initial state.
+struct NkFrameClock {
+
+    void tick();
+    double timeSinceTick() const;
+    void limit(double targetFrameTime);
+    NkFrameLimiterStats stats() const;
+
+    uint64_t lastTickTime;
+    double frameTime;
+    // Nonzero runs a virtual clock that advances this many nanoseconds per
+    // tick. The limiter doesn't wait on it.
+    uint64_t virtualFrameTime;
+    uint64_t deadline;    // When the current frame should be released
+    uint64_t sleepMargin; // Estimated oversleep, the rest of the wait spins
+    uint32_t limitedFrameNum;
+    uint64_t totalJitter;
+    uint64_t maxJitter;
+    uint64_t totalSleep;
+    uint64_t totalSpin;
+};
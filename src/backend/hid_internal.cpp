@@ -4,7 +4,8 @@
 #include <string.h>
 
 NkHID* nk::hid::create(NkApp* app) {
-    NkHID* hid = (NkHID*)nk::utils::memZeroAlloc(1, sizeof(NkHID));
+    NkHID* hid =
+        (NkHID*)nk::utils::memZeroAlloc(1, sizeof(NkHID), NkMemoryTag::HID);
     if (!hid)
         return nullptr;
     memset(hid, 0, sizeof(NkHID));
@@ -21,7 +22,9 @@ NkHID* nk::hid::create(NkApp* app) {
 
 bool nk::hid::destroy(NkHID* hid) {
     if (hid) {
-        nk::utils::memFree(hid);
+        hid->recording.endRecording();
+        hid->recording.endReplay();
+        nk::utils::memFree(hid, NkMemoryTag::HID);
         return true;
     }
     return false;
@@ -54,3 +57,120 @@ bool nk::hid::cursorVisible(NkHID* hid) { return hid->mouse.visible; }
 float nk::hid::mouseX(NkHID* hid) { return hid->mouse.positionX; }
 
 float nk::hid::mouseY(NkHID* hid) { return hid->mouse.positionY; }
+
+bool nk::hid::pollEvent(NkHID* hid, NkInputEvent* event) {
+    NkInputEventQueue& queue = hid->eventQueue;
+    if (queue.pollIndex == queue.writeIndex) {
+        return false;
+    }
+    *event = queue.events[queue.pollIndex++ & (NK_HID_MAX_EVENTS - 1)];
+    return true;
+}
+
+void NkInputEventQueue::push(const NkInputEvent& event) {
+    events[writeIndex++ & (NK_HID_MAX_EVENTS - 1)] = event;
+    if (writeIndex - pollIndex > NK_HID_MAX_EVENTS) {
+        pollIndex = writeIndex - NK_HID_MAX_EVENTS;
+    }
+    if (writeIndex - updateIndex > NK_HID_MAX_EVENTS) {
+        if (!overflowed) {
+            NK_LOG("Warning: Input event queue is full, dropping events");
+            overflowed = true;
+        }
+        updateIndex = writeIndex - NK_HID_MAX_EVENTS;
+    }
+}
+
+void nk::hid::pushEvent(NkHID* hid, const NkInputEvent& event) {
+    if (!hid->recording.replaying()) {
+        hid->eventQueue.push(event);
+    }
+}
+
+static void applyEvent(NkHID* hid, const NkInputEvent& event) {
+    NkKeyboard& keyboard = hid->keyboard;
+    NkMouse& mouse = hid->mouse;
+    uint32_t keyCode = (uint32_t)event.keyCode;
+    uint32_t button = (uint32_t)event.button;
+    switch (event.type) {
+    case NkInputEventType::KEY_DOWN:
+        if (keyCode < sizeof(keyboard.keysDown)) {
+            if (!keyboard.keysDown[keyCode]) {
+                keyboard.keysClick[keyCode] = true;
+            }
+            keyboard.keysDown[keyCode] = true;
+        }
+        break;
+    case NkInputEventType::KEY_UP:
+        if (keyCode < sizeof(keyboard.keysDown)) {
+            keyboard.keysClick[keyCode] = false;
+            keyboard.keysDown[keyCode] = false;
+        }
+        break;
+    case NkInputEventType::CHAR:
+        keyboard.lastChar = (char)event.character;
+        break;
+    case NkInputEventType::MOUSE_MOVE:
+        mouse.positionX = event.mouseX;
+        mouse.positionY = event.mouseY;
+        break;
+    case NkInputEventType::MOUSE_DOWN:
+        if (button < sizeof(mouse.buttonsDown)) {
+            if (!mouse.buttonsDown[button]) {
+                mouse.buttonsClick[button] = true;
+            }
+            mouse.buttonsDown[button] = true;
+        }
+        mouse.positionX = event.mouseX;
+        mouse.positionY = event.mouseY;
+        break;
+    case NkInputEventType::MOUSE_UP:
+        if (button < sizeof(mouse.buttonsDown)) {
+            mouse.buttonsDown[button] = false;
+            mouse.buttonsClick[button] = false;
+        }
+        mouse.positionX = event.mouseX;
+        mouse.positionY = event.mouseY;
+        break;
+    case NkInputEventType::MOUSE_WHEEL:
+        mouse.wheelDeltaX += event.wheelDeltaX;
+        mouse.wheelDeltaY += event.wheelDeltaY;
+        break;
+    }
+}
+
+void nk::hid::applyEvents(NkHID* hid) {
+    hid->keyboard.lastChar = 0;
+    memset(hid->keyboard.keysClick, 0, sizeof(hid->keyboard.keysClick));
+    memset(hid->mouse.buttonsClick, 0, sizeof(hid->mouse.buttonsClick));
+    hid->mouse.wheelDeltaX = 0.0f;
+    hid->mouse.wheelDeltaY = 0.0f;
+
+    NkInputEventQueue& queue = hid->eventQueue;
+    queue.overflowed = false;
+    if (hid->recording.replaying() && !hid->recording.readFrame(queue)) {
+        hid->recording.endReplay();
+    }
+    uint32_t firstIndex = queue.updateIndex;
+    for (; queue.updateIndex != queue.writeIndex; ++queue.updateIndex) {
+        applyEvent(hid,
+                   queue.events[queue.updateIndex & (NK_HID_MAX_EVENTS - 1)]);
+    }
+    if (hid->recording.recording()) {
+        hid->recording.writeFrame(queue, firstIndex);
+    }
+}
+
+bool nk::hid::startRecording(NkHID* hid, const char* path) {
+    return hid->recording.beginRecording(path);
+}
+
+void nk::hid::stopRecording(NkHID* hid) { hid->recording.endRecording(); }
+
+bool nk::hid::startReplay(NkHID* hid, const char* path) {
+    return hid->recording.beginReplay(path);
+}
+
+void nk::hid::stopReplay(NkHID* hid) { hid->recording.endReplay(); }
+
+bool nk::hid::replaying(NkHID* hid) { return hid->recording.replaying(); }
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <nk/hid.h>
+#include <stdio.h>
+
+#define NK_HID_MAX_EVENTS        1024       // Must be power of two
+#define NK_HID_RECORDING_MAGIC   0x44484b4e // "NKHD"
+#define NK_HID_RECORDING_VERSION 1
 
 struct NkMouse {
     bool buttonsDown[3];
@@ -18,9 +23,55 @@ struct NkKeyboard {
     char lastChar;
 };
 
+// Events are kept in a ring that overwrites the oldest event when it's
+// full. The indices only grow, so their difference is the event count.
+struct NkInputEventQueue {
+
+    void push(const NkInputEvent& event);
+
+    NkInputEvent events[NK_HID_MAX_EVENTS];
+    uint32_t writeIndex;
+    uint32_t pollIndex;   // Next event returned by pollEvent
+    uint32_t updateIndex; // Next event applied to the mouse and keyboard
+    bool overflowed;
+};
+
+// A recording is a NkHIDRecordingFileHeader followed by one
+// NkHIDRecordingFrame per nk::hid::update, each one followed by eventNum
+// NkInputEvent. Timestamps are relative to the start of the recording.
+struct NkHIDRecordingFileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct NkHIDRecordingFrame {
+    uint32_t eventNum;
+};
+
+struct NkHIDRecording {
+
+    bool beginRecording(const char* path);
+    void endRecording();
+    bool beginReplay(const char* path);
+    void endReplay();
+    inline bool recording() const { return recordFile != nullptr; }
+    inline bool replaying() const { return replayFile != nullptr; }
+    void writeFrame(const NkInputEventQueue& queue, uint32_t firstIndex);
+    // Pushes the events of the next recorded frame. Returns false once the
+    // recording is over.
+    bool readFrame(NkInputEventQueue& queue);
+
+    FILE* recordFile;
+    FILE* replayFile;
+    uint64_t recordStartTime;
+    uint64_t replayStartTime;
+};
+
 struct NkHID {
     NkMouse mouse;
     NkKeyboard keyboard;
+    NkInputEventQueue eventQueue;
+    NkHIDRecording recording;
 };
 
 namespace nk {
@@ -29,6 +80,11 @@ namespace nk {
         NkHID* create(NkApp* app);
         bool destroy(NkHID* hid);
         void update(NkHID* hid, NkApp* app);
+        // Platform events are ignored while a recording is replayed.
+        void pushEvent(NkHID* hid, const NkInputEvent& event);
+        // Clears the per frame state and applies the events pushed since
+        // the last call.
+        void applyEvents(NkHID* hid);
 
     } // namespace hid
 } // namespace nk
@@ -0,0 +1,78 @@
+#include "hid_internal.h"
+#include "utils.h"
+
+bool NkHIDRecording::beginRecording(const char* path) {
+    endRecording();
+    recordFile = fopen(path, "wb");
+    if (!recordFile) {
+        NK_LOG("Error: Failed to open %s for writing the HID recording.",
+               path);
+        return false;
+    }
+    NkHIDRecordingFileHeader fileHeader = {NK_HID_RECORDING_MAGIC,
+                                           NK_HID_RECORDING_VERSION};
+    fwrite(&fileHeader, sizeof(fileHeader), 1, recordFile);
+    recordStartTime = nk::utils::timeNs();
+    return true;
+}
+
+void NkHIDRecording::endRecording() {
+    if (recordFile) {
+        fclose(recordFile);
+        recordFile = nullptr;
+    }
+}
+
+bool NkHIDRecording::beginReplay(const char* path) {
+    endReplay();
+    replayFile = fopen(path, "rb");
+    if (!replayFile) {
+        NK_LOG("Error: Failed to open HID recording %s.", path);
+        return false;
+    }
+    NkHIDRecordingFileHeader fileHeader{};
+    if (fread(&fileHeader, sizeof(fileHeader), 1, replayFile) != 1 ||
+        fileHeader.magic != NK_HID_RECORDING_MAGIC ||
+        fileHeader.version != NK_HID_RECORDING_VERSION) {
+        NK_LOG("Error: %s is not a valid HID recording.", path);
+        endReplay();
+        return false;
+    }
+    replayStartTime = nk::utils::timeNs();
+    return true;
+}
+
+void NkHIDRecording::endReplay() {
+    if (replayFile) {
+        fclose(replayFile);
+        replayFile = nullptr;
+    }
+}
+
+void NkHIDRecording::writeFrame(const NkInputEventQueue& queue,
+                                uint32_t firstIndex) {
+    NkHIDRecordingFrame frame = {queue.writeIndex - firstIndex};
+    fwrite(&frame, sizeof(frame), 1, recordFile);
+    for (uint32_t index = firstIndex; index != queue.writeIndex; ++index) {
+        NkInputEvent event = queue.events[index & (NK_HID_MAX_EVENTS - 1)];
+        event.timeNs -= recordStartTime;
+        fwrite(&event, sizeof(event), 1, recordFile);
+    }
+}
+
+bool NkHIDRecording::readFrame(NkInputEventQueue& queue) {
+    NkHIDRecordingFrame frame{};
+    if (fread(&frame, sizeof(frame), 1, replayFile) != 1) {
+        return false;
+    }
+    for (uint32_t index = 0; index < frame.eventNum; ++index) {
+        NkInputEvent event{};
+        if (fread(&event, sizeof(event), 1, replayFile) != 1) {
+            NK_LOG("Error: HID recording is truncated.");
+            return false;
+        }
+        event.timeNs += replayStartTime;
+        queue.push(event);
+    }
+    return true;
+}
@@ -0,0 +1,296 @@
+#include "utils.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#define NK_UTILS_JOB_QUEUE_CAPACITY 4096 // Must be power of two
+#define NK_UTILS_JOB_MAX_WORKERS    63
+#define NK_UTILS_JOB_SPIN_NUM       64
+
+// The web build only gets threads when it's compiled with pthreads.
+#if NK_PLATFORM_WEB && !defined(__EMSCRIPTEN_PTHREADS__)
+#define NK_UTILS_JOB_THREADS_ENABLED 0
+#else
+#define NK_UTILS_JOB_THREADS_ENABLED 1
+#endif
+
+struct NkJob {
+    NkJobFunc func;
+    void* userData;
+    NkJobCounter* counter;
+    uint32_t jobIndex;
+};
+
+// A thief can read a slot while the owner overwrites it. Its CAS on top
+// fails in that case and the value is discarded, but the fields still have
+// to be atomics to make the read well defined.
+struct NkJobSlot {
+    std::atomic<NkJobFunc> func;
+    std::atomic<void*> userData;
+    std::atomic<NkJobCounter*> counter;
+    std::atomic<uint32_t> jobIndex;
+};
+
+// Chase-Lev work-stealing deque. The owner thread pushes and pops at the
+// bottom, any other thread can steal from the top.
+struct NkJobQueue {
+
+    bool push(const NkJob& job);
+    bool pop(NkJob* job);
+    bool steal(NkJob* job);
+    void readSlot(int64_t index, NkJob* job) const;
+
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    NkJobSlot slots[NK_UTILS_JOB_QUEUE_CAPACITY];
+};
+
+struct NkJobSystem {
+    NkJobQueue* queues; // Queue 0 belongs to the thread that created the app
+    std::thread* workers;
+    uint32_t workerNum;
+    uint32_t refCount;
+    // Jobs pushed but not taken yet. It's only a hint for sleeping workers
+    // and can briefly go negative when a job is stolen before it's counted.
+    std::atomic<int32_t> queuedJobNum;
+    std::atomic<uint32_t> sleepingNum;
+    std::atomic<bool> quit;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+};
+
+static NkJobSystem jobSystem;
+static thread_local NkJobQueue* currentJobQueue = nullptr;
+static thread_local uint32_t currentJobQueueIndex = 0;
+
+bool NkJobQueue::push(const NkJob& job) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= NK_UTILS_JOB_QUEUE_CAPACITY) {
+        return false;
+    }
+    NkJobSlot& slot = slots[b & (NK_UTILS_JOB_QUEUE_CAPACITY - 1)];
+    slot.func.store(job.func, std::memory_order_relaxed);
+    slot.userData.store(job.userData, std::memory_order_relaxed);
+    slot.counter.store(job.counter, std::memory_order_relaxed);
+    slot.jobIndex.store(job.jobIndex, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+bool NkJobQueue::pop(NkJob* job) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_seq_cst);
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    readSlot(b, job);
+    if (t == b) {
+        // Last job, race the thieves for it.
+        bool taken = top.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return taken;
+    }
+    return true;
+}
+
+bool NkJobQueue::steal(NkJob* job) {
+    int64_t t = top.load(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_seq_cst);
+    if (t >= b) {
+        return false;
+    }
+    readSlot(t, job);
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed);
+}
+
+void NkJobQueue::readSlot(int64_t index, NkJob* job) const {
+    const NkJobSlot& slot = slots[index & (NK_UTILS_JOB_QUEUE_CAPACITY - 1)];
+    job->func = slot.func.load(std::memory_order_relaxed);
+    job->userData = slot.userData.load(std::memory_order_relaxed);
+    job->counter = slot.counter.load(std::memory_order_relaxed);
+    job->jobIndex = slot.jobIndex.load(std::memory_order_relaxed);
+}
+
+static inline void runJob(const NkJob& job) {
+    job.func(job.userData, job.jobIndex);
+    job.counter->pendingJobNum.fetch_sub(1, std::memory_order_release);
+}
+
+// Pops from the queue of the calling thread first and then tries to steal
+// from the others, starting with the next one so thieves spread out.
+static bool findJob(NkJob* job) {
+    uint32_t queueNum = jobSystem.workerNum + 1;
+    if (!jobSystem.queues) {
+        return false;
+    }
+    if (currentJobQueue && currentJobQueue->pop(job)) {
+        jobSystem.queuedJobNum.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    for (uint32_t offset = 1; offset <= queueNum; ++offset) {
+        uint32_t queueIndex = (currentJobQueueIndex + offset) % queueNum;
+        NkJobQueue* queue = &jobSystem.queues[queueIndex];
+        if (queue != currentJobQueue && queue->steal(job)) {
+            jobSystem.queuedJobNum.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+#if NK_UTILS_JOB_THREADS_ENABLED
+static void workerMain(uint32_t queueIndex) {
+    currentJobQueue = &jobSystem.queues[queueIndex];
+    currentJobQueueIndex = queueIndex;
+    uint32_t spinNum = 0;
+    while (!jobSystem.quit.load(std::memory_order_acquire)) {
+        NkJob job;
+        if (findJob(&job)) {
+            runJob(job);
+            spinNum = 0;
+            continue;
+        }
+        if (++spinNum < NK_UTILS_JOB_SPIN_NUM) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Publishing sleepingNum before checking queuedJobNum pairs with
+        // runJobs doing the opposite, so one of the two sides always sees
+        // the other and a wake up can't be lost.
+        std::unique_lock<std::mutex> lock(jobSystem.mutex);
+        jobSystem.sleepingNum.fetch_add(1);
+        jobSystem.wakeUp.wait(lock, []() {
+            return jobSystem.queuedJobNum.load() > 0 ||
+                   jobSystem.quit.load(std::memory_order_acquire);
+        });
+        jobSystem.sleepingNum.fetch_sub(1);
+        spinNum = 0;
+    }
+    currentJobQueue = nullptr;
+}
+#endif
+
+void nk::utils::initJobs(uint32_t workerNum) {
+    std::lock_guard<std::mutex> lock(jobSystem.mutex);
+    if (jobSystem.refCount++ > 0) {
+        return;
+    }
+#if NK_UTILS_JOB_THREADS_ENABLED
+    if (workerNum == NK_JOB_WORKER_NUM_AUTO) {
+        uint32_t threadNum = std::thread::hardware_concurrency();
+        workerNum = threadNum > 1 ? threadNum - 1 : 0;
+    }
+    workerNum = nk::utils::min<uint32_t>(workerNum, NK_UTILS_JOB_MAX_WORKERS);
+#else
+    workerNum = 0;
+#endif
+
+    jobSystem.queues = (NkJobQueue*)nk::utils::memZeroAlloc(
+        workerNum + 1, sizeof(NkJobQueue), NkMemoryTag::JOBS,
+        alignof(NkJobQueue));
+    NK_ASSERT_EXIT(jobSystem.queues != nullptr,
+                   "Error: Failed to allocate job queues.");
+    for (uint32_t index = 0; index < workerNum + 1; ++index) {
+        new (&jobSystem.queues[index]) NkJobQueue();
+    }
+    jobSystem.workerNum = workerNum;
+    jobSystem.queuedJobNum.store(0);
+    jobSystem.quit.store(false);
+    currentJobQueue = &jobSystem.queues[0];
+    currentJobQueueIndex = 0;
+
+#if NK_UTILS_JOB_THREADS_ENABLED
+    if (workerNum > 0) {
+        jobSystem.workers = (std::thread*)nk::utils::memZeroAlloc(
+            workerNum, sizeof(std::thread), NkMemoryTag::JOBS);
+        NK_ASSERT_EXIT(jobSystem.workers != nullptr,
+                       "Error: Failed to allocate job workers.");
+        for (uint32_t index = 0; index < workerNum; ++index) {
+            new (&jobSystem.workers[index]) std::thread(workerMain, index + 1);
+        }
+    }
+#endif
+}
+
+void nk::utils::destroyJobs() {
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        NK_ASSERT(jobSystem.refCount > 0, "Error: Job system isn't running.");
+        if (--jobSystem.refCount > 0) {
+            return;
+        }
+    }
+    // Nobody is going to wait for the jobs that are left, but their
+    // counters could still be referenced so they run to completion.
+    NkJob job;
+    while (findJob(&job)) {
+        runJob(job);
+    }
+
+#if NK_UTILS_JOB_THREADS_ENABLED
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        jobSystem.quit.store(true, std::memory_order_release);
+        jobSystem.wakeUp.notify_all();
+    }
+    for (uint32_t index = 0; index < jobSystem.workerNum; ++index) {
+        jobSystem.workers[index].join();
+        jobSystem.workers[index].~thread();
+    }
+    if (jobSystem.workers) {
+        nk::utils::memFree(jobSystem.workers, NkMemoryTag::JOBS);
+    }
+#endif
+    nk::utils::memFree(jobSystem.queues, NkMemoryTag::JOBS);
+    jobSystem.queues = nullptr;
+    jobSystem.workers = nullptr;
+    jobSystem.workerNum = 0;
+    currentJobQueue = nullptr;
+}
+
+void nk::utils::runJobs(NkJobFunc func, void* userData, uint32_t jobNum,
+                        NkJobCounter* counter) {
+    NK_ASSERT(func != nullptr && counter != nullptr,
+              "Error: Jobs need a function and a counter.");
+    counter->pendingJobNum.fetch_add(jobNum, std::memory_order_relaxed);
+    int32_t queuedNum = 0;
+    for (uint32_t jobIndex = 0; jobIndex < jobNum; ++jobIndex) {
+        NkJob job = {func, userData, counter, jobIndex};
+        // Threads outside of the pool don't own a queue. They and full
+        // queues run the job straight away.
+        if (currentJobQueue && currentJobQueue->push(job)) {
+            queuedNum++;
+        } else {
+            runJob(job);
+        }
+    }
+    if (queuedNum == 0) {
+        return;
+    }
+    jobSystem.queuedJobNum.fetch_add(queuedNum);
+    if (jobSystem.sleepingNum.load() > 0) {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        jobSystem.wakeUp.notify_all();
+    }
+}
+
+void nk::utils::waitJobs(NkJobCounter* counter) {
+    // The waiting thread helps with any queued job instead of blocking.
+    while (counter->pendingJobNum.load(std::memory_order_acquire) > 0) {
+        NkJob job;
+        if (findJob(&job)) {
+            runJob(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t nk::utils::jobWorkerNum() { return jobSystem.workerNum; }
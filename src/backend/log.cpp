@@ -0,0 +1,108 @@
+#include "utils.h"
+#include <atomic>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#define NK_UTILS_LOG_MESSAGE_SIZE   1024
+#define NK_UTILS_LOG_QUEUE_CAPACITY 256 // Must be power of two
+#define NK_UTILS_LOG_FULL_RETRY_NUM 64
+
+// The sequence tells the state of the slot for the current lap over the
+// queue. It's 2 * lap while the slot is free and 2 * lap + 1 once the
+// message is written. Starting at zero means the queue needs no setup.
+struct NkLogSlot {
+    std::atomic<uint64_t> sequence;
+    char message[NK_UTILS_LOG_MESSAGE_SIZE];
+};
+
+// Bounded multiple producer, single consumer queue. Any thread can log
+// without taking a lock. Messages are written out by flushLog, which the
+// canvas calls at the start of every pass.
+static NkLogSlot logSlots[NK_UTILS_LOG_QUEUE_CAPACITY] = {};
+static std::atomic<uint64_t> logWriteIndex{0};
+static uint64_t logReadIndex = 0; // Only touched while logFlushing is held
+static std::atomic<bool> logFlushing{false};
+static std::atomic<uint32_t> logDroppedNum{0};
+static std::once_flag logExitFlag;
+
+static inline uint64_t slotLap(uint64_t index) {
+    return (index / NK_UTILS_LOG_QUEUE_CAPACITY) * 2;
+}
+
+static NkLogSlot* claimLogSlot(uint64_t* outIndex) {
+    uint64_t index = logWriteIndex.load(std::memory_order_relaxed);
+    for (;;) {
+        NkLogSlot* slot = &logSlots[index & (NK_UTILS_LOG_QUEUE_CAPACITY - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        uint64_t freeSequence = slotLap(index);
+        if (sequence == freeSequence) {
+            if (logWriteIndex.compare_exchange_weak(
+                    index, index + 1, std::memory_order_relaxed)) {
+                *outIndex = index;
+                return slot;
+            }
+        } else if (sequence < freeSequence) {
+            // The slot still holds a message from the previous lap.
+            return nullptr;
+        } else {
+            index = logWriteIndex.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static void flushLogAtExit() { nk::utils::flushLog(); }
+
+void nk::utils::logFmt(const char* fmt, ...) {
+    std::call_once(logExitFlag, []() { atexit(&flushLogAtExit); });
+
+    uint64_t index = 0;
+    NkLogSlot* slot = claimLogSlot(&index);
+    for (uint32_t retry = 0; !slot && retry < NK_UTILS_LOG_FULL_RETRY_NUM;
+         ++retry) {
+        // The queue is full. Drain it or give the thread that is already
+        // draining it some time before dropping the message.
+        flushLog();
+        std::this_thread::yield();
+        slot = claimLogSlot(&index);
+    }
+    if (!slot) {
+        logDroppedNum.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(slot->message, NK_UTILS_LOG_MESSAGE_SIZE, fmt, args);
+    va_end(args);
+    slot->sequence.store(slotLap(index) + 1, std::memory_order_release);
+}
+
+void nk::utils::flushLog() {
+    // Only one thread drains the queue. If another thread is already doing
+    // it there's nothing left to do.
+    if (logFlushing.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+    for (;;) {
+        NkLogSlot* slot =
+            &logSlots[logReadIndex & (NK_UTILS_LOG_QUEUE_CAPACITY - 1)];
+        uint64_t writtenSequence = slotLap(logReadIndex) + 1;
+        if (slot->sequence.load(std::memory_order_acquire) !=
+            writtenSequence) {
+            break;
+        }
+        logWrite(slot->message);
+        slot->sequence.store(writtenSequence + 1, std::memory_order_release);
+        logReadIndex++;
+    }
+    uint32_t droppedNum = logDroppedNum.exchange(0, std::memory_order_relaxed);
+    if (droppedNum > 0) {
+        char message[128];
+        snprintf(message, sizeof(message),
+                 "WARNING: %u log messages were dropped.\n", droppedNum);
+        logWrite(message);
+    }
+    logFlushing.store(false, std::memory_order_release);
+}
@@ -0,0 +1,274 @@
+#include "utils.h"
+#include <atomic>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+
+// Stored right before every allocation made through the realloc/free
+// functions so they can serve any alignment.
+struct NkAllocationHeader {
+    void* base;
+    size_t size;
+};
+
+// Stored right before every allocation returned by memRealloc so the memory
+// stats can be updated when the allocation is resized or freed.
+struct NkMemoryStatsHeader {
+    size_t size;
+    uint32_t prefixSize;
+    NkMemoryTag tag;
+};
+
+struct NkMemoryCounters {
+    std::atomic<size_t> liveBytes;
+    std::atomic<size_t> peakBytes;
+    std::atomic<uint32_t> liveAllocationNum;
+    std::atomic<uint64_t> totalAllocationNum;
+};
+
+static const char* memoryTagNames[] = {
+    "app",
+    "canvas",
+    "vertexBuffer",
+    "drawBatch",
+    "indexBuffer",
+    "textureAtlas",
+    "image",
+    "hid",
+    "capture",
+    "profiler",
+    "frameArena",
+    "jobs",
+};
+static_assert(sizeof(memoryTagNames) / sizeof(memoryTagNames[0]) ==
+                  (size_t)NkMemoryTag::COUNT,
+              "Missing memory tag name");
+
+// One set of counters per tag plus the totals at the end.
+static NkMemoryCounters memoryCounters[(uint32_t)NkMemoryTag::COUNT + 1];
+static NkAllocator globalAllocator = {};
+static NkReallocFunc globalRealloc = nullptr;
+static NkFreeFunc globalFree = nullptr;
+static std::mutex globalAllocatorMutex;
+static uint32_t globalAllocatorRefCount = 0;
+
+static inline NkAllocationHeader* allocationHeader(void* ptr) {
+    return (NkAllocationHeader*)ptr - 1;
+}
+
+static inline NkMemoryStatsHeader* memoryStatsHeader(void* ptr) {
+    return (NkMemoryStatsHeader*)ptr - 1;
+}
+
+static void addLiveBytes(NkMemoryCounters& counters, size_t oldSize,
+                         size_t newSize) {
+    if (newSize < oldSize) {
+        counters.liveBytes.fetch_sub(oldSize - newSize,
+                                     std::memory_order_relaxed);
+        return;
+    }
+    size_t liveBytes = counters.liveBytes.fetch_add(
+                           newSize - oldSize, std::memory_order_relaxed) +
+                       newSize - oldSize;
+    size_t peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+    while (liveBytes > peakBytes &&
+           !counters.peakBytes.compare_exchange_weak(
+               peakBytes, liveBytes, std::memory_order_relaxed)) {
+    }
+}
+
+static void trackAllocation(NkMemoryTag tag, size_t oldSize, size_t newSize,
+                            int32_t allocationDelta) {
+    for (NkMemoryCounters* counters :
+         {&memoryCounters[(uint32_t)tag],
+          &memoryCounters[(uint32_t)NkMemoryTag::COUNT]}) {
+        addLiveBytes(*counters, oldSize, newSize);
+        counters->liveAllocationNum.fetch_add(allocationDelta,
+                                              std::memory_order_relaxed);
+        if (allocationDelta > 0) {
+            counters->totalAllocationNum.fetch_add(1,
+                                                   std::memory_order_relaxed);
+        }
+    }
+}
+
+static void readCounters(const NkMemoryCounters& counters,
+                         NkMemoryTagStats& stats) {
+    stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+    stats.liveAllocationNum =
+        counters.liveAllocationNum.load(std::memory_order_relaxed);
+    stats.totalAllocationNum =
+        counters.totalAllocationNum.load(std::memory_order_relaxed);
+}
+
+static void* reallocFuncRealloc(void* ptr, size_t size, size_t alignment,
+                                NkMemoryTag tag, void* userData) {
+    alignment = nk::utils::max(alignment, alignof(NkAllocationHeader));
+    void* oldBase = nullptr;
+    size_t oldOffset = 0;
+    size_t oldSize = 0;
+    if (ptr) {
+        NkAllocationHeader* header = allocationHeader(ptr);
+        oldBase = header->base;
+        oldOffset = (uint8_t*)ptr - (uint8_t*)oldBase;
+        oldSize = header->size;
+    }
+    uint8_t* base = (uint8_t*)globalRealloc(
+        oldBase, size + alignment - 1 + sizeof(NkAllocationHeader));
+    if (!base) {
+        return nullptr;
+    }
+    uint8_t* aligned = (uint8_t*)nk::utils::alignPtr(
+        base + sizeof(NkAllocationHeader), alignment);
+    size_t offset = aligned - base;
+    if (ptr && offset != oldOffset) {
+        // realloc moved the block to an address with a different alignment.
+        memmove(aligned, base + oldOffset, nk::utils::min(oldSize, size));
+    }
+    NkAllocationHeader* header = allocationHeader(aligned);
+    header->base = base;
+    header->size = size;
+    return aligned;
+}
+
+static void* reallocFuncAlloc(size_t size, size_t alignment, NkMemoryTag tag,
+                              void* userData) {
+    return reallocFuncRealloc(nullptr, size, alignment, tag, userData);
+}
+
+static void reallocFuncFree(void* ptr, NkMemoryTag tag, void* userData) {
+    globalFree(allocationHeader(ptr)->base);
+}
+
+void nk::utils::initMemoryFunctions(const NkAllocator& allocator,
+                                    NkReallocFunc reallocFunc,
+                                    NkFreeFunc freeFunc) {
+    NkAllocator newAllocator = allocator;
+    if (allocator.alloc || allocator.realloc || allocator.free) {
+        NK_ASSERT_EXIT(allocator.alloc && allocator.realloc && allocator.free,
+                       "Error: NkAllocator must set alloc, realloc and free.");
+        reallocFunc = nullptr;
+        freeFunc = nullptr;
+    } else {
+        // Wrap the realloc and free functions so the rest of the library
+        // can always use the aligned allocator interface.
+        if (reallocFunc == nullptr || freeFunc == nullptr) {
+            reallocFunc = &realloc;
+            freeFunc = &free;
+        }
+        newAllocator.alloc = &reallocFuncAlloc;
+        newAllocator.realloc = &reallocFuncRealloc;
+        newAllocator.free = &reallocFuncFree;
+        newAllocator.userData = nullptr;
+    }
+
+    // Memory can be freed by any app, so every app has to share the
+    // allocator that the first one installed.
+    std::lock_guard<std::mutex> lock(globalAllocatorMutex);
+    if (globalAllocatorRefCount++ > 0) {
+        NK_ASSERT_EXIT(newAllocator.alloc == globalAllocator.alloc &&
+                           newAllocator.realloc == globalAllocator.realloc &&
+                           newAllocator.free == globalAllocator.free &&
+                           newAllocator.userData == globalAllocator.userData &&
+                           reallocFunc == globalRealloc &&
+                           freeFunc == globalFree,
+                       "Error: Every app must use the same allocator.");
+        return;
+    }
+    if (reallocFunc == &realloc && globalRealloc != &realloc) {
+        NK_LOG("Using stdlib realloc and free");
+    }
+    globalAllocator = newAllocator;
+    globalRealloc = reallocFunc;
+    globalFree = freeFunc;
+}
+
+void nk::utils::destroyMemoryFunctions() {
+    // The allocator stays installed so late frees still work, the next
+    // first app can replace it.
+    std::lock_guard<std::mutex> lock(globalAllocatorMutex);
+    NK_ASSERT(globalAllocatorRefCount > 0,
+              "Error: Memory allocation functions not setup.");
+    globalAllocatorRefCount--;
+}
+
+void* nk::utils::memRealloc(void* ptr, size_t size, NkMemoryTag tag,
+                            size_t alignment) {
+    NK_ASSERT_EXIT(globalAllocator.alloc,
+                   "Error: Memory allocation functions not setup. "
+                   "nk::utils::initMemoryFunctions must be called.");
+    NK_ASSERT(isPowerOfTwo(alignment),
+              "Error: Allocation alignment must be a power of two.");
+    alignment = max(alignment, alignof(NkMemoryStatsHeader));
+    if (!ptr) {
+        size_t prefixSize = alignSize(sizeof(NkMemoryStatsHeader), alignment);
+        uint8_t* base = (uint8_t*)globalAllocator.alloc(
+            size + prefixSize, alignment, tag, globalAllocator.userData);
+        if (!base) {
+            return nullptr;
+        }
+        NkMemoryStatsHeader* header = memoryStatsHeader(base + prefixSize);
+        header->size = size;
+        header->prefixSize = (uint32_t)prefixSize;
+        header->tag = tag;
+        trackAllocation(tag, 0, size, 1);
+        return base + prefixSize;
+    }
+    NkMemoryStatsHeader* header = memoryStatsHeader(ptr);
+    NK_ASSERT(header->tag == tag,
+              "Error: Allocation tag %u doesn't match the tag %u it was "
+              "allocated with.",
+              (uint32_t)tag, (uint32_t)header->tag);
+    size_t oldSize = header->size;
+    uint32_t prefixSize = header->prefixSize;
+    uint8_t* base = (uint8_t*)globalAllocator.realloc(
+        (uint8_t*)ptr - prefixSize, size + prefixSize, alignment, header->tag,
+        globalAllocator.userData);
+    if (!base) {
+        return nullptr;
+    }
+    header = memoryStatsHeader(base + prefixSize);
+    header->size = size;
+    trackAllocation(header->tag, oldSize, size, 0);
+    return base + prefixSize;
+}
+
+void nk::utils::memFree(void* ptr, NkMemoryTag tag) {
+    NK_ASSERT_EXIT(globalAllocator.free,
+                   "Error: Memory allocation functions not setup. "
+                   "nk::utils::initMemoryFunctions must be called.");
+    if (ptr) {
+        NkMemoryStatsHeader* header = memoryStatsHeader(ptr);
+        NK_ASSERT(header->tag == tag,
+                  "Error: Allocation tag %u doesn't match the tag %u it was "
+                  "allocated with.",
+                  (uint32_t)tag, (uint32_t)header->tag);
+        trackAllocation(header->tag, header->size, 0, -1);
+        globalAllocator.free((uint8_t*)ptr - header->prefixSize, header->tag,
+                             globalAllocator.userData);
+    }
+}
+
+void* nk::utils::memZeroAlloc(size_t num, size_t size, NkMemoryTag tag,
+                              size_t alignment) {
+    void* ptr = memRealloc(nullptr, size * num, tag, alignment);
+    if (ptr) {
+        memset(ptr, 0, size * num);
+    }
+    return ptr;
+}
+
+NkMemoryStats nk::utils::memoryStats() {
+    NkMemoryStats stats;
+    for (uint32_t index = 0; index < (uint32_t)NkMemoryTag::COUNT; ++index) {
+        readCounters(memoryCounters[index], stats.tags[index]);
+    }
+    readCounters(memoryCounters[(uint32_t)NkMemoryTag::COUNT], stats.total);
+    return stats;
+}
+
+const char* nk::utils::memoryTagName(NkMemoryTag tag) {
+    return tag < NkMemoryTag::COUNT ? memoryTagNames[(uint32_t)tag]
+                                    : "unknown";
+}
@@ -0,0 +1,189 @@
+#include "../utils.h"
+#include "null_canvas.h"
+#include "null_structs.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace nk {
+    namespace hid {
+
+        extern NkHID* create(NkApp* app);
+        extern bool destroy(NkHID* hid);
+        extern void update(NkHID* hid, NkApp* app);
+
+    } // namespace hid
+} // namespace nk
+
+static bool parseSize(const char* str, uint32_t* width, uint32_t* height) {
+    uint32_t parsedWidth = 0;
+    uint32_t parsedHeight = 0;
+    if (sscanf(str, "%ux%u", &parsedWidth, &parsedHeight) != 2 ||
+        parsedWidth == 0 || parsedHeight == 0) {
+        return false;
+    }
+    *width = parsedWidth;
+    *height = parsedHeight;
+    return true;
+}
+
+static bool parseResizes(NkApp* app, const char* str) {
+    // FRAME:WIDTHxHEIGHT separated by commas, kept sorted by frame.
+    while (*str) {
+        NkNullResize resize = {};
+        int length = 0;
+        if (app->resizeNum >= NK_NULL_MAX_RESIZES ||
+            sscanf(str, "%u:%ux%u%n", &resize.frameIndex, &resize.width,
+                   &resize.height, &length) != 3 ||
+            resize.width == 0 || resize.height == 0) {
+            return false;
+        }
+        uint32_t index = app->resizeNum++;
+        for (; index > 0 &&
+               app->resizes[index - 1].frameIndex > resize.frameIndex;
+             --index) {
+            app->resizes[index] = app->resizes[index - 1];
+        }
+        app->resizes[index] = resize;
+        str += length;
+        if (*str == ',') {
+            str++;
+        }
+    }
+    return true;
+}
+
+// The headless app is configured from the environment so unmodified
+// programs can run in CI:
+// NK_HEADLESS_SIZE=WIDTHxHEIGHT overrides the virtual window size.
+// NK_HEADLESS_RESIZE=FRAME:WIDTHxHEIGHT,... resizes it at those frames.
+// NK_HEADLESS_FPS=N advances a virtual clock 1/N seconds per update.
+// NK_HEADLESS_FRAMES=N quits after N updates.
+static void readHeadlessConfig(NkApp* app, bool allowResize) {
+    const char* size = getenv("NK_HEADLESS_SIZE");
+    if (size && !parseSize(size, &app->windowWidth, &app->windowHeight)) {
+        NK_LOG("WARNING: Ignoring NK_HEADLESS_SIZE=%s, expected "
+               "WIDTHxHEIGHT.",
+               size);
+    }
+    const char* resizes = getenv("NK_HEADLESS_RESIZE");
+    if (resizes && !allowResize) {
+        NK_LOG("WARNING: Ignoring NK_HEADLESS_RESIZE, the app doesn't allow "
+               "resizing.");
+    } else if (resizes && !parseResizes(app, resizes)) {
+        NK_LOG("WARNING: Ignoring NK_HEADLESS_RESIZE=%s, expected up to %u "
+               "FRAME:WIDTHxHEIGHT entries separated by commas.",
+               resizes, NK_NULL_MAX_RESIZES);
+        app->resizeNum = 0;
+    }
+    const char* fps = getenv("NK_HEADLESS_FPS");
+    uint32_t value = 0;
+    if (fps) {
+        if (sscanf(fps, "%u", &value) == 1 && value > 0) {
+            app->frameClock.virtualFrameTime = 1000000000ULL / value;
+        } else {
+            NK_LOG("WARNING: Ignoring NK_HEADLESS_FPS=%s.", fps);
+        }
+    }
+    const char* frames = getenv("NK_HEADLESS_FRAMES");
+    if (frames) {
+        if (sscanf(frames, "%u", &value) == 1) {
+            app->maxFrameNum = value;
+        } else {
+            NK_LOG("WARNING: Ignoring NK_HEADLESS_FRAMES=%s.", frames);
+        }
+    }
+}
+
+NkApp* nk::app::create(const NkAppInfo& info) {
+    nk::utils::initMemoryFunctions(info.allocator, info.reallocFunc,
+                                   info.freeFunc);
+    NkApp* app =
+        (NkApp*)nk::utils::memZeroAlloc(1, sizeof(NkApp), NkMemoryTag::APP);
+    if (!app) {
+        nk::utils::destroyMemoryFunctions();
+        return nullptr;
+    }
+    nk::utils::initJobs(info.jobWorkerNum);
+    nk::utils::initFrameArena();
+    nk::utils::initProfiler();
+
+    // There is no window, the size is only used for the canvas resolution.
+    app->windowWidth = info.width;
+    app->windowHeight = info.height;
+    readHeadlessConfig(app, info.allowResize);
+    app->hid = nk::hid::create(app);
+    app->canvas = nk::canvas::create(app, info.allowResize);
+    return app;
+}
+
+bool nk::app::destroy(NkApp* app) {
+    if (app) {
+        nk::utils::destroyJobs();
+        nk::canvas::destroy(app->canvas);
+        nk::hid::destroy(app->hid);
+        nk::utils::memFree(app, NkMemoryTag::APP);
+        nk::utils::destroyFrameArena();
+        nk::utils::destroyProfiler();
+        nk::utils::destroyMemoryFunctions();
+        nk::utils::flushLog();
+        return true;
+    }
+    return false;
+}
+
+void nk::app::update(NkApp* app) {
+    app->frameClock.tick();
+    app->shouldResize = false;
+    if (app->nextResize < app->resizeNum &&
+        app->resizes[app->nextResize].frameIndex <= app->frameIndex) {
+        const NkNullResize& resize = app->resizes[app->nextResize++];
+        app->windowWidth = resize.width;
+        app->windowHeight = resize.height;
+        app->shouldResize = true;
+    }
+    nk::hid::update(app->hid, app);
+    app->frameIndex++;
+    if (app->maxFrameNum != 0 && app->frameIndex >= app->maxFrameNum) {
+        app->shouldQuit = true;
+    }
+}
+
+bool nk::app::shouldQuit(const NkApp* app) { return app->shouldQuit; }
+
+uint32_t nk::app::windowWidth(const NkApp* app) { return app->windowWidth; }
+
+uint32_t nk::app::windowHeight(const NkApp* app) { return app->windowHeight; }
+
+bool nk::app::shouldResize(const NkApp* app, uint32_t* newWidth,
+                           uint32_t* newHeight) {
+    if (app->shouldResize) {
+        if (newWidth)
+            *newWidth = app->windowWidth;
+        if (newHeight)
+            *newHeight = app->windowHeight;
+        return true;
+    }
+    return false;
+}
+
+NkHID* nk::app::hid(NkApp* app) { return app->hid; }
+
+void nk::app::quit(NkApp* app) { app->shouldQuit = true; }
+
+double nk::app::frameTime(const NkApp* app) {
+    return app->frameClock.frameTime;
+}
+
+double nk::app::timeSinceUpdate(const NkApp* app) {
+    return app->frameClock.timeSinceTick();
+}
+
+void nk::app::limitFrameRate(NkApp* app, double targetFrameTime) {
+    app->frameClock.limit(targetFrameTime);
+}
+
+NkFrameLimiterStats nk::app::frameLimiterStats(const NkApp* app) {
+    return app->frameClock.stats();
+}
+
+NkCanvas* nk::app::canvas(NkApp* app) { return app->canvas; }
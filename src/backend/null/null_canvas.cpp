@@ -0,0 +1,371 @@
+#include "null_canvas.h"
+#include <nk/app.h>
+
+NkImage* nk::null::createImage(uint32_t width, uint32_t height,
+                               bool renderTarget) {
+    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage),
+                                                       NkMemoryTag::IMAGE);
+    if (!image) {
+        return nullptr;
+    }
+    image->width = (float)width;
+    image->height = (float)height;
+    image->renderTarget = renderTarget;
+    return image;
+}
+
+void nk::null::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
+    if (canvas->renderTarget) {
+        const float* color = canvas->clearColor;
+        canvas->renderTarget->clearColor =
+            NK_COLOR_RGBA_FLOAT(color[0], color[1], color[2], color[3]);
+    }
+}
+
+NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
+    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas),
+                                                          NkMemoryTag::CANVAS);
+    if (!canvas) {
+        return nullptr;
+    }
+    canvas->base.init(canvas, (float)app->windowWidth,
+                      (float)app->windowHeight);
+    canvas->app = app;
+    canvas->clearColor[0] = 0.0f;
+    canvas->clearColor[1] = 0.0f;
+    canvas->clearColor[2] = 0.0f;
+    canvas->clearColor[3] = 1.0f;
+    return canvas;
+}
+
+bool nk::canvas::destroy(NkCanvas* canvas) {
+    if (canvas) {
+        canvas->base.destroy(canvas);
+        nk::utils::memFree(canvas, NkMemoryTag::CANVAS);
+        return true;
+    }
+    return false;
+}
+
+void nk::canvas::identity(NkCanvas* canvas) { canvas->base.loadIdentity(); }
+
+void nk::canvas::pushMatrix(NkCanvas* canvas) { canvas->base.pushMatrix(); }
+
+void nk::canvas::popMatrix(NkCanvas* canvas) { canvas->base.popMatrix(); }
+
+void nk::canvas::translate(NkCanvas* canvas, float x, float y) {
+    canvas->base.translate(x, y);
+}
+
+void nk::canvas::rotate(NkCanvas* canvas, float rad) {
+    canvas->base.rotate(rad);
+}
+
+void nk::canvas::scale(NkCanvas* canvas, float x, float y) {
+    canvas->base.scale(x, y);
+}
+
+void nk::canvas::pushClipRect(NkCanvas* canvas, float x, float y, float width,
+                              float height) {
+    canvas->base.pushClipRect(x, y, width, height);
+}
+
+void nk::canvas::popClipRect(NkCanvas* canvas) { canvas->base.popClipRect(); }
+
+void nk::canvas::setBlendMode(NkCanvas* canvas, NkBlendMode blendMode) {
+    canvas->base.setBlendMode(blendMode);
+}
+
+void nk::canvas::drawLine(NkCanvas* canvas, float x0, float y0, float x1,
+                          float y1, float lineWidth, uint32_t color) {
+    canvas->base.drawLine(x0, y0, x1, y1, lineWidth, color);
+}
+
+void nk::canvas::drawRect(NkCanvas* canvas, float x, float y, float width,
+                          float height, uint32_t color) {
+    canvas->base.drawRect(x, y, width, height, color);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, NkImage* image) {
+    canvas->base.drawImage(x, y, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, color, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, NkImage* image) {
+    canvas->base.drawImage(x, y, width, height, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, uint32_t color, NkImage* image) {
+    canvas->base.drawImage(x, y, width, height, color, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float frameX,
+                           float frameY, float frameWidth, float frameHeight,
+                           uint32_t color, NkImage* image) {
+    canvas->base.drawImage(x, y, frameX, frameY, frameWidth, frameHeight, color,
+                           image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, float frameX, float frameY,
+                           float frameWidth, float frameHeight, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, width, height, frameX, frameY, frameWidth,
+                           frameHeight, color, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, transform, color, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, float frameX, float frameY,
+                           float frameWidth, float frameHeight,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, width, height, frameX, frameY, frameWidth,
+                           frameHeight, transform, color, image);
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteDesc* sprites,
+                            uint32_t count, NkImage* image) {
+    canvas->base.drawImages(sprites, count, image);
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteArrays& sprites,
+                            uint32_t count, NkImage* image) {
+    canvas->base.drawImages(sprites, count, image);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectDesc* rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectArrays& rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawPerfOverlay(NkCanvas* canvas, float x, float y) {
+    canvas->base.drawPerfOverlay(x, y);
+}
+
+void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
+                            float a) {
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
+    canvas->clearColor[0] = r;
+    canvas->clearColor[1] = g;
+    canvas->clearColor[2] = b;
+    canvas->clearColor[3] = a;
+    canvas->base.beginFrame(canvas);
+}
+
+void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
+                            float g, float b, float a) {
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
+    canvas->clearColor[0] = r;
+    canvas->clearColor[1] = g;
+    canvas->clearColor[2] = b;
+    canvas->clearColor[3] = a;
+    canvas->renderTarget = renderTarget;
+    canvas->base.beginFrame(canvas);
+}
+
+void nk::canvas::endFrame(NkCanvas* canvas) {
+    NK_CANVAS_STAT_SCOPED_TIMER(canvas->base, endFrameTime);
+    canvas->base.endFrame(canvas, canvas->renderTarget);
+    canvas->base.capture.writeFrame(canvas->base, canvas->renderTarget,
+                                    canvas->clearColor);
+    if (!canvas->base.skipFrame(canvas->renderTarget, canvas->clearColor)) {
+        nk::null::drawFrame(canvas, canvas->base.currentFrameIndex);
+    }
+    canvas->base.swapFrame(canvas);
+    canvas->renderTarget = nullptr;
+    NK_PROFILER_END_EVENT();
+}
+
+void nk::canvas::present(NkCanvas* canvas) {
+    // Same as resizing the swap chain on the other backends.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (nk::app::shouldResize(canvas->app, &width, &height)) {
+        canvas->base.resolution[0] = (float)width;
+        canvas->base.resolution[1] = (float)height;
+        canvas->base.invalidateFrameHash();
+    }
+}
+
+const NkCanvasFrameStats& nk::canvas::frameStats(NkCanvas* canvas) {
+    return canvas->base.lastFrameStats;
+}
+
+void nk::canvas::setSkipIdenticalFrames(NkCanvas* canvas, bool enabled) {
+    canvas->base.skipIdenticalFrames = enabled;
+    canvas->base.invalidateFrameHash();
+}
+
+bool nk::canvas::beginCapture(NkCanvas* canvas, const char* path) {
+    return canvas->base.capture.begin(path);
+}
+
+void nk::canvas::endCapture(NkCanvas* canvas) { canvas->base.capture.end(); }
+
+bool nk::canvas::readPixelsAsync(NkCanvas* canvas, NkImage* image,
+                                 NkReadPixelsFunc callback, void* userData) {
+    return canvas->base.readbacks.push(canvas, image, callback, userData);
+}
+
+bool nk::canvas::beginVideoCapture(NkCanvas* canvas, const char* path,
+                                   NkVideoFormat format, uint32_t frameRate) {
+    return canvas->base.video.begin(canvas->base, path, format, frameRate);
+}
+
+bool nk::canvas::captureVideoFrame(NkCanvas* canvas, NkImage* renderTarget) {
+    return canvas->base.video.captureFrame(canvas->base, renderTarget);
+}
+
+void nk::canvas::endVideoCapture(NkCanvas* canvas) {
+    canvas->base.video.end(canvas->base);
+}
+
+float nk::canvas::viewWidth(NkCanvas* canvas) {
+    return canvas->base.resolution[0];
+}
+
+float nk::canvas::viewHeight(NkCanvas* canvas) {
+    return canvas->base.resolution[1];
+}
+
+NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
+                                             uint32_t height) {
+    NkImage* image = nk::null::createImage(width, height, true);
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, nullptr,
+                                      NkImageFormat::R8G8B8A8_UNORM, true);
+    return image;
+}
+
+NkImage* nk::canvas::createImage(NkCanvas* canvas, uint32_t width,
+                                 uint32_t height, const void* pixels,
+                                 NkImageFormat format) {
+    NkImage* image = nk::null::createImage(width, height, false);
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, pixels, format, false);
+    return image;
+}
+
+bool nk::canvas::destroyImage(NkCanvas* canvas, NkImage* image) {
+    if (image) {
+        canvas->base.invalidateFrameHash();
+        canvas->base.capture.imageDestroyed(image);
+        canvas->base.readbacks.imageDestroyed(image);
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+        canvas->base.frameTextureAtlas.removeImage(image);
+#endif
+        nk::utils::memFree(image->pixels, NkMemoryTag::IMAGE);
+        nk::utils::memFree(image, NkMemoryTag::IMAGE);
+        return true;
+    }
+    return false;
+}
+
+float nk::img::width(NkImage* image) { return image->width; }
+
+float nk::img::height(NkImage* image) { return image->height; }
+
+void nk::canvas_internal::initVertexBuffer(NkCanvasVertexBuffer* vertexBuffer,
+                                           size_t bufferSize) {}
+
+void nk::canvas_internal::initIndexBuffer(void** gpuIndexBuffer) {}
+
+void nk::canvas_internal::destroyVertexBuffer(
+    NkCanvasVertexBuffer* vertexBuffer) {}
+
+void nk::canvas_internal::destroyIndexBuffer(void** gpuIndexBuffer) {}
+
+void nk::canvas_internal::signalFrameSyncPoint(NkCanvas* canvas,
+                                               NkGPUHandle gpuSyncPoint,
+                                               uint64_t value) {}
+
+void nk::canvas_internal::waitFrameSyncPoint(NkGPUHandle gpuSyncPoint,
+                                             uint64_t value) {}
+
+void nk::canvas_internal::initFrameSyncPoint(NkGPUHandle* gpuSyncPoint) {}
+
+void nk::canvas_internal::destroyFrameSyncPoint(NkGPUHandle* gpuSyncPoint) {}
+
+NkCanvasBase* nk::canvas_internal::canvasBase(NkCanvas* canvas) {
+    return &canvas->base;
+}
+
+// Nothing is rasterized, so a read fills the image's CPU buffer with the
+// clear color. Every pending read of the image shares that buffer and sees
+// the color of the latest read.
+NkGPUHandle nk::canvas_internal::beginReadback(NkCanvas* canvas,
+                                               NkImage* image) {
+    if (!image->renderTarget) {
+        return nullptr;
+    }
+    size_t pixelNum = (size_t)image->width * (size_t)image->height;
+    if (!image->pixels) {
+        image->pixels = (uint32_t*)nk::utils::memRealloc(
+            nullptr, pixelNum * sizeof(uint32_t), NkMemoryTag::IMAGE);
+        if (!image->pixels) {
+            return nullptr;
+        }
+    }
+    for (size_t index = 0; index < pixelNum; ++index) {
+        image->pixels[index] = image->clearColor;
+    }
+    return (NkGPUHandle)image;
+}
+
+const void* nk::canvas_internal::mapReadback(NkGPUHandle gpuReadback,
+                                             uint32_t* rowPitch) {
+    NkImage* image = (NkImage*)gpuReadback;
+    *rowPitch = (uint32_t)image->width * sizeof(uint32_t);
+    return image->pixels;
+}
+
+void nk::canvas_internal::destroyReadback(NkGPUHandle gpuReadback) {}
+
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+void nk::canvas_internal::initTextureAtlasResource(
+    NkCanvas* canvas, NkTextureAtlas& textureAtlas) {
+    textureAtlas.gpuTexture = (void*)nk::null::createImage(
+        textureAtlas.width, textureAtlas.height, true);
+}
+
+void nk::canvas_internal::destroyTextureAtlasResource(
+    NkTextureAtlas& textureAtlas) {
+    nk::utils::memFree(textureAtlas.gpuTexture, NkMemoryTag::IMAGE);
+    textureAtlas.gpuTexture = nullptr;
+}
+
+void nk::canvas_internal::setTextureAtlasState(NkImage* image,
+                                               const NkTextureAtlasRect& rect) {
+    image->state |= NK_IMAGE_BIT_TEXTURE_ATLAS;
+    image->rect = rect;
+}
+
+void nk::canvas_internal::clearTextureAtlasState(NkImage* image) {
+    image->state &= ~NK_IMAGE_BIT_TEXTURE_ATLAS;
+}
+
+bool nk::canvas_internal::isImageInTextureAtlas(NkImage* image) {
+    return (image->state & NK_IMAGE_BIT_TEXTURE_ATLAS) > 0;
+}
+
+const NkTextureAtlasRect& nk::canvas_internal::textureRect(NkImage* image) {
+    return image->rect;
+}
+#endif
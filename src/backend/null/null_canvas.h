@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../canvas_internal.h"
+#include "../utils.h"
+#include "null_structs.h"
+
+#define NK_IMAGE_BIT_TEXTURE_ATLAS 0b0001
+
+// The null backend runs the shared canvas code without a GPU. Images only keep
+// their size and frames are dropped in endFrame. Nothing is rasterized, so a
+// render target only remembers the clear color of the last frame drawn to it.
+struct NkImage {
+    float width;
+    float height;
+    bool renderTarget;
+    uint32_t clearColor;
+    uint32_t* pixels; // Allocated by the first read of a render target
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+    uint32_t state;
+    NkTextureAtlasRect rect;
+#endif
+};
+
+struct NkCanvas {
+    NkCanvasBase base;
+    NkApp* app;
+    NkImage* renderTarget;
+    float clearColor[4];
+};
+
+namespace nk {
+
+    namespace canvas {
+        NkCanvas* create(NkApp* app, bool allowResize = true);
+        bool destroy(NkCanvas* canvas);
+    } // namespace canvas
+
+    namespace null {
+        NkImage* createImage(uint32_t width, uint32_t height,
+                             bool renderTarget);
+        void drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex);
+    } // namespace null
+
+} // namespace nk
@@ -0,0 +1,10 @@
+#include "../hid_internal.h"
+#include "../utils.h"
+#include "null_structs.h"
+#include <nk/hid.h>
+
+void nk::hid::update(NkHID* hid, NkApp* app) { nk::hid::applyEvents(hid); }
+
+void nk::hid::showCursor(NkHID* hid, bool visible) {
+    hid->mouse.visible = visible;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../frame_clock.h"
+#include <nk/canvas.h>
+#include <nk/hid.h>
+
+#define NK_NULL_MAX_RESIZES 16
+
+// A synthetic resize of the virtual window at the start of a frame.
+struct NkNullResize {
+    uint32_t frameIndex;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct NkApp {
+    NkCanvas* canvas;
+    NkHID* hid;
+    NkFrameClock frameClock;
+    uint32_t windowWidth;
+    uint32_t windowHeight;
+    uint32_t frameIndex;
+    uint32_t maxFrameNum; // Zero runs until nk::app::quit
+    NkNullResize resizes[NK_NULL_MAX_RESIZES];
+    uint32_t resizeNum;
+    uint32_t nextResize;
+    bool shouldResize;
+    bool shouldQuit;
+};
@@ -0,0 +1,41 @@
+#include "../utils.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+void nk::utils::exit(uint32_t exitCode) {
+    flushLog();
+    ::exit(exitCode);
+}
+
+void nk::utils::logWrite(const char* message) { fputs(message, stderr); }
+
+size_t nk::utils::bsf(size_t value) {
+    if (value == 0)
+        return 64;
+    return __builtin_ctzll(value);
+}
+
+size_t nk::utils::bsr(size_t value) {
+    if (value == 0)
+        return 64;
+    return 63 - __builtin_clzll(value);
+}
+
+size_t nk::utils::popcnt(size_t value) { return __builtin_popcountll(value); }
+
+uint64_t nk::utils::timeNs() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+void nk::utils::sleepNs(uint64_t ns) {
+    struct timespec time;
+    time.tv_sec = (time_t)(ns / 1000000000ULL);
+    time.tv_nsec = (long)(ns % 1000000000ULL);
+    // Keep sleeping for the remainder when a signal interrupts the sleep.
+    while (nanosleep(&time, &time) != 0 && errno == EINTR) {
+    }
+}
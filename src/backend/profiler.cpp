@@ -0,0 +1,262 @@
+#include "profiler.h"
+#include "utils.h"
+#include <nk/profiler.h>
+#include <stdio.h>
+
+#if NK_PROFILER_ENABLED
+
+#include <atomic>
+#include <mutex>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define NK_PROFILER_RDTSC_ENABLED 1
+#endif
+
+struct NkProfilerThreadBuffer {
+    NkProfilerEventRecord* records;
+    std::atomic<uint64_t> writeIndex;
+    std::atomic<uint64_t> readIndex;
+    uint32_t threadId;
+};
+
+static NkProfilerThreadBuffer* threadBuffers[NK_PROFILER_MAX_THREADS] = {};
+static std::atomic<uint32_t> threadBufferNum{0};
+// Bumped when the last app frees the buffers, so threads drop the buffer
+// they cached and create a new one.
+static std::atomic<uint32_t> threadBufferGeneration{0};
+static std::mutex threadBufferMutex;
+static uint32_t profilerRefCount = 0;
+static std::once_flag timeBaseFlag;
+static uint64_t timeBaseTicks = 0;
+static uint64_t timeBaseNs = 0;
+static thread_local NkProfilerThreadBuffer* currentThreadBuffer = nullptr;
+static thread_local uint32_t currentThreadGeneration = 0;
+static thread_local bool currentThreadDisabled = false;
+
+static inline uint64_t readTicks() {
+#if NK_PROFILER_RDTSC_ENABLED
+    return __rdtsc();
+#else
+    return nk::utils::timeNs();
+#endif
+}
+
+static NkProfilerThreadBuffer* createThreadBuffer() {
+    std::call_once(timeBaseFlag, []() {
+        timeBaseNs = nk::utils::timeNs();
+        timeBaseTicks = readTicks();
+    });
+    std::lock_guard<std::mutex> lock(threadBufferMutex);
+    uint32_t threadId = threadBufferNum.load(std::memory_order_relaxed);
+    if (threadId >= NK_PROFILER_MAX_THREADS) {
+        NK_LOG("WARNING: Profiler thread limit reached. Events from this "
+               "thread will be ignored.");
+        currentThreadDisabled = true;
+        return nullptr;
+    }
+
+    NkProfilerThreadBuffer* buffer =
+        (NkProfilerThreadBuffer*)nk::utils::memZeroAlloc(
+            1, sizeof(NkProfilerThreadBuffer), NkMemoryTag::PROFILER);
+    NK_ASSERT_EXIT(buffer != nullptr,
+                   "Error: Failed to allocate profiler thread buffer.");
+    buffer->records = (NkProfilerEventRecord*)nk::utils::memZeroAlloc(
+        NK_PROFILER_THREAD_EVENT_CAPACITY, sizeof(NkProfilerEventRecord),
+        NkMemoryTag::PROFILER);
+    NK_ASSERT_EXIT(buffer->records != nullptr,
+                   "Error: Failed to allocate profiler event records.");
+    buffer->threadId = threadId;
+    threadBuffers[threadId] = buffer;
+    threadBufferNum.store(threadId + 1, std::memory_order_release);
+    return buffer;
+}
+
+static inline void recordEvent(const char* name) {
+    NkProfilerThreadBuffer* buffer = currentThreadBuffer;
+    uint32_t generation =
+        threadBufferGeneration.load(std::memory_order_relaxed);
+    if (currentThreadGeneration != generation) {
+        currentThreadGeneration = generation;
+        currentThreadDisabled = false;
+        buffer = currentThreadBuffer = nullptr;
+    }
+    if (!buffer) {
+        if (currentThreadDisabled) {
+            return;
+        }
+        buffer = currentThreadBuffer = createThreadBuffer();
+        if (!buffer) {
+            return;
+        }
+    }
+    // Only the owning thread writes, so a relaxed load is enough. The reader
+    // uses the release store to know which records are complete.
+    uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+    NkProfilerEventRecord& record =
+        buffer->records[index & (NK_PROFILER_THREAD_EVENT_CAPACITY - 1)];
+    // Orders the store that published index before the slot is rewritten,
+    // so a reader that sees the new fields also sees the index that
+    // invalidates the old record.
+    std::atomic_thread_fence(std::memory_order_release);
+    record.timestamp.store(readTicks(), std::memory_order_relaxed);
+    record.name.store(name, std::memory_order_relaxed);
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+static void writeEscapedString(FILE* file, const char* str) {
+    for (; *str; ++str) {
+        char c = *str;
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if ((unsigned char)c < 0x20) {
+            fputc(' ', file);
+        } else {
+            fputc(c, file);
+        }
+    }
+}
+
+NkProfilerEvent::NkProfilerEvent(const char* name) { recordEvent(name); }
+
+NkProfilerEvent::~NkProfilerEvent() { recordEvent(nullptr); }
+
+void nk::profiler_internal::beginEvent(const char* name) {
+    recordEvent(name);
+}
+
+void nk::profiler_internal::endEvent() { recordEvent(nullptr); }
+
+void nk::utils::initProfiler() {
+    std::lock_guard<std::mutex> lock(threadBufferMutex);
+    profilerRefCount++;
+}
+
+void nk::utils::destroyProfiler() {
+    std::lock_guard<std::mutex> lock(threadBufferMutex);
+    NK_ASSERT(profilerRefCount > 0, "Error: Profiler isn't running.");
+    if (--profilerRefCount > 0) {
+        return;
+    }
+    uint32_t bufferNum = nk::utils::min<uint32_t>(
+        threadBufferNum.load(std::memory_order_acquire),
+        NK_PROFILER_MAX_THREADS);
+    for (uint32_t bufferIndex = 0; bufferIndex < bufferNum; ++bufferIndex) {
+        NkProfilerThreadBuffer* buffer = threadBuffers[bufferIndex];
+        if (buffer) {
+            nk::utils::memFree(buffer->records, NkMemoryTag::PROFILER);
+            nk::utils::memFree(buffer, NkMemoryTag::PROFILER);
+            threadBuffers[bufferIndex] = nullptr;
+        }
+    }
+    threadBufferNum.store(0, std::memory_order_relaxed);
+    threadBufferGeneration.fetch_add(1, std::memory_order_release);
+}
+
+bool nk::profiler::writeChromeTrace(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        NK_LOG("Error: Failed to open %s for writing the profiler trace.",
+               path);
+        return false;
+    }
+
+    // Ticks are converted to microseconds using the elapsed wall time since
+    // the first recorded event. That way rdtsc doesn't need a calibration
+    // loop at startup.
+    double ticksPerUs = 1.0e-3;
+    uint64_t nowNs = nk::utils::timeNs();
+    uint64_t nowTicks = readTicks();
+    if (nowNs > timeBaseNs && nowTicks > timeBaseTicks) {
+        ticksPerUs = (double)(nowTicks - timeBaseTicks) /
+                     ((double)(nowNs - timeBaseNs) * 1.0e-3);
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    uint32_t bufferNum = nk::utils::min<uint32_t>(
+        threadBufferNum.load(std::memory_order_acquire),
+        NK_PROFILER_MAX_THREADS);
+    for (uint32_t bufferIndex = 0; bufferIndex < bufferNum; ++bufferIndex) {
+        NkProfilerThreadBuffer* buffer = threadBuffers[bufferIndex];
+        if (!buffer) {
+            continue;
+        }
+        fprintf(file,
+                "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                "\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+                first ? "" : ",", buffer->threadId, buffer->threadId);
+        first = false;
+
+        uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+        uint64_t start = buffer->readIndex.load(std::memory_order_relaxed);
+        if (end - start > NK_PROFILER_THREAD_EVENT_CAPACITY) {
+            start = end - NK_PROFILER_THREAD_EVENT_CAPACITY;
+        }
+        for (uint64_t index = start; index < end; ++index) {
+            uint64_t slot = index & (NK_PROFILER_THREAD_EVENT_CAPACITY - 1);
+            const NkProfilerEventRecord& record = buffer->records[slot];
+            uint64_t ticks = record.timestamp.load(std::memory_order_relaxed);
+            const char* name = record.name.load(std::memory_order_relaxed);
+            // The thread keeps recording while the trace is written. Once it
+            // has published index + capacity the slot may hold a newer
+            // record, so it's skipped.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (buffer->writeIndex.load(std::memory_order_relaxed) - index >=
+                NK_PROFILER_THREAD_EVENT_CAPACITY) {
+                continue;
+            }
+            double timestamp =
+                (double)(int64_t)(ticks - timeBaseTicks) / ticksPerUs;
+            if (name) {
+                fprintf(file, ",\n{\"name\":\"");
+                writeEscapedString(file, name);
+                fprintf(file,
+                        "\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                        timestamp, buffer->threadId);
+            } else {
+                fprintf(file,
+                        ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                        timestamp, buffer->threadId);
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+void nk::profiler::reset() {
+    uint32_t bufferNum = nk::utils::min<uint32_t>(
+        threadBufferNum.load(std::memory_order_acquire),
+        NK_PROFILER_MAX_THREADS);
+    for (uint32_t bufferIndex = 0; bufferIndex < bufferNum; ++bufferIndex) {
+        NkProfilerThreadBuffer* buffer = threadBuffers[bufferIndex];
+        if (buffer) {
+            buffer->readIndex.store(
+                buffer->writeIndex.load(std::memory_order_acquire),
+                std::memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+bool nk::profiler::writeChromeTrace(const char* path) {
+    NK_LOG("WARNING: Profiler is disabled. Build with the NK_PROFILER CMake "
+           "option to record events.");
+    return false;
+}
+
+void nk::profiler::reset() {}
+
+void nk::utils::initProfiler() {}
+
+void nk::utils::destroyProfiler() {}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NK_PROFILER_THREAD_EVENT_CAPACITY (1 << 16) // Must be power of two
+#define NK_PROFILER_MAX_THREADS           64
+
+// Fields are relaxed atomics so writeChromeTrace can read a ring while its
+// thread keeps recording. A null name marks an end event.
+struct NkProfilerEventRecord {
+    std::atomic<uint64_t> timestamp;
+    std::atomic<const char*> name;
+};
+
+struct NkProfilerEvent final {
+    NkProfilerEvent(const char* name);
+    ~NkProfilerEvent();
+};
+
+namespace nk {
+
+    namespace profiler_internal {
+
+        // Names are stored by pointer, they must be string literals or
+        // outlive the trace.
+        void beginEvent(const char* name);
+        void endEvent();
+
+    } // namespace profiler_internal
+
+} // namespace nk
@@ -45,19 +45,22 @@ bool NkTextureAtlasRect::canFit(uint32_t rectWidth, uint32_t rectHeight) {
 
 void NkTextureAtlasRectArray::init() {
     rects = (NkTextureAtlasRect*)nk::utils::memRealloc(
-        nullptr, sizeof(NkTextureAtlasRect) * 16);
+        nullptr, sizeof(NkTextureAtlasRect) * 16, NkMemoryTag::TEXTURE_ATLAS);
     rectNum = 0;
     rectMax = 16;
 }
 
-void NkTextureAtlasRectArray::destroy() { nk::utils::memFree(rects); }
+void NkTextureAtlasRectArray::destroy() {
+    nk::utils::memFree(rects, NkMemoryTag::TEXTURE_ATLAS);
+}
 
 void NkTextureAtlasRectArray::add(const NkTextureAtlasRect& rect) {
     if (rectNum + 1 > rectMax) {
         rectMax *= 2;
         NkTextureAtlasRect* newRects =
             (NkTextureAtlasRect*)nk::utils::memRealloc(
-                rects, sizeof(NkTextureAtlasRect) * rectMax);
+                rects, sizeof(NkTextureAtlasRect) * rectMax,
+                NkMemoryTag::TEXTURE_ATLAS);
         if (!newRects) {
             NK_PANIC("Error: realloc returned null");
             return;
@@ -86,9 +89,12 @@ NkTextureAtlasRect& NkTextureAtlasRectArray::operator[](uint32_t index) {
 
 void NkTextureAtlas::init(uint32_t width, uint32_t height) {
     new (&images) std::unordered_map<NkImage*, NkTextureAtlasRect>();
+    new (&previousImages) std::unordered_map<NkImage*, NkTextureAtlasRect>();
 
     this->width = width;
     this->height = height;
+    addedImageNum = 0;
+    evictedImageNum = 0;
     freeRects.init();
     usedRects.init();
     freeRects.add({0, 0, width, height});
@@ -100,12 +106,19 @@ void NkTextureAtlas::destroy() {
     freeRects.destroy();
     usedRects.destroy();
     destruct(images);
+    destruct(previousImages);
 }
 
 void NkTextureAtlas::reset() {
     freeRects.reset();
     usedRects.reset();
     freeRects.add({0, 0, width, height});
+    // Done here rather than when the atlas is uploaded, since a skipped
+    // frame never uploads and the images would keep their stale rects.
+    for (auto& entry : images) {
+        nk::canvas_internal::clearTextureAtlasState(entry.first);
+    }
+    previousImages.swap(images);
     images.clear();
 }
 
@@ -148,6 +161,12 @@ const NkTextureAtlasRect& NkTextureAtlas::addImage(NkImage* image) {
 	return rect;
 #else
     if (nk::canvas_internal::isImageInTextureAtlas(image)) {
+#if NK_PLATFORM_NULL && !defined(NDEBUG)
+        // Headless debug builds check that the cached rect belongs to this
+        // frame, a stale one would sample whatever was packed there since.
+        NK_ASSERT(images.find(image) != images.end(),
+                  "TextureAtlas: Image has a rect from a previous frame.");
+#endif
         return nk::canvas_internal::textureRect(image);
     }
     NkTextureAtlasRect rect{};
@@ -158,8 +177,20 @@ const NkTextureAtlasRect& NkTextureAtlas::addImage(NkImage* image) {
     rect.uOffset = (float)rect.x / width;
     rect.vOffset = (float)rect.y / height;
     images.insert({image, rect});
+    addedImageNum++;
+    auto previous = previousImages.find(image);
+    if (previous != previousImages.end() &&
+        (previous->second.x != rect.x || previous->second.y != rect.y)) {
+        evictedImageNum++;
+    }
     nk::canvas_internal::setTextureAtlasState(image, rect);
     return nk::canvas_internal::textureRect(image);
 #endif
 }
+
+void NkTextureAtlas::removeImage(NkImage* image) {
+    // reset() writes to every image it holds, so destroyed images must go.
+    images.erase(image);
+    previousImages.erase(image);
+}
 #endif
@@ -52,12 +52,18 @@ struct NkTextureAtlas {
     bool addRect(uint32_t rectWidth, uint32_t rectHeight, uint32_t id = 0,
                  NkTextureAtlasRect* result = nullptr);
     const NkTextureAtlasRect& addImage(NkImage* image);
+    void removeImage(NkImage* image);
 
     std::unordered_map<NkImage*, NkTextureAtlasRect> images;
+    // The images of the previous pass, to count the ones that come back at
+    // a different rect as evicted.
+    std::unordered_map<NkImage*, NkTextureAtlasRect> previousImages;
     NkTextureAtlasRectArray freeRects;
     NkTextureAtlasRectArray usedRects;
     uint32_t width;
     uint32_t height;
+    uint32_t addedImageNum;
+    uint32_t evictedImageNum;
     void* gpuTexture;
 };
 #endif
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <nk/app.h>
+#include <nk/utils.h>
 
 #ifdef max
 #undef max
@@ -15,24 +16,31 @@
 
 #if NK_PLATFORM_WINDOWS
 #define NK_DEBUG_BREAK() __debugbreak()
-#else
+#elif NK_PLATFORM_WEB
 #include <emscripten.h>
 #define NK_DEBUG_BREAK() EM_ASM(debugger)
+#else
+#define NK_DEBUG_BREAK()
 #endif
 
+#define NK_UTILS_DEFAULT_ALIGNMENT 16
+
 #define NK_LOG(fmt, ...) nk::utils::logFmt(fmt "\n", ##__VA_ARGS__)
 #define NK_PANIC(fmt, ...)                                                     \
     nk::utils::logFmt("PANIC: " fmt "\n", ##__VA_ARGS__);                      \
+    nk::utils::flushLog();                                                     \
     NK_DEBUG_BREAK();                                                          \
     nk::utils::exit(~0);
 #define NK_ASSERT(x, fmt, ...)                                                 \
     if (!(x)) {                                                                \
         nk::utils::logFmt("ASSERT: " fmt "\n", ##__VA_ARGS__);                 \
+        nk::utils::flushLog();                                                 \
         NK_DEBUG_BREAK();                                                      \
     }
 #define NK_ASSERT_EXIT(x, fmt, ...)                                            \
     if (!(x)) {                                                                \
         nk::utils::logFmt("ASSERT: " fmt "\n", ##__VA_ARGS__);                 \
+        nk::utils::flushLog();                                                 \
         NK_DEBUG_BREAK();                                                      \
         nk::utils::exit(~0);                                                   \
     }
@@ -42,40 +50,28 @@
         NK_DEBUG_BREAK();                                                      \
     }
 
-// NOTE(bitnenfer): To avoid linking issues with realeases of NK, Superluminal
-// API is disabled but it can be enabled manually when doing profiling of the
-// library.
-#if defined(NK_SUPERLUMINAL_ENABLED) && 0
-#include <Superluminal/PerformanceAPI.h>
-#define NK_PROFILER_COLOR(r, g, b) PERFORMANCEAPI_MAKE_COLOR(r, g, b)
-#define NK_PROFILER_BEGIN_EVENT(name)                                          \
-    PerformanceAPI_BeginEvent(name, nullptr, PERFORMANCEAPI_DEFAULT_COLOR)
-#define NK_PROFILER_BEGIN_EVENT_COLOR(name, color)                             \
-    PerformanceAPI_BeginEvent(name, nullptr, color)
-#define NK_PROFILER_END_EVENT() PerformanceAPI_EndEvent()
+#ifdef NK_PROFILER_ENABLED
+#undef NK_PROFILER_ENABLED
+#define NK_PROFILER_ENABLED 1
+#endif
+
+#define NK_PROFILER_CONCAT_IMPL(a, b) a##b
+#define NK_PROFILER_CONCAT(a, b)      NK_PROFILER_CONCAT_IMPL(a, b)
+
+// The built-in profiler records begin/end events into thread local ring
+// buffers. Use nk::profiler::writeChromeTrace from <nk/profiler.h> to dump
+// the recorded events and open them in chrome://tracing or Perfetto. Event
+// names are stored by pointer and must be string literals.
+#if NK_PROFILER_ENABLED
+#include "profiler.h"
+#define NK_PROFILER_BEGIN_EVENT(name) nk::profiler_internal::beginEvent(name)
+#define NK_PROFILER_END_EVENT()       nk::profiler_internal::endEvent()
 #define NK_PROFILER_SCOPED_EVENT(name)                                         \
-    NkProfilerEvent _profilerEvent##__COUNTER__(name)
-#define NK_PROFILER_SCOPED_EVENT_ARGS(name, ...)                               \
-    NkProfilerEvent _profilerEvent##__COUNTER__(                               \
-        nk::utils::tempString(name, __VA_ARGS__))
-#define NK_PROFILER_SCOPED_EVENT_COLOR_ARGS(name, color, ...)                  \
-    NkProfilerEvent _profilerEvent##__COUNTER__(                               \
-        nk::utils::tempString(name, __VA_ARGS__), color)
-struct NkProfilerEvent final {
-    NkProfilerEvent(const char* name) { NK_PROFILER_BEGIN_EVENT(name); }
-    NkProfilerEvent(const char* name, uint32_t color) {
-        NK_PROFILER_BEGIN_EVENT_COLOR(name, color);
-    }
-    ~NkProfilerEvent() { NK_PROFILER_END_EVENT(); }
-};
+    NkProfilerEvent NK_PROFILER_CONCAT(_profilerEvent, __COUNTER__)(name)
 #else
-#define NK_PROFILER_COLOR(r, g, b)
 #define NK_PROFILER_BEGIN_EVENT(name)
-#define NK_PROFILER_BEGIN_EVENT_COLOR(name, color)
 #define NK_PROFILER_END_EVENT()
 #define NK_PROFILER_SCOPED_EVENT(name)
-#define NK_PROFILER_SCOPED_EVENT_ARGS(name, ...)
-#define NK_PROFILER_SCOPED_EVENT_COLOR_ARGS(name, ...)
 #endif
 
 namespace nk {
@@ -83,16 +79,48 @@ namespace nk {
     namespace utils {
 
         void exit(uint32_t exitCode);
+        // Formats the message into a lock-free queue so it's safe to call
+        // from any thread. The queue is written out by flushLog.
         void logFmt(const char* fmt, ...);
+        void flushLog();
+        // Platform specific output of a single formatted message.
+        void logWrite(const char* message);
         const char* tempString(const char* fmt, ...);
         size_t bsf(size_t value);
         size_t bsr(size_t value);
         size_t popcnt(size_t value);
-        void initMemoryFunctions(NkReallocFunc reallocFunc,
+        void initMemoryFunctions(const NkAllocator& allocator,
+                                 NkReallocFunc reallocFunc,
                                  NkFreeFunc freeFunc);
-        void* memRealloc(void* ptr, size_t size);
-        void memFree(void* ptr);
-        void* memZeroAlloc(size_t num, size_t size);
+        // The allocator is installed by the first init. Later inits must
+        // pass the same one until the last destroy.
+        void destroyMemoryFunctions();
+        void* memRealloc(void* ptr, size_t size, NkMemoryTag tag,
+                         size_t alignment = NK_UTILS_DEFAULT_ALIGNMENT);
+        void memFree(void* ptr, NkMemoryTag tag);
+        void* memZeroAlloc(size_t num, size_t size, NkMemoryTag tag,
+                           size_t alignment = NK_UTILS_DEFAULT_ALIGNMENT);
+        // The frame arena is shared by every app and canvas. Only the last
+        // destroy frees it.
+        void initFrameArena();
+        // Starts a new frame in the frame arena if the caller already
+        // started one since the last reset, so several canvases advance it
+        // once per process frame. lastFrame is the caller's arena frame,
+        // zero initialise it. Allocations from the previous frame stay
+        // valid until the next reset.
+        void resetFrameArena(uint64_t* lastFrame);
+        void destroyFrameArena();
+        // The job system is shared by every app. Only the first init starts
+        // the workers and the last destroy stops them.
+        void initJobs(uint32_t workerNum);
+        void destroyJobs();
+        // Profiler event buffers are freed by the last destroy, so traces
+        // have to be written before the last app is destroyed.
+        void initProfiler();
+        void destroyProfiler();
+        // Sleeps the calling thread for at least ns nanoseconds. The wake up
+        // is only as precise as the scheduler.
+        void sleepNs(uint64_t ns);
         inline void* offsetPtr(void* Ptr, intptr_t Offset) {
             return (void*)((intptr_t)Ptr + Offset);
         }
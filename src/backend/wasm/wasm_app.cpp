@@ -8,6 +8,7 @@ namespace nk {
         extern NkHID* create(NkApp* app);
         extern bool destroy(NkHID* hid);
         extern void update(NkHID* hid, NkApp* app);
+        extern void pushEvent(NkHID* hid, const NkInputEvent& event);
 
     } // namespace hid
 
@@ -17,20 +18,24 @@ namespace nk {
     } // namespace canvas
 } // namespace nk
 
+// Browser events are pushed to the HID queue when they are dispatched, so
+// their timestamps aren't quantised to the frame.
 static EM_BOOL onHTMLKeyboardEvent(int eventType,
                                    const EmscriptenKeyboardEvent* keyEvent,
                                    void* userData) {
     NkApp* app = (NkApp*)userData;
-    NkWasmAppEvent event{};
-    event.keyboard.keyCode = keyEvent->keyCode;
+    NkInputEvent event{};
+    event.timeNs = nk::utils::timeNs();
+    event.keyCode = (NkKeyCode)keyEvent->keyCode;
     if (eventType == EMSCRIPTEN_EVENT_KEYDOWN) {
-        event.type = NkWasmAppEventType::KEYDOWN;
+        event.type = NkInputEventType::KEY_DOWN;
     } else if (eventType == EMSCRIPTEN_EVENT_KEYUP) {
-        event.type = NkWasmAppEventType::KEYUP;
-    }
-    if (app->eventBuffer.eventNum + 1 <= NK_APP_WASM_MAX_EVENTS) {
-        app->eventBuffer.events[app->eventBuffer.eventNum++] = event;
+        event.type = NkInputEventType::KEY_UP;
+    } else if (eventType == EMSCRIPTEN_EVENT_KEYPRESS) {
+        event.type = NkInputEventType::CHAR;
+        event.character = keyEvent->charCode;
     }
+    nk::hid::pushEvent(app->hid, event);
     return false;
 }
 
@@ -38,25 +43,40 @@ static EM_BOOL onHTMLMouseEvent(int eventType,
                                 const EmscriptenMouseEvent* mouseEvent,
                                 void* userData) {
     NkApp* app = (NkApp*)userData;
-    NkWasmAppEvent event{};
+    NkInputEvent event{};
+    event.timeNs = nk::utils::timeNs();
+    event.button = (NkMouseButton)mouseEvent->button;
+    event.mouseX = (float)mouseEvent->targetX;
+    event.mouseY = (float)mouseEvent->targetY;
     if (eventType == EMSCRIPTEN_EVENT_MOUSEMOVE) {
-        event.type = NkWasmAppEventType::MOUSEMOVE;
-        event.mouse.x = mouseEvent->targetX;
-        event.mouse.y = mouseEvent->targetY;
+        event.type = NkInputEventType::MOUSE_MOVE;
     } else if (eventType == EMSCRIPTEN_EVENT_MOUSEDOWN) {
-        event.type = NkWasmAppEventType::MOUSEDOWN;
-        event.mouse.button = mouseEvent->button;
-        event.mouse.x = mouseEvent->targetX;
-        event.mouse.y = mouseEvent->targetY;
+        event.type = NkInputEventType::MOUSE_DOWN;
     } else if (eventType == EMSCRIPTEN_EVENT_MOUSEUP) {
-        event.type = NkWasmAppEventType::MOUSEUP;
-        event.mouse.button = mouseEvent->button;
-        event.mouse.x = mouseEvent->targetX;
-        event.mouse.y = mouseEvent->targetY;
+        event.type = NkInputEventType::MOUSE_UP;
     }
-    if (app->eventBuffer.eventNum + 1 <= NK_APP_WASM_MAX_EVENTS) {
-        app->eventBuffer.events[app->eventBuffer.eventNum++] = event;
+    nk::hid::pushEvent(app->hid, event);
+    return false;
+}
+
+static EM_BOOL onHTMLWheelEvent(int eventType,
+                                const EmscriptenWheelEvent* wheelEvent,
+                                void* userData) {
+    NkApp* app = (NkApp*)userData;
+    // Convert to wheel notches with positive values going up and left, the
+    // same as the Windows backend.
+    float scale = 1.0f;
+    if (wheelEvent->deltaMode == DOM_DELTA_PIXEL) {
+        scale = 1.0f / 100.0f;
+    } else if (wheelEvent->deltaMode == DOM_DELTA_LINE) {
+        scale = 1.0f / 3.0f;
     }
+    NkInputEvent event{};
+    event.type = NkInputEventType::MOUSE_WHEEL;
+    event.timeNs = nk::utils::timeNs();
+    event.wheelDeltaX = -(float)wheelEvent->deltaX * scale;
+    event.wheelDeltaY = -(float)wheelEvent->deltaY * scale;
+    nk::hid::pushEvent(app->hid, event);
     return false;
 }
 
@@ -77,10 +97,17 @@ static EM_BOOL onHTMLCanvasResize(int eventType,
 }
 
 NkApp* nk::app::create(const NkAppInfo& info) {
-    nk::utils::initMemoryFunctions(info.reallocFunc, info.freeFunc);
-    NkApp* app = (NkApp*)nk::utils::memZeroAlloc(1, sizeof(NkApp));
-    if (!app)
+    nk::utils::initMemoryFunctions(info.allocator, info.reallocFunc,
+                                   info.freeFunc);
+    NkApp* app =
+        (NkApp*)nk::utils::memZeroAlloc(1, sizeof(NkApp), NkMemoryTag::APP);
+    if (!app) {
+        nk::utils::destroyMemoryFunctions();
         return nullptr;
+    }
+    nk::utils::initJobs(info.jobWorkerNum);
+    nk::utils::initFrameArena();
+    nk::utils::initProfiler();
 
     uint32_t windowWidth = info.width;
     uint32_t windowHeight = info.height;
@@ -113,9 +140,12 @@ NkApp* nk::app::create(const NkAppInfo& info) {
                                     &onHTMLKeyboardEvent);
     emscripten_set_keyup_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, app, 0,
                                   &onHTMLKeyboardEvent);
+    emscripten_set_keypress_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, app, 0,
+                                     &onHTMLKeyboardEvent);
     emscripten_set_mousedown_callback("#nk-canvas", app, 0, &onHTMLMouseEvent);
     emscripten_set_mouseup_callback("#nk-canvas", app, 0, &onHTMLMouseEvent);
     emscripten_set_mousemove_callback("#nk-canvas", app, 0, &onHTMLMouseEvent);
+    emscripten_set_wheel_callback("#nk-canvas", app, 0, &onHTMLWheelEvent);
 
     if (info.fullScreen) {
         emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, app, 0,
@@ -143,8 +173,13 @@ NkApp* nk::app::create(const NkAppInfo& info) {
 
 bool nk::app::destroy(NkApp* app) {
     if (app) {
+        nk::utils::destroyJobs();
         nk::hid::destroy(app->hid);
-        nk::utils::memFree(app);
+        nk::utils::memFree(app, NkMemoryTag::APP);
+        nk::utils::destroyFrameArena();
+        nk::utils::destroyProfiler();
+        nk::utils::destroyMemoryFunctions();
+        nk::utils::flushLog();
         return true;
     }
     return false;
@@ -152,8 +187,8 @@ bool nk::app::destroy(NkApp* app) {
 
 void nk::app::update(NkApp* app) {
     EM_ASM(if (window.frameTime) { window.frameTime.tick(); });
+    app->frameClock.tick();
     nk::hid::update(app->hid, app);
-    app->eventBuffer.eventNum = 0;
 }
 
 bool nk::app::shouldQuit(const NkApp* app) { return app->shouldQuit; }
@@ -171,4 +206,20 @@ NkHID* nk::app::hid(NkApp* app) { return app->hid; }
 
 void nk::app::quit(NkApp* app) { app->shouldQuit = true; }
 
+double nk::app::frameTime(const NkApp* app) {
+    return app->frameClock.frameTime;
+}
+
+double nk::app::timeSinceUpdate(const NkApp* app) {
+    return app->frameClock.timeSinceTick();
+}
+
+// The main loop runs from requestAnimationFrame, blocking it would only
+// delay the browser.
+void nk::app::limitFrameRate(NkApp* app, double targetFrameTime) {}
+
+NkFrameLimiterStats nk::app::frameLimiterStats(const NkApp* app) {
+    return app->frameClock.stats();
+}
+
 NkCanvas* nk::app::canvas(NkApp* app) { return app->canvas; }
@@ -21,10 +21,14 @@ void main() {
 static const char* spriteFragmentShader = R"(
 precision mediump float;
 uniform sampler2D mainTexture;
+uniform float premultiplyAlpha;
 varying vec2 fragTexCoord;
 varying vec4 fragColor;
 void main() {
-    gl_FragColor = texture2D(mainTexture, fragTexCoord) * fragColor;
+    vec4 color = texture2D(mainTexture, fragTexCoord) * fragColor;
+    // The multiply blend mode needs premultiplied alpha.
+    color.rgb *= mix(1.0, color.a, premultiplyAlpha);
+    gl_FragColor = color;
 }
 )";
 
@@ -137,9 +141,34 @@ void nk::webgl::destroyInstance(NkWebGLInstance* instance) {
 }
 NkWebGLInstance* nk::webgl::instance() { return &webGLinstance; }
 
+NkImage* nk::webgl::createImage(uint32_t width, uint32_t height,
+                                const void* pixels) {
+    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage),
+                                                       NkMemoryTag::IMAGE);
+    if (!image) {
+        return nullptr;
+    }
+
+    glGenTextures(1, &image->texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, image->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, pixels);
+
+    image->width = (float)width;
+    image->height = (float)height;
+
+    return image;
+}
+
 NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
     nk::webgl::createInstance();
-    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas));
+    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas),
+                                                          NkMemoryTag::CANVAS);
     if (!canvas) {
         return nullptr;
     }
@@ -157,10 +186,6 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
         compileGLShader(GL_FRAGMENT_SHADER, spriteFragmentShader);
     canvas->spriteProgram =
         compileGLProgram(canvas->spriteVertShader, canvas->spriteFragShader);
-    GLuint indexBuffer = (GLuint)canvas->base.gpuIndexBuffer;
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, NK_CANVAS_MAX_INDICES_BYTE_SIZE,
-                    canvas->base.indexBufferData());
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_SCISSOR_TEST);
@@ -185,7 +210,7 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
 bool nk::canvas::destroy(NkCanvas* canvas) {
     if (canvas) {
         canvas->base.destroy(canvas);
-        nk::utils::memFree(canvas);
+        nk::utils::memFree(canvas, NkMemoryTag::CANVAS);
     }
     return false;
 }
@@ -207,6 +232,17 @@ void nk::canvas::scale(NkCanvas* canvas, float x, float y) {
     canvas->base.scale(x, y);
 }
 
+void nk::canvas::pushClipRect(NkCanvas* canvas, float x, float y, float width,
+                              float height) {
+    canvas->base.pushClipRect(x, y, width, height);
+}
+
+void nk::canvas::popClipRect(NkCanvas* canvas) { canvas->base.popClipRect(); }
+
+void nk::canvas::setBlendMode(NkCanvas* canvas, NkBlendMode blendMode) {
+    canvas->base.setBlendMode(blendMode);
+}
+
 void nk::canvas::drawLine(NkCanvas* canvas, float x0, float y0, float x1,
                           float y1, float lineWidth, uint32_t color) {
     canvas->base.drawLine(x0, y0, x1, y1, lineWidth, color);
@@ -217,56 +253,161 @@ void nk::canvas::drawRect(NkCanvas* canvas, float x, float y, float width,
     canvas->base.drawRect(x, y, width, height, color);
 }
 
-#define FIXED_DRAW_IMAGE(x, y, ...)                                            \
-    if (!(image && image->framebuffer)) {                                      \
-        canvas->base.drawImage(x, y, __VA_ARGS__);                             \
-    } else {                                                                   \
-        canvas->base.pushMatrix();                                             \
-        canvas->base.translate(x, y + image->height);                          \
-        canvas->base.scale(1.0f, -1.0f);                                       \
-        canvas->base.drawImage(0, 0, __VA_ARGS__);                             \
-        canvas->base.popMatrix();                                              \
-    }
+// Render targets are stored bottom up. Their frames are mirrored vertically
+// in texture space, a negative frame height makes the base code write the
+// texture coordinates from bottom to top without touching the quad.
+static inline bool isImageFlipped(NkImage* image) {
+    return image && image->framebuffer;
+}
+
+static inline float flippedFrameY(NkImage* image, float frameY) {
+    return nk::img::height(image) - frameY;
+}
 
 void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, NkImage* image) {
-    FIXED_DRAW_IMAGE(x, y, image);
+    drawImage(canvas, x, y, 0xffffffff, image);
 }
 
 void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, uint32_t color,
                            NkImage* image) {
-    FIXED_DRAW_IMAGE(x, y, color, image);
+    if (!isImageFlipped(image)) {
+        canvas->base.drawImage(x, y, color, image);
+        return;
+    }
+    float width = nk::img::width(image);
+    float height = nk::img::height(image);
+    canvas->base.drawImage(x, y, width, height, 0, height, width, -height,
+                           color, image);
 }
 
 void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
                            float height, NkImage* image) {
-
-    FIXED_DRAW_IMAGE(x, y, width, height, image);
+    drawImage(canvas, x, y, width, height, 0xffffffff, image);
 }
 
 void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
                            float height, uint32_t color, NkImage* image) {
-    FIXED_DRAW_IMAGE(x, y, width, height, color, image);
+    if (!isImageFlipped(image)) {
+        canvas->base.drawImage(x, y, width, height, color, image);
+        return;
+    }
+    canvas->base.drawImage(x, y, width, height, 0, height, width, -height,
+                           color, image);
 }
 
 void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float frameX,
                            float frameY, float frameWidth, float frameHeight,
                            uint32_t color, NkImage* image) {
-    FIXED_DRAW_IMAGE(x, y, frameX, frameY, frameWidth, frameHeight, color,
-                     image);
+    if (!isImageFlipped(image)) {
+        canvas->base.drawImage(x, y, frameX, frameY, frameWidth, frameHeight,
+                               color, image);
+        return;
+    }
+    canvas->base.drawImage(x, y, nk::img::width(image), nk::img::height(image),
+                           frameX, flippedFrameY(image, frameY), frameWidth,
+                           -frameHeight, color, image);
 }
 
 void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
                            float height, float frameX, float frameY,
                            float frameWidth, float frameHeight, uint32_t color,
                            NkImage* image) {
-    FIXED_DRAW_IMAGE(x, y, width, height, frameX, frameY, frameWidth,
-                     frameHeight, color, image);
+    if (isImageFlipped(image)) {
+        frameY = flippedFrameY(image, frameY);
+        frameHeight = -frameHeight;
+    }
+    canvas->base.drawImage(x, y, width, height, frameX, frameY, frameWidth,
+                           frameHeight, color, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    if (!isImageFlipped(image)) {
+        canvas->base.drawImage(x, y, transform, color, image);
+        return;
+    }
+    float width = nk::img::width(image);
+    float height = nk::img::height(image);
+    canvas->base.drawImage(x, y, width, height, 0, height, width, -height,
+                           transform, color, image);
 }
 
-#undef FIXED_DRAW_IMAGE
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, float frameX, float frameY,
+                           float frameWidth, float frameHeight,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    if (isImageFlipped(image)) {
+        frameY = flippedFrameY(image, frameY);
+        frameHeight = -frameHeight;
+    }
+    canvas->base.drawImage(x, y, width, height, frameX, frameY, frameWidth,
+                           frameHeight, transform, color, image);
+}
+
+// Render target frames have to be flipped so they're drawn one by one.
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteDesc* sprites,
+                            uint32_t count, NkImage* image) {
+    if (!isImageFlipped(image)) {
+        canvas->base.drawImages(sprites, count, image);
+        return;
+    }
+    for (uint32_t index = 0; index < count; ++index) {
+        const NkSpriteDesc& sprite = sprites[index];
+        canvas->base.drawImage(sprite.x, sprite.y, sprite.width, sprite.height,
+                               sprite.frameX,
+                               flippedFrameY(image, sprite.frameY),
+                               sprite.frameWidth, -sprite.frameHeight,
+                               sprite.color, image);
+    }
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteArrays& sprites,
+                            uint32_t count, NkImage* image) {
+    if (!isImageFlipped(image)) {
+        canvas->base.drawImages(sprites, count, image);
+        return;
+    }
+    bool hasFrames = sprites.frameX && sprites.frameY && sprites.frameWidth &&
+                     sprites.frameHeight;
+    float imageWidth = nk::img::width(image);
+    float imageHeight = nk::img::height(image);
+    for (uint32_t index = 0; index < count; ++index) {
+        uint32_t color = sprites.color ? sprites.color[index] : 0xffffffff;
+        if (hasFrames) {
+            canvas->base.drawImage(
+                sprites.x[index], sprites.y[index], sprites.width[index],
+                sprites.height[index], sprites.frameX[index],
+                flippedFrameY(image, sprites.frameY[index]),
+                sprites.frameWidth[index], -sprites.frameHeight[index], color,
+                image);
+        } else {
+            canvas->base.drawImage(sprites.x[index], sprites.y[index],
+                                   sprites.width[index], sprites.height[index],
+                                   0, imageHeight, imageWidth, -imageHeight,
+                                   color, image);
+        }
+    }
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectDesc* rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectArrays& rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawPerfOverlay(NkCanvas* canvas, float x, float y) {
+    canvas->base.drawPerfOverlay(x, y);
+}
 
 void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
                             float a) {
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
     canvas->clearColor[0] = r;
     canvas->clearColor[1] = g;
     canvas->clearColor[2] = b;
@@ -276,6 +417,7 @@ void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
 
 void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
                             float g, float b, float a) {
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
     canvas->clearColor[0] = r;
     canvas->clearColor[1] = g;
     canvas->clearColor[2] = b;
@@ -285,14 +427,53 @@ void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
 }
 
 void nk::canvas::endFrame(NkCanvas* canvas) {
-    canvas->base.endFrame(canvas);
-    nk::webgl::drawFrame(canvas, canvas->base.currentFrameIndex);
+    NK_CANVAS_STAT_SCOPED_TIMER(canvas->base, endFrameTime);
+    canvas->base.endFrame(canvas, canvas->renderTarget);
+    canvas->base.capture.writeFrame(canvas->base, canvas->renderTarget,
+                                    canvas->clearColor);
+    if (!canvas->base.skipFrame(canvas->renderTarget, canvas->clearColor)) {
+        nk::webgl::drawFrame(canvas, canvas->base.currentFrameIndex);
+    }
     canvas->base.swapFrame(canvas);
     canvas->renderTarget = nullptr;
+    NK_PROFILER_END_EVENT();
 }
 
 void nk::canvas::present(NkCanvas* canvas) {}
 
+const NkCanvasFrameStats& nk::canvas::frameStats(NkCanvas* canvas) {
+    return canvas->base.lastFrameStats;
+}
+
+void nk::canvas::setSkipIdenticalFrames(NkCanvas* canvas, bool enabled) {
+    canvas->base.skipIdenticalFrames = enabled;
+    canvas->base.invalidateFrameHash();
+}
+
+bool nk::canvas::beginCapture(NkCanvas* canvas, const char* path) {
+    return canvas->base.capture.begin(path);
+}
+
+void nk::canvas::endCapture(NkCanvas* canvas) { canvas->base.capture.end(); }
+
+bool nk::canvas::readPixelsAsync(NkCanvas* canvas, NkImage* image,
+                                 NkReadPixelsFunc callback, void* userData) {
+    return canvas->base.readbacks.push(canvas, image, callback, userData);
+}
+
+bool nk::canvas::beginVideoCapture(NkCanvas* canvas, const char* path,
+                                   NkVideoFormat format, uint32_t frameRate) {
+    return canvas->base.video.begin(canvas->base, path, format, frameRate);
+}
+
+bool nk::canvas::captureVideoFrame(NkCanvas* canvas, NkImage* renderTarget) {
+    return canvas->base.video.captureFrame(canvas->base, renderTarget);
+}
+
+void nk::canvas::endVideoCapture(NkCanvas* canvas) {
+    canvas->base.video.end(canvas->base);
+}
+
 float nk::canvas::viewWidth(NkCanvas* canvas) {
     return canvas->base.resolution[0];
 }
@@ -302,7 +483,7 @@ float nk::canvas::viewHeight(NkCanvas* canvas) {
 }
 NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
                                              uint32_t height) {
-    NkImage* image = createImage(canvas, width, height, nullptr);
+    NkImage* image = nk::webgl::createImage(width, height, nullptr);
 
     glGenFramebuffers(1, &image->framebuffer);
     glGenRenderbuffers(1, &image->renderbuffer);
@@ -315,33 +496,27 @@ NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
               "Framebuffer not complete");
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, nullptr,
+                                      NkImageFormat::R8G8B8A8_UNORM, true);
     return image;
 }
 NkImage* nk::canvas::createImage(NkCanvas* canvas, uint32_t width,
                                  uint32_t height, const void* pixels,
                                  NkImageFormat format) {
-    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage));
-    if (!image) {
-        return nullptr;
-    }
-
-    glGenTextures(1, &image->texture);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, image->texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, pixels);
-
-    image->width = (float)width;
-    image->height = (float)height;
-
+    NkImage* image = nk::webgl::createImage(width, height, pixels);
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, pixels, format, false);
     return image;
 }
 bool nk::canvas::destroyImage(NkCanvas* canvas, NkImage* image) {
     if (image) {
+        canvas->base.invalidateFrameHash();
+        canvas->base.capture.imageDestroyed(image);
+        canvas->base.readbacks.imageDestroyed(image);
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+        canvas->base.frameTextureAtlas.removeImage(image);
+#endif
         glDeleteTextures(1, &image->texture);
         if (image->framebuffer) {
             glDeleteFramebuffers(1, &image->framebuffer);
@@ -394,6 +569,101 @@ void nk::canvas_internal::destroyFrameSyncPoint(NkGPUHandle* gpuSyncPoint) {}
 NkCanvasBase* nk::canvas_internal::canvasBase(NkCanvas* canvas) {
     return &canvas->base;
 }
+NkGPUHandle nk::canvas_internal::beginReadback(NkCanvas* canvas,
+                                               NkImage* image) {
+    if (!image->framebuffer) {
+        return nullptr;
+    }
+    NkWebGLReadback* readback =
+        (NkWebGLReadback*)nk::utils::memZeroAlloc(1, sizeof(NkWebGLReadback),
+                                                  NkMemoryTag::CANVAS);
+    if (!readback)
+        return nullptr;
+    readback->canvas = canvas;
+    readback->width = (uint32_t)image->width;
+    readback->height = (uint32_t)image->height;
+    readback->readFrame = canvas->base.currentFrame + NK_CANVAS_MAX_FRAMES;
+
+    glGenTextures(1, &readback->texture);
+    glBindTexture(GL_TEXTURE_2D, readback->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, readback->width, readback->height,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_FRAMEBUFFER, image->framebuffer);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, readback->width,
+                        readback->height);
+    glGenFramebuffers(1, &readback->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, readback->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           readback->texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return (NkGPUHandle)readback;
+}
+const void* nk::canvas_internal::mapReadback(NkGPUHandle gpuReadback,
+                                             uint32_t* rowPitch) {
+    NkWebGLReadback* readback = (NkWebGLReadback*)gpuReadback;
+    if (readback->canvas->base.currentFrame < readback->readFrame) {
+        return nullptr;
+    }
+    uint32_t width = readback->width;
+    uint32_t height = readback->height;
+    if (!readback->pixels) {
+        readback->pixels = (uint32_t*)nk::utils::memRealloc(
+            nullptr, (size_t)width * height * sizeof(uint32_t),
+            NkMemoryTag::CANVAS);
+        if (!readback->pixels) {
+            return nullptr;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, readback->framebuffer);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                     readback->pixels);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // GL rows start at the bottom, the canvas draws top down.
+        for (uint32_t y = 0; y < height / 2; ++y) {
+            uint32_t* top = readback->pixels + (size_t)y * width;
+            uint32_t* bottom =
+                readback->pixels + (size_t)(height - 1 - y) * width;
+            for (uint32_t x = 0; x < width; ++x) {
+                uint32_t pixel = top[x];
+                top[x] = bottom[x];
+                bottom[x] = pixel;
+            }
+        }
+    }
+    *rowPitch = width * sizeof(uint32_t);
+    return readback->pixels;
+}
+void nk::canvas_internal::destroyReadback(NkGPUHandle gpuReadback) {
+    NkWebGLReadback* readback = (NkWebGLReadback*)gpuReadback;
+    glDeleteFramebuffers(1, &readback->framebuffer);
+    glDeleteTextures(1, &readback->texture);
+    nk::utils::memFree(readback->pixels, NkMemoryTag::CANVAS);
+    nk::utils::memFree(readback, NkMemoryTag::CANVAS);
+}
+
+static void setBlendMode(NkBlendMode blendMode) {
+    switch (blendMode) {
+    case NkBlendMode::ALPHA:
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    case NkBlendMode::ADDITIVE:
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ZERO, GL_ONE);
+        break;
+    case NkBlendMode::MULTIPLY:
+        // dst * lerp(1, src, srcAlpha), the shader premultiplies src.
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO,
+                            GL_ONE);
+        break;
+    case NkBlendMode::NONE:
+        glDisable(GL_BLEND);
+        break;
+    }
+}
 
 void nk::webgl::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
     float viewWidth = nk::canvas::viewWidth(canvas);
@@ -411,6 +681,8 @@ void nk::webgl::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
         glGetUniformLocation(canvas->spriteProgram, "mainTexture");
     GLuint resolutionLocation =
         glGetUniformLocation(canvas->spriteProgram, "resolution");
+    GLuint premultiplyAlphaLocation =
+        glGetUniformLocation(canvas->spriteProgram, "premultiplyAlpha");
     GLuint vertPositionLocation =
         glGetAttribLocation(canvas->spriteProgram, "vertPosition");
     GLuint vertTexCoordLocation =
@@ -424,6 +696,7 @@ void nk::webgl::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
     glDepthRangef(0.0f, 1.0f);
     glUniform2f(resolutionLocation, viewWidth, viewHeight);
     glUniform1i(mainTextureLocation, 0);
+    glUniform1f(premultiplyAlphaLocation, 0.0f);
     glBindFramebuffer(GL_FRAMEBUFFER, canvas->renderTarget
                                           ? canvas->renderTarget->framebuffer
                                           : 0);
@@ -432,6 +705,14 @@ void nk::webgl::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
     glClear(GL_COLOR_BUFFER_BIT);
     GLuint indexBuffer = (GLuint)canvas->base.gpuIndexBuffer;
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if (!canvas->base.indicesUploaded) {
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0,
+                        canvas->base.indexBufferSize(),
+                        canvas->base.indexBufferData());
+        NK_CANVAS_STAT_ADD(canvas->base, uploadedBytes,
+                           canvas->base.indexBufferSize());
+        canvas->base.indicesUploaded = true;
+    }
 
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
     glActiveTexture(GL_TEXTURE0);
@@ -440,38 +721,84 @@ void nk::webgl::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
         ((NkImage*)canvas->base.frameTextureAtlas.gpuTexture)->texture);
 #endif
 
-    GLuint indexOffset = 0;
+    NkCanvasVertexRingBuffer& vertexRingBuffer = canvas->base.vertexRingBuffer;
+    for (uint32_t index = 0; index < vertexRingBuffer.frameRangeNum(); ++index) {
+        NkCanvasVertexRange& range = vertexRingBuffer.frameRange(index);
+        glBindBuffer(GL_ARRAY_BUFFER, (GLuint)range.buffer->gpuVertexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, range.offset * sizeof(NkCanvasVertex),
+                        range.count * sizeof(NkCanvasVertex),
+                        &range.buffer->vertices[range.offset]);
+        NK_CANVAS_STAT_ADD(canvas->base, uploadedBytes,
+                           range.count * sizeof(NkCanvasVertex));
+    }
+
+    glEnableVertexAttribArray(vertPositionLocation);
+    glEnableVertexAttribArray(vertTexCoordLocation);
+    glEnableVertexAttribArray(vertColorLocation);
+
+    GLuint boundBuffer = 0;
+    NkCanvasScissorRect currentScissor = {0, 0, (uint32_t)viewWidth,
+                                          (uint32_t)viewHeight};
+    NkBlendMode currentBlendMode = NkBlendMode::ALPHA;
     NkCanvasDrawBatchInternalArray& drawBatchArray =
         canvas->base.drawBatchArray[currentFrameIndex];
     for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
         NkCanvasDrawBatchInternal& drawBatch =
             drawBatchArray.drawBatches[index];
-        NkCanvasVertexBuffer* vertexBuffer = drawBatch.buffer;
-        GLuint buffer = (GLuint)vertexBuffer->gpuVertexBuffer;
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
-        glBufferSubData(GL_ARRAY_BUFFER, 0,
-                        vertexBuffer->vertexCount * sizeof(NkCanvasVertex),
-                        vertexBuffer->vertices);
-        glEnableVertexAttribArray(vertPositionLocation);
-        glEnableVertexAttribArray(vertTexCoordLocation);
-        glEnableVertexAttribArray(vertColorLocation);
-        glVertexAttribPointer(vertPositionLocation, 2, GL_FLOAT, false,
-                              sizeof(NkCanvasVertex),
-                              (void*)offsetof(NkCanvasVertex, position));
-        glVertexAttribPointer(vertTexCoordLocation, 2, GL_FLOAT, false,
-                              sizeof(NkCanvasVertex),
-                              (void*)offsetof(NkCanvasVertex, texCoord));
-        glVertexAttribPointer(vertColorLocation, 4, GL_UNSIGNED_BYTE, true,
-                              sizeof(NkCanvasVertex),
-                              (void*)offsetof(NkCanvasVertex, color));
+        if (drawBatch.count == 0) {
+            continue;
+        }
+        NkCanvasScissorRect scissor = nk::canvas_internal::scissorRect(
+            drawBatch, viewWidth, viewHeight);
+        if (memcmp(&scissor, &currentScissor, sizeof(scissor)) != 0) {
+            // GL scissor origin is the bottom left corner.
+            glScissor((GLint)scissor.x,
+                      (GLint)((uint32_t)viewHeight - scissor.y -
+                              scissor.height),
+                      (GLsizei)scissor.width, (GLsizei)scissor.height);
+            currentScissor = scissor;
+        }
+        if (drawBatch.blendMode != currentBlendMode) {
+            setBlendMode(drawBatch.blendMode);
+            glUniform1f(premultiplyAlphaLocation,
+                        drawBatch.blendMode == NkBlendMode::MULTIPLY ? 1.0f
+                                                                     : 0.0f);
+            currentBlendMode = drawBatch.blendMode;
+        }
+        GLuint buffer = (GLuint)drawBatch.buffer->gpuVertexBuffer;
+        if (buffer != boundBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            boundBuffer = buffer;
+        }
+        // NOTE(bitnenfer): WebGL has no base vertex so the batch offset goes
+        // into the attribute pointers.
+        size_t vertexOffset = drawBatch.bufferOffset * sizeof(NkCanvasVertex);
+        glVertexAttribPointer(
+            vertPositionLocation, 2, GL_FLOAT, false, sizeof(NkCanvasVertex),
+            (void*)(vertexOffset + offsetof(NkCanvasVertex, position)));
+        glVertexAttribPointer(
+            vertTexCoordLocation, 2, GL_FLOAT, false, sizeof(NkCanvasVertex),
+            (void*)(vertexOffset + offsetof(NkCanvasVertex, texCoord)));
+        glVertexAttribPointer(
+            vertColorLocation, 4, GL_UNSIGNED_BYTE, true,
+            sizeof(NkCanvasVertex),
+            (void*)(vertexOffset + offsetof(NkCanvasVertex, color)));
 #if !NK_CANVAS_TEXTURE_ATLAS_ENABLED
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, drawBatch.image->texture);
 #endif
-        glDrawElements(GL_TRIANGLES, drawBatch.count, GL_UNSIGNED_INT,
-                       reinterpret_cast<void*>(indexOffset * sizeof(GLuint)));
+#if NK_CANVAS_16BIT_INDICES_ENABLED
+        // Doesn't need the OES_element_index_uint extension on WebGL1.
+        glDrawElements(GL_TRIANGLES, drawBatch.count, GL_UNSIGNED_SHORT,
+                       nullptr);
+#else
+        glDrawElements(GL_TRIANGLES, drawBatch.count, GL_UNSIGNED_INT, nullptr);
+#endif
+    }
 
-        indexOffset += drawBatch.count;
+    // The texture atlas update expects the default blend mode.
+    if (currentBlendMode != NkBlendMode::ALPHA) {
+        setBlendMode(NkBlendMode::ALPHA);
     }
 }
 
@@ -495,6 +822,10 @@ void nk::canvas_internal::setTextureAtlasState(NkImage* image,
     image->rect = rect;
 }
 
+void nk::canvas_internal::clearTextureAtlasState(NkImage* image) {
+    image->state &= ~NK_IMAGE_BIT_TEXTURE_ATLAS;
+}
+
 bool nk::canvas_internal::isImageInTextureAtlas(NkImage* image) {
     return (image->state & NK_IMAGE_BIT_TEXTURE_ATLAS) > 0;
 }
@@ -28,6 +28,19 @@ struct NkImage {
 #endif
 };
 
+// WebGL 1 has no asynchronous reads. The render target is copied on the GPU
+// right away and the copy is read a few frames later, when the GPU is
+// likely done with it.
+struct NkWebGLReadback {
+    NkCanvas* canvas;
+    GLuint texture;
+    GLuint framebuffer;
+    uint32_t width;
+    uint32_t height;
+    uint64_t readFrame;
+    uint32_t* pixels;
+};
+
 struct NkCanvas {
     NkCanvasBase base;
     NkApp* app;
@@ -56,6 +69,8 @@ namespace nk {
         NkWebGLInstance* createInstance();
         void destroyInstance(NkWebGLInstance* instance);
         NkWebGLInstance* instance();
+        NkImage* createImage(uint32_t width, uint32_t height,
+                             const void* pixels);
         void drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex);
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
         void updateTextureAtlas(NkCanvas* canvas, NkTextureAtlas& textureAtlas);
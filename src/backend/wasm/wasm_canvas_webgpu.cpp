@@ -1,4 +1,5 @@
 #include "wasm_canvas_webgpu.h"
+#include <string.h>
 
 const char shaderSource[] = R"(
 
@@ -33,6 +34,13 @@ fn fsMain(vtx : VertexOut) -> @location(0) vec4<f32> {
     return textureSample(mainTexture, samplerPoint, vtx.texCoord) * vtx.color;
 }
 
+// The multiply blend mode needs premultiplied alpha.
+@fragment
+fn fsMultiply(vtx : VertexOut) -> @location(0) vec4<f32> {
+    let color = textureSample(mainTexture, samplerPoint, vtx.texCoord) * vtx.color;
+    return vec4<f32>(color.rgb * color.a, color.a);
+}
+
 )";
 
 static NkWebGPUInstance webGPUInstance = {};
@@ -62,7 +70,8 @@ NkWebGPUInstance* nk::webgpu::instance() { return &webGPUInstance; }
 void nk::canvas_internal::initVertexBuffer(NkCanvasVertexBuffer* vertexBuffer,
                                            size_t bufferSize) {
     NkWebGPUBuffer* buffer =
-        (NkWebGPUBuffer*)nk::utils::memZeroAlloc(1, sizeof(NkWebGPUBuffer));
+        (NkWebGPUBuffer*)nk::utils::memZeroAlloc(1, sizeof(NkWebGPUBuffer),
+                                                 NkMemoryTag::CANVAS);
     if (buffer) {
         WGPUBufferDescriptor bufferDesc{};
         bufferDesc.nextInChain = nullptr;
@@ -78,14 +87,15 @@ void nk::canvas_internal::initVertexBuffer(NkCanvasVertexBuffer* vertexBuffer,
 
 void nk::canvas_internal::initIndexBuffer(void** gpuIndexBuffer) {
     NkWebGPUBuffer* buffer =
-        (NkWebGPUBuffer*)nk::utils::memZeroAlloc(1, sizeof(NkWebGPUBuffer));
+        (NkWebGPUBuffer*)nk::utils::memZeroAlloc(1, sizeof(NkWebGPUBuffer),
+                                                 NkMemoryTag::CANVAS);
     if (buffer) {
         WGPUBufferDescriptor bufferDesc{};
         bufferDesc.nextInChain = nullptr;
         bufferDesc.label = "NkIndexBuffer::buffer";
         bufferDesc.usage = WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst;
         bufferDesc.size = NK_CANVAS_MAX_INDICES_BYTE_SIZE;
-        bufferDesc.mappedAtCreation = true;
+        bufferDesc.mappedAtCreation = false;
         buffer->buffer =
             wgpuDeviceCreateBuffer(nk::webgpu::instance()->device, &bufferDesc);
         *gpuIndexBuffer = (void*)buffer;
@@ -97,7 +107,7 @@ void nk::canvas_internal::destroyVertexBuffer(
     if (vertexBuffer && vertexBuffer->gpuVertexBuffer) {
         NkWebGPUBuffer* buffer = (NkWebGPUBuffer*)vertexBuffer->gpuVertexBuffer;
         wgpuBufferDestroy(buffer->buffer);
-        nk::utils::memFree(buffer);
+        nk::utils::memFree(buffer, NkMemoryTag::CANVAS);
     }
 }
 
@@ -105,7 +115,7 @@ void nk::canvas_internal::destroyIndexBuffer(void** gpuIndexBuffer) {
     if (gpuIndexBuffer && *gpuIndexBuffer) {
         NkWebGPUBuffer* buffer = (NkWebGPUBuffer*)*gpuIndexBuffer;
         wgpuBufferDestroy(buffer->buffer);
-        nk::utils::memFree(buffer);
+        nk::utils::memFree(buffer, NkMemoryTag::CANVAS);
     }
 }
 
@@ -124,9 +134,152 @@ NkCanvasBase* nk::canvas_internal::canvasBase(NkCanvas* canvas) {
     return &canvas->base;
 }
 
+static void releaseReadback(NkWebGPUReadback* readback) {
+    wgpuBufferDestroy(readback->buffer);
+    wgpuBufferRelease(readback->buffer);
+    nk::utils::memFree(readback, NkMemoryTag::CANVAS);
+}
+
+static void readbackMapped(WGPUBufferMapAsyncStatus status, void* userData) {
+    NkWebGPUReadback* readback = (NkWebGPUReadback*)userData;
+    readback->mapDone = true;
+    readback->mapped = status == WGPUBufferMapAsyncStatus_Success;
+    if (readback->dropped) {
+        releaseReadback(readback);
+    } else if (!readback->mapped) {
+        // The read stays pending, later reads queue up behind it.
+        NK_LOG("Error: Failed to map readback buffer.");
+    }
+}
+
+// Takes the most recently pooled readback of the given size.
+static NkWebGPUReadback* takePooledReadback(NkCanvas* canvas,
+                                            uint64_t bufferSize) {
+    for (uint32_t index = canvas->readbackPoolNum; index-- > 0;) {
+        NkWebGPUReadback* readback = canvas->readbackPool[index];
+        if (readback->bufferSize == bufferSize) {
+            canvas->readbackPoolNum--;
+            memmove(&canvas->readbackPool[index],
+                    &canvas->readbackPool[index + 1],
+                    (canvas->readbackPoolNum - index) *
+                        sizeof(NkWebGPUReadback*));
+            return readback;
+        }
+    }
+    return nullptr;
+}
+
+NkGPUHandle nk::canvas_internal::beginReadback(NkCanvas* canvas,
+                                               NkImage* image) {
+    if (!image->renderTarget) {
+        return nullptr;
+    }
+    WGPUDevice device = nk::webgpu::instance()->device;
+    uint32_t width = (uint32_t)image->width;
+    uint32_t height = (uint32_t)image->height;
+    // Buffer copies need rows aligned to 256 bytes.
+    uint32_t rowPitch =
+        (uint32_t)nk::utils::alignSize(width * sizeof(uint32_t), 256);
+    uint64_t bufferSize = (uint64_t)rowPitch * height;
+    NkWebGPUReadback* readback = takePooledReadback(canvas, bufferSize);
+    if (!readback) {
+        readback = (NkWebGPUReadback*)nk::utils::memZeroAlloc(
+            1, sizeof(NkWebGPUReadback), NkMemoryTag::CANVAS);
+        if (!readback)
+            return nullptr;
+        readback->canvas = canvas;
+        readback->bufferSize = bufferSize;
+
+        WGPUBufferDescriptor bufferDesc{};
+        bufferDesc.nextInChain = nullptr;
+        bufferDesc.label = "NkCanvas::readbackBuffer";
+        bufferDesc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+        bufferDesc.size = bufferSize;
+        bufferDesc.mappedAtCreation = false;
+        readback->buffer = wgpuDeviceCreateBuffer(device, &bufferDesc);
+    }
+    readback->rowPitch = rowPitch;
+    readback->mapDone = false;
+    readback->mapped = false;
+
+    WGPUCommandEncoderDescriptor commandEncoderDesc{};
+    commandEncoderDesc.nextInChain = nullptr;
+    commandEncoderDesc.label = "ReadbackCommandEncoder";
+    WGPUCommandEncoder commandEncoder =
+        wgpuDeviceCreateCommandEncoder(device, &commandEncoderDesc);
+
+    WGPUImageCopyTexture srcImageCopy{};
+    srcImageCopy.nextInChain = nullptr;
+    srcImageCopy.texture = image->texture;
+    srcImageCopy.mipLevel = 0;
+    srcImageCopy.origin = {0, 0, 0};
+    srcImageCopy.aspect = WGPUTextureAspect_All;
+
+    WGPUImageCopyBuffer destBufferCopy{};
+    destBufferCopy.nextInChain = nullptr;
+    destBufferCopy.layout.nextInChain = nullptr;
+    destBufferCopy.layout.offset = 0;
+    destBufferCopy.layout.bytesPerRow = readback->rowPitch;
+    destBufferCopy.layout.rowsPerImage = height;
+    destBufferCopy.buffer = readback->buffer;
+
+    WGPUExtent3D extent = {width, height, 1};
+    wgpuCommandEncoderCopyTextureToBuffer(commandEncoder, &srcImageCopy,
+                                          &destBufferCopy, &extent);
+
+    WGPUCommandBufferDescriptor commandBufferDesc{};
+    commandBufferDesc.nextInChain = nullptr;
+    commandBufferDesc.label = "ReadbackCommandBuffer";
+    WGPUCommandBuffer commandBuffer =
+        wgpuCommandEncoderFinish(commandEncoder, &commandBufferDesc);
+    wgpuQueueSubmit(nk::webgpu::instance()->queue, 1, &commandBuffer);
+    wgpuCommandEncoderRelease(commandEncoder);
+    wgpuCommandBufferRelease(commandBuffer);
+
+    wgpuBufferMapAsync(readback->buffer, WGPUMapMode_Read, 0,
+                       readback->bufferSize, &readbackMapped, readback);
+    return (NkGPUHandle)readback;
+}
+
+const void* nk::canvas_internal::mapReadback(NkGPUHandle gpuReadback,
+                                             uint32_t* rowPitch) {
+    NkWebGPUReadback* readback = (NkWebGPUReadback*)gpuReadback;
+    if (!readback->mapped) {
+        return nullptr;
+    }
+    *rowPitch = readback->rowPitch;
+    return wgpuBufferGetConstMappedRange(readback->buffer, 0,
+                                         readback->bufferSize);
+}
+
+void nk::canvas_internal::destroyReadback(NkGPUHandle gpuReadback) {
+    NkWebGPUReadback* readback = (NkWebGPUReadback*)gpuReadback;
+    if (!readback->mapDone) {
+        // Destroying the buffer cancels the map and the callback releases
+        // the rest.
+        readback->dropped = true;
+        wgpuBufferDestroy(readback->buffer);
+        return;
+    }
+    if (readback->mapped) {
+        wgpuBufferUnmap(readback->buffer);
+        readback->mapped = false;
+    }
+    NkCanvas* canvas = readback->canvas;
+    if (canvas->readbackPoolNum == NK_CANVAS_MAX_READBACKS) {
+        // Make room by dropping the oldest one.
+        releaseReadback(canvas->readbackPool[0]);
+        canvas->readbackPoolNum--;
+        memmove(&canvas->readbackPool[0], &canvas->readbackPool[1],
+                canvas->readbackPoolNum * sizeof(NkWebGPUReadback*));
+    }
+    canvas->readbackPool[canvas->readbackPoolNum++] = readback;
+}
+
 NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
     nk::webgpu::createInstance();
-    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas));
+    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas),
+                                                          NkMemoryTag::CANVAS);
     if (!canvas)
         return nullptr;
     canvas->base.init(canvas, (float)app->windowWidth,
@@ -243,18 +396,9 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
     vertexBufferLayout.attributeCount = 3;
     vertexBufferLayout.attributes = vertexAttribs;
 
-    WGPUBlendState blendState{};
-    blendState.color.srcFactor = WGPUBlendFactor_SrcAlpha;
-    blendState.color.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
-    blendState.color.operation = WGPUBlendOperation_Add;
-    blendState.alpha.srcFactor = WGPUBlendFactor_One;
-    blendState.alpha.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
-    blendState.alpha.operation = WGPUBlendOperation_Add;
-
     WGPUColorTargetState colorTargetState{};
     colorTargetState.nextInChain = nullptr;
     colorTargetState.format = canvas->surfaceFormat;
-    colorTargetState.blend = &blendState; // TODO: needs to be filled.
     colorTargetState.writeMask = WGPUColorWriteMask_All;
 
     WGPUFragmentState fragState{};
@@ -288,16 +432,41 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
     renderPipelineDesc.multisample.count = 1;
     renderPipelineDesc.multisample.mask = 0xffffffff;
     renderPipelineDesc.fragment = &fragState;
-    canvas->spritePSO = wgpuDeviceCreateRenderPipeline(
-        nk::webgpu::instance()->device, &renderPipelineDesc);
 
-    // upload index buffer
-    NkWebGPUBuffer* indexBuffer = (NkWebGPUBuffer*)canvas->base.gpuIndexBuffer;
-    void* mappedIndexBuffer = wgpuBufferGetMappedRange(
-        indexBuffer->buffer, 0, NK_CANVAS_MAX_INDICES_BYTE_SIZE);
-    memcpy(mappedIndexBuffer, canvas->base.indexBufferData(),
-           NK_CANVAS_MAX_INDICES_BYTE_SIZE);
-    wgpuBufferUnmap(indexBuffer->buffer);
+    for (uint32_t index = 0; index < NK_CANVAS_BLEND_MODE_COUNT; ++index) {
+        WGPUBlendState blendState{};
+        fragState.entryPoint = "fsMain";
+        blendState.color.operation = WGPUBlendOperation_Add;
+        blendState.alpha.operation = WGPUBlendOperation_Add;
+        switch ((NkBlendMode)index) {
+        case NkBlendMode::ALPHA:
+            blendState.color.srcFactor = WGPUBlendFactor_SrcAlpha;
+            blendState.color.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
+            blendState.alpha.srcFactor = WGPUBlendFactor_One;
+            blendState.alpha.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
+            break;
+        case NkBlendMode::ADDITIVE:
+            blendState.color.srcFactor = WGPUBlendFactor_SrcAlpha;
+            blendState.color.dstFactor = WGPUBlendFactor_One;
+            blendState.alpha.srcFactor = WGPUBlendFactor_Zero;
+            blendState.alpha.dstFactor = WGPUBlendFactor_One;
+            break;
+        case NkBlendMode::MULTIPLY:
+            // dst * lerp(1, src, srcAlpha), the shader premultiplies src.
+            fragState.entryPoint = "fsMultiply";
+            blendState.color.srcFactor = WGPUBlendFactor_Dst;
+            blendState.color.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
+            blendState.alpha.srcFactor = WGPUBlendFactor_Zero;
+            blendState.alpha.dstFactor = WGPUBlendFactor_One;
+            break;
+        case NkBlendMode::NONE:
+            break;
+        }
+        colorTargetState.blend =
+            (NkBlendMode)index == NkBlendMode::NONE ? nullptr : &blendState;
+        canvas->spritePSO[index] = wgpuDeviceCreateRenderPipeline(
+            nk::webgpu::instance()->device, &renderPipelineDesc);
+    }
 
     // resolution buffer
     WGPUBufferDescriptor bufferDesc{};
@@ -357,7 +526,11 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
 bool nk::canvas::destroy(NkCanvas* canvas) {
     if (canvas) {
         canvas->base.destroy(canvas);
-        nk::utils::memFree(canvas);
+        for (uint32_t index = 0; index < canvas->readbackPoolNum; ++index) {
+            releaseReadback(canvas->readbackPool[index]);
+        }
+        canvas->readbackPoolNum = 0;
+        nk::utils::memFree(canvas, NkMemoryTag::CANVAS);
         nk::webgpu::destroyInstance(&webGPUInstance);
     }
     return false;
@@ -381,6 +554,17 @@ void nk::canvas::scale(NkCanvas* canvas, float x, float y) {
     canvas->base.scale(x, y);
 }
 
+void nk::canvas::pushClipRect(NkCanvas* canvas, float x, float y, float width,
+                              float height) {
+    canvas->base.pushClipRect(x, y, width, height);
+}
+
+void nk::canvas::popClipRect(NkCanvas* canvas) { canvas->base.popClipRect(); }
+
+void nk::canvas::setBlendMode(NkCanvas* canvas, NkBlendMode blendMode) {
+    canvas->base.setBlendMode(blendMode);
+}
+
 void nk::canvas::drawLine(NkCanvas* canvas, float x0, float y0, float x1,
                           float y1, float lineWidth, uint32_t color) {
     canvas->base.drawLine(x0, y0, x1, y1, lineWidth, color);
@@ -425,8 +609,48 @@ void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
                            frameHeight, color, image);
 }
 
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, transform, color, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, float frameX, float frameY,
+                           float frameWidth, float frameHeight,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, width, height, frameX, frameY, frameWidth,
+                           frameHeight, transform, color, image);
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteDesc* sprites,
+                            uint32_t count, NkImage* image) {
+    canvas->base.drawImages(sprites, count, image);
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteArrays& sprites,
+                            uint32_t count, NkImage* image) {
+    canvas->base.drawImages(sprites, count, image);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectDesc* rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectArrays& rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawPerfOverlay(NkCanvas* canvas, float x, float y) {
+    canvas->base.drawPerfOverlay(x, y);
+}
+
 void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
                             float a) {
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
     canvas->clearColor[0] = r;
     canvas->clearColor[1] = g;
     canvas->clearColor[2] = b;
@@ -436,6 +660,7 @@ void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
 
 void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
                             float g, float b, float a) {
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
     canvas->clearColor[0] = r;
     canvas->clearColor[1] = g;
     canvas->clearColor[2] = b;
@@ -445,14 +670,53 @@ void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
 }
 
 void nk::canvas::endFrame(NkCanvas* canvas) {
-    canvas->base.endFrame(canvas);
-    nk::webgpu::drawFrame(canvas, canvas->base.currentFrameIndex);
+    NK_CANVAS_STAT_SCOPED_TIMER(canvas->base, endFrameTime);
+    canvas->base.endFrame(canvas, canvas->renderTarget);
+    canvas->base.capture.writeFrame(canvas->base, canvas->renderTarget,
+                                    canvas->clearColor);
+    if (!canvas->base.skipFrame(canvas->renderTarget, canvas->clearColor)) {
+        nk::webgpu::drawFrame(canvas, canvas->base.currentFrameIndex);
+    }
     canvas->base.swapFrame(canvas);
     canvas->renderTarget = nullptr;
+    NK_PROFILER_END_EVENT();
 }
 
 void nk::canvas::present(NkCanvas* canvas) {}
 
+const NkCanvasFrameStats& nk::canvas::frameStats(NkCanvas* canvas) {
+    return canvas->base.lastFrameStats;
+}
+
+void nk::canvas::setSkipIdenticalFrames(NkCanvas* canvas, bool enabled) {
+    canvas->base.skipIdenticalFrames = enabled;
+    canvas->base.invalidateFrameHash();
+}
+
+bool nk::canvas::beginCapture(NkCanvas* canvas, const char* path) {
+    return canvas->base.capture.begin(path);
+}
+
+void nk::canvas::endCapture(NkCanvas* canvas) { canvas->base.capture.end(); }
+
+bool nk::canvas::readPixelsAsync(NkCanvas* canvas, NkImage* image,
+                                 NkReadPixelsFunc callback, void* userData) {
+    return canvas->base.readbacks.push(canvas, image, callback, userData);
+}
+
+bool nk::canvas::beginVideoCapture(NkCanvas* canvas, const char* path,
+                                   NkVideoFormat format, uint32_t frameRate) {
+    return canvas->base.video.begin(canvas->base, path, format, frameRate);
+}
+
+bool nk::canvas::captureVideoFrame(NkCanvas* canvas, NkImage* renderTarget) {
+    return canvas->base.video.captureFrame(canvas->base, renderTarget);
+}
+
+void nk::canvas::endVideoCapture(NkCanvas* canvas) {
+    canvas->base.video.end(canvas->base);
+}
+
 float nk::canvas::viewWidth(NkCanvas* canvas) {
     return canvas->base.resolution[0];
 }
@@ -464,7 +728,8 @@ float nk::canvas::viewHeight(NkCanvas* canvas) {
 NkImage* nk::canvas::createImage(NkCanvas* canvas, uint32_t width,
                                  uint32_t height, const void* pixels,
                                  NkImageFormat format) {
-    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage));
+    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage),
+                                                       NkMemoryTag::IMAGE);
     if (!image)
         return nullptr;
 
@@ -537,12 +802,16 @@ NkImage* nk::canvas::createImage(NkCanvas* canvas, uint32_t width,
     image->bindGroup = wgpuDeviceCreateBindGroup(nk::webgpu::instance()->device,
                                                  &bindGroupDesc);
 
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, pixels, format, false);
+
     return image;
 }
 
 NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
                                              uint32_t height) {
-    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage));
+    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage),
+                                                       NkMemoryTag::IMAGE);
     if (!image)
         return nullptr;
 
@@ -567,6 +836,7 @@ NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
 
     image->width = (float)width;
     image->height = (float)height;
+    image->renderTarget = true;
 
     WGPUTextureViewDescriptor textureViewDesc{};
     textureViewDesc.nextInChain = nullptr;
@@ -599,13 +869,23 @@ NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
     image->bindGroup = wgpuDeviceCreateBindGroup(nk::webgpu::instance()->device,
                                                  &bindGroupDesc);
 
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, nullptr,
+                                      NkImageFormat::R8G8B8A8_UNORM, true);
+
     return image;
 }
 
 bool nk::canvas::destroyImage(NkCanvas* canvas, NkImage* image) {
     if (image) {
+        canvas->base.invalidateFrameHash();
+        canvas->base.capture.imageDestroyed(image);
+        canvas->base.readbacks.imageDestroyed(image);
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+        canvas->base.frameTextureAtlas.removeImage(image);
+#endif
         wgpuTextureDestroy(image->texture);
-        nk::utils::memFree(image);
+        nk::utils::memFree(image, NkMemoryTag::IMAGE);
         return true;
     }
     return false;
@@ -631,18 +911,32 @@ void nk::webgpu::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
                          canvas->resolutionBuffer, 0, resolution,
                          sizeof(float) * 2);
 
-    // Upload vertex buffer data
+    // Upload the indices when they grew since the last frame
+    if (!canvas->base.indicesUploaded) {
+        NkWebGPUBuffer* indexBuffer =
+            (NkWebGPUBuffer*)canvas->base.gpuIndexBuffer;
+        wgpuQueueWriteBuffer(queue, indexBuffer->buffer, 0,
+                             canvas->base.indexBufferData(),
+                             canvas->base.indexBufferSize());
+        NK_CANVAS_STAT_ADD(canvas->base, uploadedBytes,
+                           canvas->base.indexBufferSize());
+        canvas->base.indicesUploaded = true;
+    }
+
+    // Upload vertex ranges written this frame
+    NkCanvasVertexRingBuffer& vertexRingBuffer = canvas->base.vertexRingBuffer;
+    for (uint32_t index = 0; index < vertexRingBuffer.frameRangeNum(); ++index) {
+        NkCanvasVertexRange& range = vertexRingBuffer.frameRange(index);
+        NkWebGPUBuffer* buffer = (NkWebGPUBuffer*)range.buffer->gpuVertexBuffer;
+        wgpuQueueWriteBuffer(queue, buffer->buffer,
+                             range.offset * sizeof(NkCanvasVertex),
+                             &range.buffer->vertices[range.offset],
+                             range.count * sizeof(NkCanvasVertex));
+        NK_CANVAS_STAT_ADD(canvas->base, uploadedBytes,
+                           range.count * sizeof(NkCanvasVertex));
+    }
     NkCanvasDrawBatchInternalArray& drawBatchArray =
         canvas->base.drawBatchArray[currentFrameIndex];
-    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
-        NkCanvasDrawBatchInternal& drawBatch =
-            drawBatchArray.drawBatches[index];
-        NkCanvasVertexBuffer* vertexBuffer = drawBatch.buffer;
-        NkWebGPUBuffer* buffer = (NkWebGPUBuffer*)vertexBuffer->gpuVertexBuffer;
-        wgpuQueueWriteBuffer(queue, buffer->buffer, 0, vertexBuffer->vertices,
-                             vertexBuffer->vertexCount *
-                                 sizeof(NkCanvasVertex));
-    }
 
     WGPUCommandEncoderDescriptor commandEncoderDesc{};
     commandEncoderDesc.nextInChain = nullptr;
@@ -685,12 +979,19 @@ void nk::webgpu::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
         wgpuCommandEncoderBeginRenderPass(commandEncoder, &renderPassDesc);
 
     {
-        wgpuRenderPassEncoderSetPipeline(renderPassEncoder, canvas->spritePSO);
+        NkBlendMode currentBlendMode = NkBlendMode::ALPHA;
+        wgpuRenderPassEncoderSetPipeline(
+            renderPassEncoder, canvas->spritePSO[(uint32_t)currentBlendMode]);
         NkWebGPUBuffer* indexBuffer =
             (NkWebGPUBuffer*)canvas->base.gpuIndexBuffer;
-        wgpuRenderPassEncoderSetIndexBuffer(
-            renderPassEncoder, indexBuffer->buffer, WGPUIndexFormat_Uint32, 0,
-            NK_CANVAS_MAX_INDICES_BYTE_SIZE);
+#if NK_CANVAS_16BIT_INDICES_ENABLED
+        WGPUIndexFormat indexFormat = WGPUIndexFormat_Uint16;
+#else
+        WGPUIndexFormat indexFormat = WGPUIndexFormat_Uint32;
+#endif
+        wgpuRenderPassEncoderSetIndexBuffer(renderPassEncoder,
+                                            indexBuffer->buffer, indexFormat,
+                                            0, NK_CANVAS_MAX_INDICES_BYTE_SIZE);
         wgpuRenderPassEncoderSetViewport(renderPassEncoder, 0, 0, viewWidth,
                                          viewHeight, 0.0f, 1.0f);
         wgpuRenderPassEncoderSetScissorRect(renderPassEncoder, 0, 0, viewWidth,
@@ -706,14 +1007,37 @@ void nk::webgpu::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
             0, nullptr);
 #endif
 
+        NkCanvasVertexBuffer* boundVertexBuffer = nullptr;
+        NkCanvasScissorRect currentScissor = {0, 0, (uint32_t)viewWidth,
+                                              (uint32_t)viewHeight};
         for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
             NkCanvasDrawBatchInternal& drawBatch =
                 drawBatchArray.drawBatches[index];
-            NkWebGPUBuffer* vertexBuffer =
-                (NkWebGPUBuffer*)drawBatch.buffer->gpuVertexBuffer;
-            wgpuRenderPassEncoderSetVertexBuffer(
-                renderPassEncoder, 0, vertexBuffer->buffer, 0,
-                drawBatch.buffer->vertexCount * sizeof(NkCanvasVertex));
+            if (drawBatch.count == 0) {
+                continue;
+            }
+            NkCanvasScissorRect scissor = nk::canvas_internal::scissorRect(
+                drawBatch, viewWidth, viewHeight);
+            if (memcmp(&scissor, &currentScissor, sizeof(scissor)) != 0) {
+                wgpuRenderPassEncoderSetScissorRect(
+                    renderPassEncoder, scissor.x, scissor.y, scissor.width,
+                    scissor.height);
+                currentScissor = scissor;
+            }
+            if (drawBatch.blendMode != currentBlendMode) {
+                wgpuRenderPassEncoderSetPipeline(
+                    renderPassEncoder,
+                    canvas->spritePSO[(uint32_t)drawBatch.blendMode]);
+                currentBlendMode = drawBatch.blendMode;
+            }
+            if (drawBatch.buffer != boundVertexBuffer) {
+                NkWebGPUBuffer* vertexBuffer =
+                    (NkWebGPUBuffer*)drawBatch.buffer->gpuVertexBuffer;
+                wgpuRenderPassEncoderSetVertexBuffer(
+                    renderPassEncoder, 0, vertexBuffer->buffer, 0,
+                    drawBatch.buffer->vertexCapacity * sizeof(NkCanvasVertex));
+                boundVertexBuffer = drawBatch.buffer;
+            }
 #if !NK_CANVAS_TEXTURE_ATLAS_ENABLED
             wgpuRenderPassEncoderSetBindGroup(
                 renderPassEncoder, 1, drawBatch.image->bindGroup, 0, nullptr);
@@ -741,7 +1065,7 @@ void nk::canvas_internal::initTextureAtlasResource(
     NkCanvas* canvas, NkTextureAtlas& textureAtlas) {
     NkTextureAtlasResource* texture =
         (NkTextureAtlasResource*)nk::utils::memZeroAlloc(
-            1, sizeof(NkTextureAtlasResource));
+            1, sizeof(NkTextureAtlasResource), NkMemoryTag::TEXTURE_ATLAS);
     if (!texture)
         return;
 
@@ -804,7 +1128,7 @@ void nk::canvas_internal::destroyTextureAtlasResource(
     wgpuTextureDestroy(texture->texture);
     wgpuTextureViewRelease(texture->textureView);
     wgpuBindGroupRelease(texture->bindGroup);
-    nk::utils::memFree(texture);
+    nk::utils::memFree(texture, NkMemoryTag::TEXTURE_ATLAS);
 }
 
 void nk::canvas_internal::setTextureAtlasState(NkImage* image,
@@ -813,6 +1137,10 @@ void nk::canvas_internal::setTextureAtlasState(NkImage* image,
     image->rect = rect;
 }
 
+void nk::canvas_internal::clearTextureAtlasState(NkImage* image) {
+    image->state &= ~NK_IMAGE_BIT_TEXTURE_ATLAS;
+}
+
 bool nk::canvas_internal::isImageInTextureAtlas(NkImage* image) {
     return (image->state & NK_IMAGE_BIT_TEXTURE_ATLAS) > 0;
 }
@@ -28,12 +28,27 @@ struct NkImage {
     WGPUBindGroup bindGroup;
     float width;
     float height;
+    bool renderTarget;
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
     uint32_t state;
     NkTextureAtlasRect rect;
 #endif
 };
 
+// Copy of a render target into a buffer mapped for reading. The map
+// callback owns the readback when it's dropped before the map finished.
+// Otherwise it goes back to the canvas pool once the read is done and is
+// reused by the next read of the same size.
+struct NkWebGPUReadback {
+    NkCanvas* canvas;
+    WGPUBuffer buffer;
+    uint64_t bufferSize;
+    uint32_t rowPitch;
+    bool mapDone;
+    bool mapped;
+    bool dropped;
+};
+
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
 struct NkTextureAtlasResource {
     WGPUTexture texture;
@@ -48,7 +63,7 @@ struct NkCanvas {
     WGPUSurface canvasSurface;
     WGPUSwapChain swapChain;
     WGPUTextureFormat surfaceFormat;
-    WGPURenderPipeline spritePSO;
+    WGPURenderPipeline spritePSO[NK_CANVAS_BLEND_MODE_COUNT];
     WGPUShaderModule spriteShaderModule;
     WGPUPipelineLayout spritePipelineLayout;
     WGPUBindGroupLayout spriteBindGroupLayout[2];
@@ -58,6 +73,8 @@ struct NkCanvas {
     float clearColor[4];
     bool allowResize;
     NkImage* renderTarget;
+    NkWebGPUReadback* readbackPool[NK_CANVAS_MAX_READBACKS]; // Oldest first
+    uint32_t readbackPoolNum;
 };
 
 namespace nk {
@@ -1,44 +1,15 @@
 #include "../utils.h"
-#include <stdarg.h>
+#include <emscripten.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define NK_UTILS_WASM_LOG_MAX_BUFFER_SIZE  4096
-#define NK_UTILS_WASM_LOG_MAX_BUFFER_COUNT 4
-
-static NkReallocFunc globalRealloc = nullptr;
-static NkFreeFunc globalFree = nullptr;
-
-void nk::utils::exit(uint32_t exitCode) { ::exit(exitCode); }
-
-void nk::utils::logFmt(const char* fmt, ...) {
-    static char bufferLarge[NK_UTILS_WASM_LOG_MAX_BUFFER_SIZE *
-                            NK_UTILS_WASM_LOG_MAX_BUFFER_COUNT] = {};
-    static uint32_t bufferIndex = 0;
-    va_list args;
-    va_start(args, fmt);
-    char* buffer =
-        &bufferLarge[bufferIndex * NK_UTILS_WASM_LOG_MAX_BUFFER_SIZE];
-    vsprintf(buffer, fmt, args);
-    bufferIndex = (bufferIndex + 1) % NK_UTILS_WASM_LOG_MAX_BUFFER_COUNT;
-    va_end(args);
-    printf("%s", buffer);
+void nk::utils::exit(uint32_t exitCode) {
+    flushLog();
+    ::exit(exitCode);
 }
 
-const char* nk::utils::tempString(const char* fmt, ...) {
-    static char bufferLarge[NK_UTILS_WASM_LOG_MAX_BUFFER_SIZE *
-                            NK_UTILS_WASM_LOG_MAX_BUFFER_COUNT] = {};
-    static uint32_t bufferIndex = 0;
-    va_list args;
-    va_start(args, fmt);
-    char* buffer =
-        &bufferLarge[bufferIndex * NK_UTILS_WASM_LOG_MAX_BUFFER_SIZE];
-    vsprintf(buffer, fmt, args);
-    bufferIndex = (bufferIndex + 1) % NK_UTILS_WASM_LOG_MAX_BUFFER_COUNT;
-    va_end(args);
-    return buffer;
-}
+void nk::utils::logWrite(const char* message) { printf("%s", message); }
 
 size_t nk::utils::bsf(size_t value) { return __builtin_clzll(value); }
 
@@ -46,33 +17,10 @@ size_t nk::utils::bsr(size_t value) { return __builtin_ctzll(value); }
 
 size_t nk::utils::popcnt(size_t value) { return __builtin_popcount(value); }
 
-void nk::utils::initMemoryFunctions(NkReallocFunc reallocFunc,
-                                    NkFreeFunc freeFunc) {
-    globalRealloc = reallocFunc;
-    globalFree = freeFunc;
-    if (globalRealloc == nullptr || globalFree == nullptr) {
-        NK_LOG("Using stdlib realloc and free");
-        globalRealloc = &realloc;
-        globalFree = &free;
-    }
+uint64_t nk::utils::timeNs() {
+    return (uint64_t)(emscripten_get_now() * 1.0e6);
 }
 
-void* nk::utils::memRealloc(void* ptr, size_t size) {
-    NK_ASSERT_EXIT(globalRealloc,
-                   "Error: Memory allocation functions not setup. "
-                   "nk::utils::initMemoryFunctions must be called.");
-    return globalRealloc(ptr, size);
-}
-
-void nk::utils::memFree(void* ptr) {
-    NK_ASSERT_EXIT(globalFree,
-                   "Error: Memory allocation functions not setup. "
-                   "nk::utils::initMemoryFunctions must be called.");
-    globalFree(ptr);
-}
-
-void* nk::utils::memZeroAlloc(size_t num, size_t size) {
-    void* ptr = memRealloc(nullptr, size * num);
-    memset(ptr, 0, size * num);
-    return ptr;
-}
+// Blocking the browser thread isn't possible without asyncify, so the wait
+// is left to the caller.
+void nk::utils::sleepNs(uint64_t ns) {}
@@ -20,10 +20,17 @@ namespace nk {
 NkAppResizeInfo internalResizeInfo = {0, 0, false};
 
 NkApp* nk::app::create(const NkAppInfo& info) {
-    nk::utils::initMemoryFunctions(info.reallocFunc, info.freeFunc);
-    NkApp* app = (NkApp*)nk::utils::memZeroAlloc(1, sizeof(NkApp));
-    if (!app)
+    nk::utils::initMemoryFunctions(info.allocator, info.reallocFunc,
+                                   info.freeFunc);
+    NkApp* app =
+        (NkApp*)nk::utils::memZeroAlloc(1, sizeof(NkApp), NkMemoryTag::APP);
+    if (!app) {
+        nk::utils::destroyMemoryFunctions();
         return nullptr;
+    }
+    nk::utils::initJobs(info.jobWorkerNum);
+    nk::utils::initFrameArena();
+    nk::utils::initProfiler();
 
     if (info.allowResize && info.fullScreen) {
         NK_LOG("Warning: Window resize and full screen is not supported. Full "
@@ -113,6 +120,7 @@ NkApp* nk::app::create(const NkAppInfo& info) {
 NkCanvas* nk::app::canvas(NkApp* app) { return app->canvas; }
 
 bool nk::app::destroy(NkApp* app) {
+    nk::utils::destroyJobs();
     nk::hid::destroy(app->hid);
     nk::canvas::destroy(app->canvas);
     CloseWindow(app->windowHandle);
@@ -120,13 +128,18 @@ bool nk::app::destroy(NkApp* app) {
     app->shouldQuit = true;
 
     if (app != nullptr) {
-        nk::utils::memFree(app);
+        nk::utils::memFree(app, NkMemoryTag::APP);
     }
+    nk::utils::destroyFrameArena();
+    nk::utils::destroyProfiler();
+    nk::utils::destroyMemoryFunctions();
+    nk::utils::flushLog();
     return false;
 }
 
 void nk::app::update(NkApp* app) {
     MSG message;
+    app->frameClock.tick();
     if (internalResizeInfo.shouldResize) {
         internalResizeInfo.oldWidth = app->windowWidth;
         internalResizeInfo.oldHeight = app->windowHeight;
@@ -187,3 +200,19 @@ bool nk::app::shouldResize(const NkApp* app, uint32_t* newWidth,
 }
 
 void nk::app::quit(NkApp* app) { app->shouldQuit = true; }
+
+double nk::app::frameTime(const NkApp* app) {
+    return app->frameClock.frameTime;
+}
+
+double nk::app::timeSinceUpdate(const NkApp* app) {
+    return app->frameClock.timeSinceTick();
+}
+
+void nk::app::limitFrameRate(NkApp* app, double targetFrameTime) {
+    app->frameClock.limit(targetFrameTime);
+}
+
+NkFrameLimiterStats nk::app::frameLimiterStats(const NkApp* app) {
+    return app->frameClock.stats();
+}
@@ -53,6 +53,12 @@ struct VertexOut {
 float4 main(VertexOut vtx) : SV_TARGET {
 	return mainTexture[vtx.textureId].SampleLevel(samplerPoint, vtx.texCoord, 0) * vtx.color;
 }
+
+// The multiply blend mode needs premultiplied alpha.
+float4 mainMultiply(VertexOut vtx) : SV_TARGET {
+	float4 color = mainTexture[vtx.textureId].SampleLevel(samplerPoint, vtx.texCoord, 0) * vtx.color;
+	return float4(color.rgb * color.a, color.a);
+}
 )";
 #else
 static const char spriteVS[] = R"(
@@ -90,9 +96,39 @@ struct VertexOut { float4 position : SV_POSITION; float2 texCoord : TEXCOORD; fl
 float4 main(VertexOut vtx) : SV_TARGET {
 	return mainTexture.Sample(samplerPoint, vtx.texCoord) * vtx.color;
 }
+
+// The multiply blend mode needs premultiplied alpha.
+float4 mainMultiply(VertexOut vtx) : SV_TARGET {
+	float4 color = mainTexture.Sample(samplerPoint, vtx.texCoord) * vtx.color;
+	return float4(color.rgb * color.a, color.a);
+}
 )";
 #endif
 
+#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
+#define NK_D3D12_VS_PROFILE     "vs_5_1"
+#define NK_D3D12_PS_PROFILE     "ps_5_1"
+#define NK_D3D12_COMPILE_FLAGS  D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES
+#else
+#define NK_D3D12_VS_PROFILE     "vs_5_0"
+#define NK_D3D12_PS_PROFILE     "ps_5_0"
+#define NK_D3D12_COMPILE_FLAGS  0
+#endif
+
+static ID3DBlob* compileShader(const char* source, const char* entryPoint,
+                               const char* profile) {
+    ID3DBlob *blob = nullptr, *errorBlob = nullptr;
+    if (D3DCompile(source, strlen(source), nullptr, nullptr, nullptr,
+                   entryPoint, profile, NK_D3D12_COMPILE_FLAGS, 0, &blob,
+                   &errorBlob) != S_OK) {
+        NK_LOG("Error: Failed to compile shader %s.\n%s", entryPoint,
+               errorBlob ? errorBlob->GetBufferPointer() : "");
+        NK_PANIC("error");
+    }
+    D3D_RELEASE(errorBlob);
+    return blob;
+}
+
 // Source: https://devblogs.microsoft.com/pix/taking-a-capture/
 static void loadPIX() {
     if (GetModuleHandleA("WinPixGpuCapture.dll") == 0) {
@@ -271,7 +307,8 @@ NkD3D12Resource* nk::d3d12::createBuffer(size_t bufferSize,
                                          NkBufferType bufferType,
                                          const wchar_t* name) {
     NkD3D12Resource* buffer =
-        (NkD3D12Resource*)nk::utils::memZeroAlloc(1, sizeof(NkD3D12Resource));
+        (NkD3D12Resource*)nk::utils::memZeroAlloc(1, sizeof(NkD3D12Resource),
+                                                  NkMemoryTag::CANVAS);
     if (!buffer)
         return nullptr;
     buffer->resource =
@@ -285,7 +322,7 @@ NkD3D12DynamicBuffer* nk::d3d12::createDynamicBuffer(size_t bufferSize,
                                                      const wchar_t* name) {
     NkD3D12DynamicBuffer* buffer =
         (NkD3D12DynamicBuffer*)nk::utils::memZeroAlloc(
-            1, sizeof(NkD3D12DynamicBuffer));
+            1, sizeof(NkD3D12DynamicBuffer), NkMemoryTag::CANVAS);
     if (!buffer)
         return nullptr;
     buffer->resource.resource = createNativeBuffer(bufferSize, bufferType, name,
@@ -300,7 +337,8 @@ NkD3D12DynamicBuffer* nk::d3d12::createDynamicBuffer(size_t bufferSize,
 NkImage* nk::d3d12::createImage(NkCanvas* canvas, uint32_t width,
                                 uint32_t height, NkImageFormat format,
                                 const void* pixels) {
-    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage));
+    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage),
+                                                       NkMemoryTag::IMAGE);
     if (!image)
         return nullptr;
     DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -347,7 +385,8 @@ NkImage* nk::d3d12::createImage(NkCanvas* canvas, uint32_t width,
                                       L"NkImage::uploadBuffer", nullptr);
     image->buffer.uploadBuffer->SetName(L"NkImage::uploadBuffer");
     image->state = 0;
-    image->cpuData = nk::utils::memRealloc(nullptr, pixelSize * width * height);
+    image->cpuData = nk::utils::memRealloc(nullptr, pixelSize * width * height,
+                                           NkMemoryTag::IMAGE);
     if (image->cpuData) {
         memcpy(image->cpuData, pixels, pixelSize * width * height);
     } else {
@@ -359,7 +398,8 @@ NkImage* nk::d3d12::createImage(NkCanvas* canvas, uint32_t width,
 
 NkImage* nk::d3d12::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
                                             uint32_t height) {
-    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage));
+    NkImage* image = (NkImage*)nk::utils::memZeroAlloc(1, sizeof(NkImage),
+                                                       NkMemoryTag::IMAGE);
     if (!image)
         return nullptr;
     DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -409,8 +449,8 @@ void nk::d3d12::destroyImage(NkImage* image) {
     if (image) {
         D3D_RELEASE(image->buffer.resource.resource);
         D3D_RELEASE(image->buffer.uploadBuffer);
-        nk::utils::memFree(image->cpuData);
-        nk::utils::memFree(image);
+        nk::utils::memFree(image->cpuData, NkMemoryTag::IMAGE);
+        nk::utils::memFree(image, NkMemoryTag::IMAGE);
     }
 }
 
@@ -610,12 +650,15 @@ void NkD3D12Fence::waitForValue(uint64_t waitValue) {
 }
 
 void NkImageArray::init() {
-    images = (NkImage**)nk::utils::memRealloc(nullptr, sizeof(NkImage*) * 16);
+    images = (NkImage**)nk::utils::memRealloc(nullptr, sizeof(NkImage*) * 16,
+                                              NkMemoryTag::CANVAS);
     imageNum = 0;
     imageMax = 16;
 }
 
-void NkImageArray::destroy() { nk::utils::memFree(images); }
+void NkImageArray::destroy() {
+    nk::utils::memFree(images, NkMemoryTag::CANVAS);
+}
 
 void NkImageArray::reset() { imageNum = 0; }
 
@@ -623,7 +666,8 @@ void NkImageArray::add(NkImage* image) {
     if (imageNum + 1 > imageMax) {
         imageMax *= 2;
         images = (NkImage**)nk::utils::memRealloc(images,
-                                                  sizeof(NkImage*) * imageMax);
+                                                  sizeof(NkImage*) * imageMax,
+                                                  NkMemoryTag::CANVAS);
     }
     if (images) {
         images[imageNum++] = image;
@@ -646,7 +690,7 @@ void nk::canvas_internal::destroyVertexBuffer(
             (NkD3D12DynamicBuffer*)vertexBuffer->gpuVertexBuffer;
         D3D_RELEASE(buffer->resource.resource);
         D3D_RELEASE(buffer->uploadBuffer);
-        nk::utils::memFree(buffer);
+        nk::utils::memFree(buffer, NkMemoryTag::CANVAS);
         vertexBuffer->gpuVertexBuffer = nullptr;
     }
 }
@@ -665,7 +709,7 @@ void nk::canvas_internal::destroyIndexBuffer(void** gpuIndexBuffer) {
         NkD3D12DynamicBuffer* buffer = (NkD3D12DynamicBuffer*)*gpuIndexBuffer;
         D3D_RELEASE(buffer->resource.resource);
         D3D_RELEASE(buffer->uploadBuffer);
-        nk::utils::memFree(buffer);
+        nk::utils::memFree(buffer, NkMemoryTag::CANVAS);
         *gpuIndexBuffer = nullptr;
     }
 }
@@ -686,7 +730,8 @@ void nk::canvas_internal::waitFrameSyncPoint(NkGPUHandle gpuSyncPoint,
 
 void nk::canvas_internal::initFrameSyncPoint(NkGPUHandle* gpuSyncPoint) {
     NkD3D12Fence* fence =
-        (NkD3D12Fence*)nk::utils::memZeroAlloc(1, sizeof(NkD3D12Fence));
+        (NkD3D12Fence*)nk::utils::memZeroAlloc(1, sizeof(NkD3D12Fence),
+                                               NkMemoryTag::CANVAS);
     if (fence) {
         fence->init(nk::d3d12::instance()->device);
         *gpuSyncPoint = (NkGPUHandle)fence;
@@ -697,7 +742,7 @@ void nk::canvas_internal::destroyFrameSyncPoint(NkGPUHandle* gpuSyncPoint) {
     if (gpuSyncPoint && *gpuSyncPoint) {
         NkD3D12Fence* fence = (NkD3D12Fence*)*gpuSyncPoint;
         fence->destroy();
-        nk::utils::memFree(fence);
+        nk::utils::memFree(fence, NkMemoryTag::CANVAS);
         *gpuSyncPoint = nullptr;
     }
 }
@@ -706,6 +751,182 @@ NkCanvasBase* nk::canvas_internal::canvasBase(NkCanvas* canvas) {
     return &canvas->base;
 }
 
+static NkD3D12Readback* createReadback(NkCanvas* canvas,
+                                       uint64_t bufferSize) {
+    NkD3D12Readback* readback =
+        (NkD3D12Readback*)nk::utils::memZeroAlloc(1, sizeof(NkD3D12Readback),
+                                                  NkMemoryTag::CANVAS);
+    if (!readback)
+        return nullptr;
+    ID3D12Device5* device = nk::d3d12::instance()->device;
+    readback->canvas = canvas;
+    readback->bufferSize = bufferSize;
+
+    D3D12_RESOURCE_DESC resourceDesc = {
+        .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+        .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+        .Width = bufferSize,
+        .Height = 1,
+        .DepthOrArraySize = 1,
+        .MipLevels = 1,
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .SampleDesc = {.Count = 1, .Quality = 0},
+        .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        .Flags = D3D12_RESOURCE_FLAG_NONE};
+    D3D12_HEAP_PROPERTIES heapProps = {
+        .Type = D3D12_HEAP_TYPE_READBACK,
+        .CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+        .MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
+        .CreationNodeMask = 0,
+        .VisibleNodeMask = 0};
+    D3D_ASSERT(device->CreateCommittedResource(
+                   &heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+                   D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+                   IID_PPV_ARGS(&readback->buffer)),
+               "Error: Failed to create readback buffer");
+    readback->buffer->SetName(L"NkCanvas::readbackBuffer");
+    D3D_ASSERT(device->CreateCommandAllocator(
+                   D3D12_COMMAND_LIST_TYPE_DIRECT,
+                   IID_PPV_ARGS(&readback->commandList.commandAllocator)),
+               "Error: Failed to create readback command allocator");
+    D3D_ASSERT(device->CreateCommandList(
+                   0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+                   readback->commandList.commandAllocator, nullptr,
+                   IID_PPV_ARGS(&readback->commandList.commandList)),
+               "Error: Failed to create readback command list");
+    // Closed so every read can reset it the same way.
+    D3D_ASSERT(readback->commandList.commandList->Close(),
+               "Error: Failed to close command list");
+    D3D_ASSERT(device->CreateFence(0, D3D12_FENCE_FLAG_NONE,
+                                   IID_PPV_ARGS(&readback->fence)),
+               "Error: Failed to create readback fence");
+    return readback;
+}
+
+static void releaseReadback(NkD3D12Readback* readback) {
+    if (readback->mappedData) {
+        D3D12_RANGE writeRange = {0, 0};
+        readback->buffer->Unmap(0, &writeRange);
+    }
+    D3D_RELEASE(readback->commandList.commandList);
+    D3D_RELEASE(readback->commandList.commandAllocator);
+    D3D_RELEASE(readback->fence);
+    D3D_RELEASE(readback->buffer);
+    nk::utils::memFree(readback, NkMemoryTag::CANVAS);
+}
+
+// Takes the most recently pooled readback of the given size.
+static NkD3D12Readback* takePooledReadback(NkCanvas* canvas,
+                                           uint64_t bufferSize) {
+    for (uint32_t index = canvas->readbackPoolNum; index-- > 0;) {
+        NkD3D12Readback* readback = canvas->readbackPool[index];
+        if (readback->bufferSize == bufferSize) {
+            canvas->readbackPoolNum--;
+            memmove(&canvas->readbackPool[index],
+                    &canvas->readbackPool[index + 1],
+                    (canvas->readbackPoolNum - index) *
+                        sizeof(NkD3D12Readback*));
+            return readback;
+        }
+    }
+    return nullptr;
+}
+
+NkGPUHandle nk::canvas_internal::beginReadback(NkCanvas* canvas,
+                                               NkImage* image) {
+    NkD3D12Resource& texture = image->buffer.resource;
+    if (!(texture.desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)) {
+        return nullptr;
+    }
+    ID3D12Device5* device = nk::d3d12::instance()->device;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint{};
+    uint64_t bufferSize = 0;
+    device->GetCopyableFootprints(&texture.desc, 0, 1, 0, &footprint, nullptr,
+                                  nullptr, &bufferSize);
+    NkD3D12Readback* readback = takePooledReadback(canvas, bufferSize);
+    if (!readback) {
+        readback = createReadback(canvas, bufferSize);
+        if (!readback)
+            return nullptr;
+    }
+    readback->rowPitch = footprint.Footprint.RowPitch;
+
+    // The pool only holds readbacks whose fence was reached, so the
+    // allocator is free to reset.
+    NkD3D12CommandList& readbackCommandList = readback->commandList;
+    D3D_ASSERT(readbackCommandList.commandAllocator->Reset(),
+               "Error: Failed to reset readback command allocator");
+    D3D_ASSERT(readbackCommandList.commandList->Reset(
+                   readbackCommandList.commandAllocator, nullptr),
+               "Error: Failed to reset readback command list");
+
+    // Render targets rest in the pixel shader resource state between frames.
+    ID3D12GraphicsCommandList* commandList = readbackCommandList.commandList;
+    D3D12_RESOURCE_BARRIER barrier{};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = texture.resource;
+    barrier.Transition.Subresource = 0;
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+    commandList->ResourceBarrier(1, &barrier);
+
+    D3D12_TEXTURE_COPY_LOCATION destLocation{};
+    destLocation.pResource = readback->buffer;
+    destLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    destLocation.PlacedFootprint = footprint;
+    D3D12_TEXTURE_COPY_LOCATION srcLocation{};
+    srcLocation.pResource = texture.resource;
+    srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    srcLocation.SubresourceIndex = 0;
+    commandList->CopyTextureRegion(&destLocation, 0, 0, 0, &srcLocation,
+                                   nullptr);
+
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    commandList->ResourceBarrier(1, &barrier);
+    D3D_ASSERT(commandList->Close(), "Error: Failed to close command list");
+
+    // The queue runs the copy after every frame submitted so far.
+    ID3D12CommandList* commandLists[] = {commandList};
+    canvas->commandQueue->ExecuteCommandLists(1, commandLists);
+    canvas->commandQueue->Signal(readback->fence, ++readback->fenceValue);
+    return (NkGPUHandle)readback;
+}
+
+const void* nk::canvas_internal::mapReadback(NkGPUHandle gpuReadback,
+                                             uint32_t* rowPitch) {
+    NkD3D12Readback* readback = (NkD3D12Readback*)gpuReadback;
+    if (readback->fence->GetCompletedValue() < readback->fenceValue) {
+        return nullptr;
+    }
+    if (!readback->mappedData) {
+        D3D12_RANGE readRange = {0, readback->bufferSize};
+        D3D_ASSERT(readback->buffer->Map(0, &readRange, &readback->mappedData),
+                   "Error: Failed to map readback buffer");
+    }
+    *rowPitch = readback->rowPitch;
+    return readback->mappedData;
+}
+
+void nk::canvas_internal::destroyReadback(NkGPUHandle gpuReadback) {
+    NkD3D12Readback* readback = (NkD3D12Readback*)gpuReadback;
+    // A null event blocks until the fence is reached. It only happens when
+    // the read is dropped before it completed.
+    if (readback->fence->GetCompletedValue() < readback->fenceValue) {
+        readback->fence->SetEventOnCompletion(readback->fenceValue, nullptr);
+    }
+    NkCanvas* canvas = readback->canvas;
+    if (canvas->readbackPoolNum == NK_CANVAS_MAX_READBACKS) {
+        // Make room by dropping the oldest one.
+        releaseReadback(canvas->readbackPool[0]);
+        canvas->readbackPoolNum--;
+        memmove(&canvas->readbackPool[0], &canvas->readbackPool[1],
+                canvas->readbackPoolNum * sizeof(NkD3D12Readback*));
+    }
+    canvas->readbackPool[canvas->readbackPoolNum++] = readback;
+}
+
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
 void nk::canvas_internal::initTextureAtlasResource(
     NkCanvas* canvas, NkTextureAtlas& textureAtlas) {
@@ -755,6 +976,10 @@ void nk::canvas_internal::setTextureAtlasState(NkImage* image,
     image->rect = rect;
 }
 
+void nk::canvas_internal::clearTextureAtlasState(NkImage* image) {
+    image->state &= ~NK_IMAGE_BIT_TEXTURE_ATLAS;
+}
+
 bool nk::canvas_internal::isImageInTextureAtlas(NkImage* image) {
     return (image->state & NK_IMAGE_BIT_TEXTURE_ATLAS) > 0;
 }
@@ -766,7 +991,8 @@ const NkTextureAtlasRect& nk::canvas_internal::textureRect(NkImage* image) {
 #endif
 
 NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
-    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas));
+    NkCanvas* canvas = (NkCanvas*)nk::utils::memZeroAlloc(1, sizeof(NkCanvas),
+                                                          NkMemoryTag::CANVAS);
     if (!canvas)
         return nullptr;
     canvas->app = app;
@@ -845,23 +1071,14 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
                                      IID_PPV_ARGS(&canvas->rtvDescriptorHeap)),
         "Error: Failed to create RTV descriptor heap");
 
-    canvas->base.indicesUploaded = false;
-
+    // The bindless build ships the default shaders as precompiled DXIL. The
+    // multiply pixel shader is compiled here in both builds, and since DXBC
+    // and DXIL can't be mixed in one PSO it comes with its own vertex shader.
+    ID3DBlob* vsBlob = compileShader(spriteVS, "main", NK_D3D12_VS_PROFILE);
+    ID3DBlob* multiplyPSBlob =
+        compileShader(spritePS, "mainMultiply", NK_D3D12_PS_PROFILE);
 #if !NK_CANVAS_BINDLESS_RESOURCE_ENABLED
-    ID3DBlob *vsBlob, *psBlob, *errorBlob;
-    if (D3DCompile(spriteVS, strlen(spriteVS), nullptr, nullptr, nullptr,
-                   "main", "vs_5_0", 0, 0, &vsBlob, &errorBlob) != S_OK) {
-        NK_LOG("Error: Failed to compile vertex shader.\n%s",
-               errorBlob ? errorBlob->GetBufferPointer() : "");
-        NK_PANIC("error");
-    }
-
-    if (D3DCompile(spritePS, strlen(spritePS), nullptr, nullptr, nullptr,
-                   "main", "ps_5_0", 0, 0, &psBlob, &errorBlob) != S_OK) {
-        NK_LOG("Error: Failed to compile pixel shader.\n%s",
-               errorBlob ? errorBlob->GetBufferPointer() : "");
-        NK_PANIC("error");
-    }
+    ID3DBlob* psBlob = compileShader(spritePS, "main", NK_D3D12_PS_PROFILE);
 #endif
 
     D3D12_ROOT_PARAMETER rootParameters[2] = {};
@@ -936,9 +1153,7 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
         D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
     ID3DBlob* rootSignatureBlob;
-#if NK_CANVAS_BINDLESS_RESOURCE_ENABLED
-    ID3DBlob* errorBlob;
-#endif
+    ID3DBlob* errorBlob = nullptr;
     if (D3D12SerializeRootSignature(&rootSignatureDesc,
                                     D3D_ROOT_SIGNATURE_VERSION_1,
                                     &rootSignatureBlob, &errorBlob) != S_OK) {
@@ -1061,13 +1276,53 @@ NkCanvas* nk::canvas::create(NkApp* app, bool allowResize) {
     spritePSODesc.InputLayout.NumElements =
         sizeof(inputElementDesc) / sizeof(D3D12_INPUT_ELEMENT_DESC);
 
-    D3D_ASSERT(device->CreateGraphicsPipelineState(
-                   &spritePSODesc, IID_PPV_ARGS(&canvas->spritePSO)),
-               "Error: Failed to create PSO");
+    D3D12_SHADER_BYTECODE defaultVS = spritePSODesc.VS;
+    D3D12_SHADER_BYTECODE defaultPS = spritePSODesc.PS;
+    for (uint32_t index = 0; index < NK_CANVAS_BLEND_MODE_COUNT; ++index) {
+        D3D12_RENDER_TARGET_BLEND_DESC& blendDesc =
+            spritePSODesc.BlendState.RenderTarget[0];
+        spritePSODesc.VS = defaultVS;
+        spritePSODesc.PS = defaultPS;
+        switch ((NkBlendMode)index) {
+        case NkBlendMode::ALPHA:
+            blendDesc.BlendEnable = true;
+            blendDesc.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+            blendDesc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+            blendDesc.SrcBlendAlpha = D3D12_BLEND_ONE;
+            blendDesc.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+            break;
+        case NkBlendMode::ADDITIVE:
+            blendDesc.BlendEnable = true;
+            blendDesc.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+            blendDesc.DestBlend = D3D12_BLEND_ONE;
+            blendDesc.SrcBlendAlpha = D3D12_BLEND_ZERO;
+            blendDesc.DestBlendAlpha = D3D12_BLEND_ONE;
+            break;
+        case NkBlendMode::MULTIPLY:
+            // dst * lerp(1, src, srcAlpha), the shader premultiplies src.
+            spritePSODesc.VS = {vsBlob->GetBufferPointer(),
+                                vsBlob->GetBufferSize()};
+            spritePSODesc.PS = {multiplyPSBlob->GetBufferPointer(),
+                                multiplyPSBlob->GetBufferSize()};
+            blendDesc.BlendEnable = true;
+            blendDesc.SrcBlend = D3D12_BLEND_DEST_COLOR;
+            blendDesc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+            blendDesc.SrcBlendAlpha = D3D12_BLEND_ZERO;
+            blendDesc.DestBlendAlpha = D3D12_BLEND_ONE;
+            break;
+        case NkBlendMode::NONE:
+            blendDesc.BlendEnable = false;
+            break;
+        }
+        D3D_ASSERT(device->CreateGraphicsPipelineState(
+                       &spritePSODesc, IID_PPV_ARGS(&canvas->spritePSO[index])),
+                   "Error: Failed to create PSO");
+    }
 
     D3D_RELEASE(rootSignatureBlob);
-#if !NK_CANVAS_BINDLESS_RESOURCE_ENABLED
     D3D_RELEASE(vsBlob);
+    D3D_RELEASE(multiplyPSBlob);
+#if !NK_CANVAS_BINDLESS_RESOURCE_ENABLED
     D3D_RELEASE(psBlob);
 #endif
     D3D_RELEASE(errorBlob);
@@ -1084,6 +1339,10 @@ bool nk::canvas::destroy(NkCanvas* canvas) {
         canvas->base.signalCurrentFrame();
         canvas->base.waitCurrentFrame();
         canvas->base.destroy(canvas);
+        for (uint32_t index = 0; index < canvas->readbackPoolNum; ++index) {
+            releaseReadback(canvas->readbackPool[index]);
+        }
+        canvas->readbackPoolNum = 0;
 
         for (uint32_t index = 0; index < NK_CANVAS_MAX_FRAMES; ++index) {
             for (uint32_t imgIndex = 0;
@@ -1096,7 +1355,9 @@ bool nk::canvas::destroy(NkCanvas* canvas) {
         }
 
         D3D_RELEASE(canvas->spriteRootSignature);
-        D3D_RELEASE(canvas->spritePSO);
+        for (uint32_t index = 0; index < NK_CANVAS_BLEND_MODE_COUNT; ++index) {
+            D3D_RELEASE(canvas->spritePSO[index]);
+        }
 
         D3D_RELEASE(canvas->rtvDescriptorHeap);
 
@@ -1138,6 +1399,17 @@ void nk::canvas::scale(NkCanvas* canvas, float x, float y) {
     canvas->base.scale(x, y);
 }
 
+void nk::canvas::pushClipRect(NkCanvas* canvas, float x, float y, float width,
+                              float height) {
+    canvas->base.pushClipRect(x, y, width, height);
+}
+
+void nk::canvas::popClipRect(NkCanvas* canvas) { canvas->base.popClipRect(); }
+
+void nk::canvas::setBlendMode(NkCanvas* canvas, NkBlendMode blendMode) {
+    canvas->base.setBlendMode(blendMode);
+}
+
 void nk::canvas::drawLine(NkCanvas* canvas, float x0, float y0, float x1,
                           float y1, float lineWidth, uint32_t color) {
     canvas->base.drawLine(x0, y0, x1, y1, lineWidth, color);
@@ -1188,10 +1460,52 @@ void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
     nk::d3d12::processImage(canvas, image);
 }
 
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, transform, color, image);
+    nk::d3d12::processImage(canvas, image);
+}
+
+void nk::canvas::drawImage(NkCanvas* canvas, float x, float y, float width,
+                           float height, float frameX, float frameY,
+                           float frameWidth, float frameHeight,
+                           const NkImageTransform& transform, uint32_t color,
+                           NkImage* image) {
+    canvas->base.drawImage(x, y, width, height, frameX, frameY, frameWidth,
+                           frameHeight, transform, color, image);
+    nk::d3d12::processImage(canvas, image);
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteDesc* sprites,
+                            uint32_t count, NkImage* image) {
+    canvas->base.drawImages(sprites, count, image);
+    nk::d3d12::processImage(canvas, image);
+}
+
+void nk::canvas::drawImages(NkCanvas* canvas, const NkSpriteArrays& sprites,
+                            uint32_t count, NkImage* image) {
+    canvas->base.drawImages(sprites, count, image);
+    nk::d3d12::processImage(canvas, image);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectDesc* rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawRects(NkCanvas* canvas, const NkRectArrays& rects,
+                           uint32_t count) {
+    canvas->base.drawRects(rects, count);
+}
+
+void nk::canvas::drawPerfOverlay(NkCanvas* canvas, float x, float y) {
+    canvas->base.drawPerfOverlay(x, y);
+}
+
 void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
                             float a) {
-    NK_PROFILER_BEGIN_EVENT_COLOR("DrawFrame",
-                                  NK_PROFILER_COLOR(0xff, 0xff, 0));
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
     canvas->clearColor[0] = r;
     canvas->clearColor[1] = g;
     canvas->clearColor[2] = b;
@@ -1201,8 +1515,7 @@ void nk::canvas::beginFrame(NkCanvas* canvas, float r, float g, float b,
 
 void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
                             float g, float b, float a) {
-    NK_PROFILER_BEGIN_EVENT_COLOR("DrawFrame",
-                                  NK_PROFILER_COLOR(0xff, 0xff, 0));
+    NK_PROFILER_BEGIN_EVENT("DrawFrame");
     canvas->clearColor[0] = r;
     canvas->clearColor[1] = g;
     canvas->clearColor[2] = b;
@@ -1212,18 +1525,22 @@ void nk::canvas::beginFrame(NkCanvas* canvas, NkImage* renderTarget, float r,
 }
 
 void nk::canvas::endFrame(NkCanvas* canvas) {
-    canvas->base.endFrame(canvas);
-    nk::d3d12::drawFrame(
-        canvas, canvas->base.currentFrameIndex); // TODO: look into running this
-                                                 // in a different thread.
+    NK_CANVAS_STAT_SCOPED_TIMER(canvas->base, endFrameTime);
+    canvas->base.endFrame(canvas, canvas->renderTarget);
+    canvas->base.capture.writeFrame(canvas->base, canvas->renderTarget,
+                                    canvas->clearColor);
+    if (!canvas->base.skipFrame(canvas->renderTarget, canvas->clearColor)) {
+        // TODO: look into running this in a different thread.
+        nk::d3d12::drawFrame(canvas, canvas->base.currentFrameIndex);
+    }
     canvas->base.swapFrame(canvas);
     canvas->renderTarget = nullptr;
     NK_PROFILER_END_EVENT();
 }
 
 void nk::canvas::present(NkCanvas* canvas) {
-    NK_PROFILER_SCOPED_EVENT_COLOR_ARGS("Present",
-                                        NK_PROFILER_COLOR(0x00, 0xff, 0xff));
+    NK_PROFILER_SCOPED_EVENT("Present");
+    NK_CANVAS_STAT_SCOPED_TIMER(canvas->base, presentTime);
 
     // Check if we need to resize the canvas
     if (canvas->allowResize && internalResizeInfo.shouldResize) {
@@ -1256,7 +1573,19 @@ void nk::canvas::present(NkCanvas* canvas) {
         }
     }
 
-    canvas->swapChain->Present(canvas->app->vsyncEnabled, 0);
+    if (canvas->base.frameSkipped) {
+        // Nothing changed since the last presented frame. Keep it on screen
+        // and only wait for the vertical blank so the frame pacing doesn't
+        // change.
+        IDXGIOutput* output = nullptr;
+        if (canvas->app->vsyncEnabled &&
+            SUCCEEDED(canvas->swapChain->GetContainingOutput(&output))) {
+            output->WaitForVBlank();
+            D3D_RELEASE(output);
+        }
+    } else {
+        canvas->swapChain->Present(canvas->app->vsyncEnabled, 0);
+    }
 
     for (uint32_t imgIndex = 0;
          imgIndex <
@@ -1269,23 +1598,70 @@ void nk::canvas::present(NkCanvas* canvas) {
     canvas->imagesToDestroy[canvas->base.currentFrameIndex].reset();
 }
 
+const NkCanvasFrameStats& nk::canvas::frameStats(NkCanvas* canvas) {
+    return canvas->base.lastFrameStats;
+}
+
+void nk::canvas::setSkipIdenticalFrames(NkCanvas* canvas, bool enabled) {
+    canvas->base.skipIdenticalFrames = enabled;
+    canvas->base.invalidateFrameHash();
+}
+
+bool nk::canvas::beginCapture(NkCanvas* canvas, const char* path) {
+    return canvas->base.capture.begin(path);
+}
+
+void nk::canvas::endCapture(NkCanvas* canvas) { canvas->base.capture.end(); }
+
+bool nk::canvas::readPixelsAsync(NkCanvas* canvas, NkImage* image,
+                                 NkReadPixelsFunc callback, void* userData) {
+    return canvas->base.readbacks.push(canvas, image, callback, userData);
+}
+
+bool nk::canvas::beginVideoCapture(NkCanvas* canvas, const char* path,
+                                   NkVideoFormat format, uint32_t frameRate) {
+    return canvas->base.video.begin(canvas->base, path, format, frameRate);
+}
+
+bool nk::canvas::captureVideoFrame(NkCanvas* canvas, NkImage* renderTarget) {
+    return canvas->base.video.captureFrame(canvas->base, renderTarget);
+}
+
+void nk::canvas::endVideoCapture(NkCanvas* canvas) {
+    canvas->base.video.end(canvas->base);
+}
+
 float nk::canvas::viewWidth(NkCanvas* canvas) { return canvas->base.width(); }
 
 float nk::canvas::viewHeight(NkCanvas* canvas) { return canvas->base.height(); }
 
 NkImage* nk::canvas::createRenderTargetImage(NkCanvas* canvas, uint32_t width,
                                              uint32_t height) {
-    return nk::d3d12::createRenderTargetImage(canvas, width, height);
+    NkImage* image = nk::d3d12::createRenderTargetImage(canvas, width, height);
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, nullptr,
+                                      NkImageFormat::R8G8B8A8_UNORM, true);
+    return image;
 }
 
 NkImage* nk::canvas::createImage(NkCanvas* canvas, uint32_t width,
                                  uint32_t height, const void* pixels,
                                  NkImageFormat format) {
-    return nk::d3d12::createImage(canvas, width, height, format, pixels);
+    NkImage* image =
+        nk::d3d12::createImage(canvas, width, height, format, pixels);
+    canvas->base.invalidateFrameHash();
+    canvas->base.capture.imageCreated(image, pixels, format, false);
+    return image;
 }
 
 bool nk::canvas::destroyImage(NkCanvas* canvas, NkImage* image) {
     if (image) {
+        canvas->base.invalidateFrameHash();
+        canvas->base.capture.imageDestroyed(image);
+        canvas->base.readbacks.imageDestroyed(image);
+#if NK_CANVAS_TEXTURE_ATLAS_ENABLED
+        canvas->base.frameTextureAtlas.removeImage(image);
+#endif
         canvas->imagesToDestroy[canvas->base.currentFrameIndex].add(image);
         return true;
     }
@@ -1297,9 +1673,7 @@ float nk::img::width(NkImage* image) { return image->width; }
 float nk::img::height(NkImage* image) { return image->height; }
 
 void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
-    NK_PROFILER_SCOPED_EVENT_COLOR_ARGS("D3D12_DrawFrame %u",
-                                        NK_PROFILER_COLOR(0xff, 0x00, 0xff),
-                                        currentFrameIndex);
+    NK_PROFILER_SCOPED_EVENT("D3D12_DrawFrame");
     // Start frame
     D3D12_RENDER_TARGET_VIEW_DESC rtvDesc{};
     rtvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -1329,8 +1703,10 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
         canvas->commandLists[currentFrameIndex].commandAllocator;
     D3D_ASSERT(commandAllocator->Reset(),
                "Error: Failed to reset command allocator");
-    D3D_ASSERT(commandList->Reset(commandAllocator, canvas->spritePSO),
-               "Error: Failed to reset command list");
+    D3D_ASSERT(
+        commandList->Reset(commandAllocator,
+                           canvas->spritePSO[(uint32_t)NkBlendMode::ALPHA]),
+        "Error: Failed to reset command list");
     NkD3D12DescriptorAllocator& descriptorAllocator =
         canvas->descriptorAllocators[currentFrameIndex];
     descriptorAllocator.reset();
@@ -1344,7 +1720,7 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
                    "Error: Failed to map index buffer uploead buffer");
         if (mappedIndices) {
             memcpy(mappedIndices, canvas->base.indexBufferData(),
-                   NK_CANVAS_MAX_INDICES_BYTE_SIZE);
+                   canvas->base.indexBufferSize());
         } else {
             NK_PANIC("Error: Invalid address for index buffer");
         }
@@ -1403,6 +1779,7 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
             memcpy(dstAddr, srcAddr, (size_t)rowSizeInBytes);
         }
         uploadBuffer->Unmap(0, nullptr);
+        NK_CANVAS_STAT_ADD(canvas->base, uploadedBytes, totalBytes);
 
         D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
         srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
@@ -1433,7 +1810,7 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
             D3D12_RESOURCE_STATE_COPY_DEST;
         commandList->ResourceBarrier(1, textureBufferBarrier);
 
-        nk::utils::memFree(image->cpuData);
+        nk::utils::memFree(image->cpuData, NkMemoryTag::IMAGE);
         image->cpuData = nullptr;
         image->state |= NK_IMAGE_BIT_UPLOADED;
     }
@@ -1444,76 +1821,84 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
     nk::d3d12::updateTextureAtlas(canvas->base.frameTextureAtlas, commandList);
 #endif
 
-    // Upload vertex buffers
+    // Upload vertex ranges written this frame
     NkCanvasDrawBatchInternalArray& drawBatchArray =
         canvas->base.drawBatchArray[currentFrameIndex];
+    NkCanvasVertexRingBuffer& vertexRingBuffer = canvas->base.vertexRingBuffer;
+    uint32_t vertexRangeNum = vertexRingBuffer.frameRangeNum();
     D3D12_RESOURCE_BARRIER* resourceBarriers =
         (D3D12_RESOURCE_BARRIER*)_malloca(sizeof(D3D12_RESOURCE_BARRIER) *
-                                          (drawBatchArray.drawBatchNum + 1));
+                                          (vertexRangeNum + 1));
     if (!resourceBarriers) {
         NK_PANIC("Can't allocate vertex buffer barriers");
         return;
     }
-    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
-        NkCanvasDrawBatchInternal& drawBatch =
-            drawBatchArray.drawBatches[index];
-        NkCanvasVertexBuffer* vertexBuffer = drawBatch.buffer;
+    uint32_t vertexBarrierNum = 0;
+    NkCanvasVertexBuffer* lastVertexBuffer = nullptr;
+    for (uint32_t index = 0; index < vertexRangeNum; ++index) {
+        NkCanvasVertexRange& range = vertexRingBuffer.frameRange(index);
         NkD3D12DynamicBuffer* vertexBufferDynamic =
-            (NkD3D12DynamicBuffer*)vertexBuffer->gpuVertexBuffer;
+            (NkD3D12DynamicBuffer*)range.buffer->gpuVertexBuffer;
+        size_t rangeOffset = range.offset * sizeof(NkCanvasVertex);
+        size_t rangeSize = range.count * sizeof(NkCanvasVertex);
+        D3D12_RANGE readRange = {0, 0};
         void* mappedVertices = nullptr;
-        D3D_ASSERT(
-            vertexBufferDynamic->uploadBuffer->Map(0, nullptr, &mappedVertices),
-            "Error: Failed to map vertex buffer");
+        D3D_ASSERT(vertexBufferDynamic->uploadBuffer->Map(0, &readRange,
+                                                          &mappedVertices),
+                   "Error: Failed to map vertex buffer");
         if (mappedVertices) {
-            memcpy(mappedVertices, vertexBuffer->vertices,
-                   vertexBuffer->vertexCount * sizeof(NkCanvasVertex));
+            memcpy((uint8_t*)mappedVertices + rangeOffset,
+                   &range.buffer->vertices[range.offset], rangeSize);
         } else {
             NK_PANIC("Error: Invalid address for vertex buffer");
         }
-        D3D12_RANGE writeRange = {0, vertexBuffer->vertexCount *
-                                         sizeof(NkCanvasVertex)};
+        D3D12_RANGE writeRange = {rangeOffset, rangeOffset + rangeSize};
         vertexBufferDynamic->uploadBuffer->Unmap(0, &writeRange);
-        resourceBarriers[index].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-        resourceBarriers[index].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-        resourceBarriers[index].Transition.Subresource = 0;
-        resourceBarriers[index].Transition.pResource =
-            vertexBufferDynamic->resource.resource;
-        resourceBarriers[index].Transition.StateBefore =
-            vertexBufferDynamic->resource.state;
-        resourceBarriers[index].Transition.StateAfter =
-            D3D12_RESOURCE_STATE_COPY_DEST;
+        NK_CANVAS_STAT_ADD(canvas->base, uploadedBytes, rangeSize);
+        // Ranges of the same buffer are contiguous in the frame so only one
+        // transition per buffer is needed.
+        if (range.buffer == lastVertexBuffer) {
+            continue;
+        }
+        lastVertexBuffer = range.buffer;
+        D3D12_RESOURCE_BARRIER& barrier = resourceBarriers[vertexBarrierNum++];
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.Subresource = 0;
+        barrier.Transition.pResource = vertexBufferDynamic->resource.resource;
+        barrier.Transition.StateBefore = vertexBufferDynamic->resource.state;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
     }
 
     // batch the RTV barrier with the vertex buffers
-    resourceBarriers[drawBatchArray.drawBatchNum].Type =
+    resourceBarriers[vertexBarrierNum].Type =
         D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    resourceBarriers[drawBatchArray.drawBatchNum].Transition.pResource =
-        backbuffer;
-    resourceBarriers[drawBatchArray.drawBatchNum].Transition.StateBefore =
+    resourceBarriers[vertexBarrierNum].Transition.pResource = backbuffer;
+    resourceBarriers[vertexBarrierNum].Transition.StateBefore =
         D3D12_RESOURCE_STATE_PRESENT;
-    resourceBarriers[drawBatchArray.drawBatchNum].Transition.StateAfter =
+    resourceBarriers[vertexBarrierNum].Transition.StateAfter =
         D3D12_RESOURCE_STATE_RENDER_TARGET;
-    resourceBarriers[drawBatchArray.drawBatchNum].Transition.Subresource = 0;
-    resourceBarriers[drawBatchArray.drawBatchNum].Flags =
-        D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    resourceBarriers[vertexBarrierNum].Transition.Subresource = 0;
+    resourceBarriers[vertexBarrierNum].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
     if (canvas->renderTarget) {
-        resourceBarriers[drawBatchArray.drawBatchNum].Transition.StateBefore =
+        resourceBarriers[vertexBarrierNum].Transition.StateBefore =
             D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
     }
 
-    commandList->ResourceBarrier(drawBatchArray.drawBatchNum + 1,
-                                 resourceBarriers);
-    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
-        NkCanvasDrawBatchInternal& drawBatch =
-            drawBatchArray.drawBatches[index];
-        NkCanvasVertexBuffer* vertexBuffer = drawBatch.buffer;
+    commandList->ResourceBarrier(vertexBarrierNum + 1, resourceBarriers);
+    for (uint32_t index = 0; index < vertexRangeNum; ++index) {
+        NkCanvasVertexRange& range = vertexRingBuffer.frameRange(index);
         NkD3D12DynamicBuffer* vertexBufferDynamic =
-            (NkD3D12DynamicBuffer*)vertexBuffer->gpuVertexBuffer;
-        commandList->CopyResource(vertexBufferDynamic->resource.resource,
-                                  vertexBufferDynamic->uploadBuffer);
+            (NkD3D12DynamicBuffer*)range.buffer->gpuVertexBuffer;
+        size_t rangeOffset = range.offset * sizeof(NkCanvasVertex);
+        commandList->CopyBufferRegion(vertexBufferDynamic->resource.resource,
+                                      rangeOffset,
+                                      vertexBufferDynamic->uploadBuffer,
+                                      rangeOffset,
+                                      range.count * sizeof(NkCanvasVertex));
     }
 
-    for (uint32_t index = 0; index < drawBatchArray.drawBatchNum; ++index) {
+    for (uint32_t index = 0; index < vertexBarrierNum; ++index) {
         D3D12_RESOURCE_STATES before =
             resourceBarriers[index].Transition.StateBefore;
         resourceBarriers[index].Transition.StateBefore =
@@ -1521,7 +1906,9 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
         resourceBarriers[index].Transition.StateAfter = before;
     }
 
-    commandList->ResourceBarrier(drawBatchArray.drawBatchNum, resourceBarriers);
+    if (vertexBarrierNum > 0) {
+        commandList->ResourceBarrier(vertexBarrierNum, resourceBarriers);
+    }
 
     // Write frame setup commands
     commandList->OMSetRenderTargets(1, &rtvHandle, true, nullptr);
@@ -1560,7 +1947,11 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
     indexBufferView.SizeInBytes =
         (uint32_t)((NkD3D12DynamicBuffer*)canvas->base.gpuIndexBuffer)
             ->resource.desc.Width;
+#if NK_CANVAS_16BIT_INDICES_ENABLED
+    indexBufferView.Format = DXGI_FORMAT_R16_UINT;
+#else
     indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+#endif
     commandList->IASetIndexBuffer(&indexBufferView);
 
 #if NK_CANVAS_TEXTURE_ATLAS_ENABLED
@@ -1615,9 +2006,32 @@ void nk::d3d12::drawFrame(NkCanvas* canvas, uint64_t currentFrameIndex) {
     NkCanvasDrawBatchInternal* drawBatches = drawBatchArray.drawBatches;
     ID3D12Resource* vertexBuffer = nullptr;
 
+    NkCanvasScissorRect currentScissor = {0, 0, (uint32_t)viewWidth,
+                                          (uint32_t)viewHeight};
+    NkBlendMode currentBlendMode = NkBlendMode::ALPHA;
+
     for (uint32_t index = 0, num = drawBatchArray.drawBatchNum; index < num;
          ++index) {
         NkCanvasDrawBatchInternal& drawBatch = drawBatches[index];
+        if (drawBatch.count == 0) {
+            continue;
+        }
+        NkCanvasScissorRect batchScissor = nk::canvas_internal::scissorRect(
+            drawBatch, viewWidth, viewHeight);
+        if (memcmp(&batchScissor, &currentScissor, sizeof(batchScissor)) !=
+            0) {
+            scissor.left = (LONG)batchScissor.x;
+            scissor.top = (LONG)batchScissor.y;
+            scissor.right = (LONG)(batchScissor.x + batchScissor.width);
+            scissor.bottom = (LONG)(batchScissor.y + batchScissor.height);
+            commandList->RSSetScissorRects(1, &scissor);
+            currentScissor = batchScissor;
+        }
+        if (drawBatch.blendMode != currentBlendMode) {
+            commandList->SetPipelineState(
+                canvas->spritePSO[(uint32_t)drawBatch.blendMode]);
+            currentBlendMode = drawBatch.blendMode;
+        }
         NkD3D12DynamicBuffer* drawBatchVertexBuffer =
             (NkD3D12DynamicBuffer*)drawBatch.buffer->gpuVertexBuffer;
         if (vertexBuffer != drawBatchVertexBuffer->resource.resource) {
@@ -1692,7 +2106,12 @@ void nk::d3d12::updateTextureAtlas(NkTextureAtlas& textureAtlas,
     textureAtlasDest.pResource = (ID3D12Resource*)textureAtlas.gpuTexture;
     textureAtlasDest.SubresourceIndex = 0;
 
-        D3D12_RESOURCE_BARRIER* barriers = (D3D12_RESOURCE_BARRIER*)nk::utils::memRealloc(nullptr, (sizeof(D3D12_RESOURCE_BARRIER) * ((uint32_t)textureAtlas.images.size() + 1));
+    D3D12_RESOURCE_BARRIER* barriers =
+        (D3D12_RESOURCE_BARRIER*)nk::utils::memRealloc(
+            nullptr,
+            sizeof(D3D12_RESOURCE_BARRIER) *
+                ((uint32_t)textureAtlas.images.size() + 1),
+            NkMemoryTag::TEXTURE_ATLAS);
 	if (!barriers) {
         NK_ASSERT(0, "Error: Failed to allocated resource barriers");
         return;
@@ -1748,7 +2167,7 @@ void nk::d3d12::updateTextureAtlas(NkTextureAtlas& textureAtlas,
 
 	commandList->ResourceBarrier(numBarriers, barriers);
 
-	nk::utils::memFree(barriers);
+	nk::utils::memFree(barriers, NkMemoryTag::TEXTURE_ATLAS);
 }
 #endif
 
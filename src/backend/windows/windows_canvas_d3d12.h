@@ -124,6 +124,20 @@ struct NkD3D12CommandList {
     ID3D12CommandAllocator* commandAllocator;
 };
 
+// Copy of a render target into a readback heap buffer. The fence reaches
+// fenceValue once the copy is done. Finished readbacks go back to the
+// canvas pool and are reused by the next read of the same size.
+struct NkD3D12Readback {
+    NkCanvas* canvas;
+    NkD3D12CommandList commandList;
+    ID3D12Resource* buffer;
+    ID3D12Fence* fence;
+    uint64_t fenceValue;
+    void* mappedData; // Stays mapped while the readback is pooled
+    uint64_t bufferSize;
+    uint32_t rowPitch;
+};
+
 struct NkCanvas {
     NkCanvasBase base;
     NkApp* app;
@@ -133,7 +147,7 @@ struct NkCanvas {
     ID3D12CommandQueue* commandQueue;
     IDXGISwapChain3* swapChain;
     ID3D12RootSignature* spriteRootSignature;
-    ID3D12PipelineState* spritePSO;
+    ID3D12PipelineState* spritePSO[NK_CANVAS_BLEND_MODE_COUNT];
     ID3D12Resource* backbuffers[NK_CANVAS_D3D12_MAX_FRAMES];
     float clearColor[4];
     NkImageArray imageUploads[NK_CANVAS_MAX_FRAMES];
@@ -144,6 +158,8 @@ struct NkCanvas {
     uint32_t imageNum;
 #endif
     NkImage* renderTarget;
+    NkD3D12Readback* readbackPool[NK_CANVAS_MAX_READBACKS]; // Oldest first
+    uint32_t readbackPoolNum;
 };
 
 #define NK_IMAGE_BIT_UPLOADED                  0b00001
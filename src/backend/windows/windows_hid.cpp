@@ -1,93 +1,96 @@
 #include "../hid_internal.h"
+#include "../utils.h"
 #include "windows_common.h"
 #include "windows_structs.h"
 #include <nk/hid.h>
 
-void nk::hid::update(NkHID* hid, NkApp* app) {
+static void pushMouseEvent(NkHID* hid, const MSG& message,
+                           NkInputEventType type, NkMouseButton button,
+                           uint64_t timeNs) {
+    NkInputEvent event{};
+    event.type = type;
+    event.timeNs = timeNs;
+    event.button = button;
+    event.mouseX = (float)GET_X_LPARAM(message.lParam);
+    event.mouseY = (float)GET_Y_LPARAM(message.lParam);
+    nk::hid::pushEvent(hid, event);
+}
 
-    hid->keyboard.lastChar = 0;
-    memset(hid->keyboard.keysClick, 0, sizeof(hid->keyboard.keysClick));
-    memset(hid->mouse.buttonsClick, 0, sizeof(hid->mouse.buttonsClick));
-    hid->mouse.wheelDeltaX = 0.0f;
-    hid->mouse.wheelDeltaY = 0.0f;
+void nk::hid::update(NkHID* hid, NkApp* app) {
+    // MSG::time has millisecond precision on the GetTickCount clock. It's
+    // moved to the timeNs clock so events keep their time within the frame.
+    uint64_t nowNs = nk::utils::timeNs();
+    DWORD nowMs = GetTickCount();
 
     for (uint32_t index = 0; index < app->eventBuffer.eventNum; ++index) {
-        MSG event = app->eventBuffer.events[index];
-        switch (event.message) {
+        MSG message = app->eventBuffer.events[index];
+        uint64_t timeNs =
+            nowNs - (uint64_t)(DWORD)(nowMs - message.time) * 1000000ULL;
+        NkInputEvent event{};
+        event.timeNs = timeNs;
+        switch (message.message) {
         case WM_MOUSEWHEEL:
-            hid->mouse.wheelDeltaY =
-                (float)GET_WHEEL_DELTA_WPARAM(event.wParam) /
-                (float)WHEEL_DELTA;
+            event.type = NkInputEventType::MOUSE_WHEEL;
+            event.wheelDeltaY = (float)GET_WHEEL_DELTA_WPARAM(message.wParam) /
+                                (float)WHEEL_DELTA;
+            nk::hid::pushEvent(hid, event);
             break;
         case WM_MOUSEHWHEEL:
-            hid->mouse.wheelDeltaX =
-                -(float)GET_WHEEL_DELTA_WPARAM(event.wParam) /
+            event.type = NkInputEventType::MOUSE_WHEEL;
+            event.wheelDeltaX =
+                -(float)GET_WHEEL_DELTA_WPARAM(message.wParam) /
                 (float)WHEEL_DELTA;
+            nk::hid::pushEvent(hid, event);
             break;
         case WM_CHAR:
-            hid->keyboard.lastChar = (char)event.wParam;
+            event.type = NkInputEventType::CHAR;
+            event.character = (uint32_t)message.wParam;
+            nk::hid::pushEvent(hid, event);
             break;
         case WM_KEYDOWN:
-            if (!hid->keyboard.keysDown[(uint8_t)event.wParam]) {
-                hid->keyboard.keysClick[(uint8_t)event.wParam] = true;
-            }
-            hid->keyboard.keysDown[(uint8_t)event.wParam] = true;
-            TranslateMessage(&event);
+            event.type = NkInputEventType::KEY_DOWN;
+            event.keyCode = (NkKeyCode)(uint8_t)message.wParam;
+            nk::hid::pushEvent(hid, event);
+            TranslateMessage(&message);
             break;
         case WM_KEYUP:
-            hid->keyboard.keysDown[(uint8_t)event.wParam] = false;
-            hid->keyboard.keysClick[(uint8_t)event.wParam] = false;
+            event.type = NkInputEventType::KEY_UP;
+            event.keyCode = (NkKeyCode)(uint8_t)message.wParam;
+            nk::hid::pushEvent(hid, event);
             break;
         case WM_MOUSEMOVE:
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_MOVE,
+                           NkMouseButton::LEFT, timeNs);
             break;
         case WM_LBUTTONDOWN:
-            if (!hid->mouse.buttonsDown[(uint32_t)NkMouseButton::LEFT]) {
-                hid->mouse.buttonsClick[(uint32_t)NkMouseButton::LEFT] = true;
-            }
-            hid->mouse.buttonsDown[(uint32_t)NkMouseButton::LEFT] = true;
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_DOWN,
+                           NkMouseButton::LEFT, timeNs);
             break;
         case WM_LBUTTONUP:
-            hid->mouse.buttonsDown[(uint32_t)NkMouseButton::LEFT] = false;
-            hid->mouse.buttonsClick[(uint32_t)NkMouseButton::LEFT] = false;
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_UP,
+                           NkMouseButton::LEFT, timeNs);
             break;
         case WM_RBUTTONDOWN:
-            if (!hid->mouse.buttonsDown[(uint32_t)NkMouseButton::RIGHT]) {
-                hid->mouse.buttonsClick[(uint32_t)NkMouseButton::RIGHT] = true;
-            }
-            hid->mouse.buttonsDown[(uint32_t)NkMouseButton::RIGHT] = true;
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_DOWN,
+                           NkMouseButton::RIGHT, timeNs);
             break;
         case WM_RBUTTONUP:
-            hid->mouse.buttonsDown[(uint32_t)NkMouseButton::RIGHT] = false;
-            hid->mouse.buttonsClick[(uint32_t)NkMouseButton::RIGHT] = false;
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_UP,
+                           NkMouseButton::RIGHT, timeNs);
             break;
         case WM_MBUTTONDOWN:
-            if (!hid->mouse.buttonsDown[(uint32_t)NkMouseButton::MIDDLE]) {
-                hid->mouse.buttonsClick[(uint32_t)NkMouseButton::MIDDLE] = true;
-            }
-            hid->mouse.buttonsDown[(uint32_t)NkMouseButton::MIDDLE] = true;
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_DOWN,
+                           NkMouseButton::MIDDLE, timeNs);
             break;
         case WM_MBUTTONUP:
-            hid->mouse.buttonsDown[(uint32_t)NkMouseButton::MIDDLE] = false;
-            hid->mouse.buttonsClick[(uint32_t)NkMouseButton::MIDDLE] = false;
-            hid->mouse.positionX = (float)GET_X_LPARAM(event.lParam);
-            hid->mouse.positionY = (float)GET_Y_LPARAM(event.lParam);
+            pushMouseEvent(hid, message, NkInputEventType::MOUSE_UP,
+                           NkMouseButton::MIDDLE, timeNs);
             break;
         default:
             break;
         }
     }
+    nk::hid::applyEvents(hid);
 }
 
 void nk::hid::showCursor(NkHID* hid, bool visible) {
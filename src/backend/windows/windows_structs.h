@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../frame_clock.h"
 #include "windows_common.h"
 #include <nk/canvas.h>
 #include <nk/hid.h>
@@ -15,6 +16,7 @@ struct NkApp {
     NkAppEventBuffer eventBuffer;
     NkCanvas* canvas;
     NkHID* hid;
+    NkFrameClock frameClock;
     HWND windowHandle;
     uint32_t windowWidth;
     uint32_t windowHeight;
@@ -1,41 +1,14 @@
 #include "../utils.h"
 #include "windows_common.h"
 
-#define NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE  4096
-#define NK_UTILS_WINDOWS_LOG_MAX_BUFFER_COUNT 4
-
-static NkReallocFunc globalRealloc = nullptr;
-static NkFreeFunc globalFree = nullptr;
-
-void nk::utils::exit(uint32_t exitCode) { ExitProcess(exitCode); }
-
-void nk::utils::logFmt(const char* fmt, ...) {
-    static char bufferLarge[NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE *
-                            NK_UTILS_WINDOWS_LOG_MAX_BUFFER_COUNT] = {};
-    static uint32_t bufferIndex = 0;
-    va_list args;
-    va_start(args, fmt);
-    char* buffer =
-        &bufferLarge[bufferIndex * NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE];
-    vsprintf_s(buffer, NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE, fmt, args);
-    bufferIndex = (bufferIndex + 1) % NK_UTILS_WINDOWS_LOG_MAX_BUFFER_COUNT;
-    va_end(args);
-    OutputDebugStringA(buffer);
-    printf("%s", buffer);
+void nk::utils::exit(uint32_t exitCode) {
+    flushLog();
+    ExitProcess(exitCode);
 }
 
-const char* nk::utils::tempString(const char* fmt, ...) {
-    static char bufferLarge[NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE *
-                            NK_UTILS_WINDOWS_LOG_MAX_BUFFER_COUNT] = {};
-    static uint32_t bufferIndex = 0;
-    va_list args;
-    va_start(args, fmt);
-    char* buffer =
-        &bufferLarge[bufferIndex * NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE];
-    vsprintf_s(buffer, NK_UTILS_WINDOWS_LOG_MAX_BUFFER_SIZE, fmt, args);
-    bufferIndex = (bufferIndex + 1) % NK_UTILS_WINDOWS_LOG_MAX_BUFFER_COUNT;
-    va_end(args);
-    return buffer;
+void nk::utils::logWrite(const char* message) {
+    OutputDebugStringA(message);
+    printf("%s", message);
 }
 
 size_t nk::utils::bsf(size_t value) {
@@ -56,33 +29,36 @@ size_t nk::utils::bsr(size_t value) {
 
 size_t nk::utils::popcnt(size_t value) { return __popcnt64(value); }
 
-void nk::utils::initMemoryFunctions(NkReallocFunc reallocFunc,
-                                    NkFreeFunc freeFunc) {
-    globalRealloc = reallocFunc;
-    globalFree = freeFunc;
-    if (globalRealloc == nullptr || globalFree == nullptr) {
-        NK_LOG("Using stdlib realloc and free");
-        globalRealloc = &realloc;
-        globalFree = &free;
+uint64_t nk::utils::timeNs() {
+    static LARGE_INTEGER frequency = {};
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
     }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000ULL +
+           remainder * 1000000000ULL / frequency.QuadPart;
 }
 
-void* nk::utils::memRealloc(void* ptr, size_t size) {
-    NK_ASSERT_EXIT(globalRealloc,
-                   "Error: Memory allocation functions not setup. "
-                   "nk::utils::initMemoryFunctions must be called.");
-    return globalRealloc(ptr, size);
-}
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
-void nk::utils::memFree(void* ptr) {
-    NK_ASSERT_EXIT(globalFree,
-                   "Error: Memory allocation functions not setup. "
-                   "nk::utils::initMemoryFunctions must be called.");
-    globalFree(ptr);
-}
-
-void* nk::utils::memZeroAlloc(size_t num, size_t size) {
-    void* ptr = memRealloc(nullptr, size * num);
-    memset(ptr, 0, size * num);
-    return ptr;
+void nk::utils::sleepNs(uint64_t ns) {
+    // High resolution waitable timers need Windows 10 1803. Older versions
+    // fall back to Sleep, which rounds to the scheduler tick.
+    static thread_local HANDLE timer = CreateWaitableTimerExW(
+        nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+        TIMER_ALL_ACCESS);
+    if (timer) {
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(LONGLONG)(ns / 100); // Relative, in 100ns units
+        if (SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+            WaitForSingleObject(timer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD)(ns / 1000000));
 }
@@ -0,0 +1,139 @@
+// Replays a draw stream recorded with nk::canvas::beginCapture and reports
+// the CPU time of every frame.
+//
+// Usage: nk_replay <capture file> [loop count]
+
+#include <canvas_capture.h>
+#include <nk/app.h>
+#include <nk/canvas.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <utils.h>
+#include <vector>
+
+struct ReplayTimings {
+    uint32_t frameNum;
+    double totalTime;
+    double minTime;
+    double maxTime;
+};
+
+static NkImage* createReplayImage(NkCanvas* canvas,
+                                  const NkCanvasCaptureReader& reader) {
+    const NkCanvasCaptureImage& image = reader.image();
+    if (image.renderTarget) {
+        return nk::canvas::createRenderTargetImage(canvas, image.width,
+                                                   image.height);
+    }
+    if (image.pixelDataSize > 0) {
+        return nk::canvas::createImage(canvas, image.width, image.height,
+                                       reader.pixels(), image.format);
+    }
+    // Created before the capture started, so the pixels weren't recorded.
+    std::vector<uint32_t> pixels((size_t)image.width * image.height,
+                                 0xffffffff);
+    return nk::canvas::createImage(canvas, image.width, image.height,
+                                   pixels.data(), image.format);
+}
+
+static bool replay(NkApp* app, const char* path, uint32_t loop,
+                   ReplayTimings& timings) {
+    NkCanvas* canvas = nk::app::canvas(app);
+    NkCanvasCaptureReader reader{};
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    std::vector<NkImage*> images;
+    while (!nk::app::shouldQuit(app) && reader.next()) {
+        switch (reader.type()) {
+        case NkCanvasCaptureRecordType::IMAGE_CREATE: {
+            uint32_t imageId = reader.image().imageId;
+            if (imageId >= images.size()) {
+                images.resize(imageId + 1, nullptr);
+            }
+            images[imageId] = createReplayImage(canvas, reader);
+            break;
+        }
+        case NkCanvasCaptureRecordType::IMAGE_DESTROY: {
+            uint32_t imageId = reader.imageDestroy().imageId;
+            if (imageId < images.size()) {
+                nk::canvas::destroyImage(canvas, images[imageId]);
+                images[imageId] = nullptr;
+            }
+            break;
+        }
+        case NkCanvasCaptureRecordType::FRAME: {
+            const NkCanvasCaptureFrame& frame = reader.frame();
+            NkImage* renderTarget = frame.renderTargetId < images.size()
+                                        ? images[frame.renderTargetId]
+                                        : nullptr;
+            nk::app::update(app);
+
+            uint64_t startTime = nk::utils::timeNs();
+            if (renderTarget) {
+                nk::canvas::beginFrame(canvas, renderTarget,
+                                       frame.clearColor[0], frame.clearColor[1],
+                                       frame.clearColor[2],
+                                       frame.clearColor[3]);
+            } else {
+                nk::canvas::beginFrame(canvas, frame.clearColor[0],
+                                       frame.clearColor[1], frame.clearColor[2],
+                                       frame.clearColor[3]);
+            }
+            nk::canvas_capture::replayFrame(canvas, reader, images.data(),
+                                            (uint32_t)images.size());
+            nk::canvas::endFrame(canvas);
+            if (!renderTarget) {
+                nk::canvas::present(canvas);
+            }
+            double frameTime =
+                (double)(nk::utils::timeNs() - startTime) / 1.0e6;
+
+            printf("loop %u frame %u: %.3f ms (%u batches, %u quads)\n", loop,
+                   timings.frameNum, frameTime, frame.batchNum, frame.quadNum);
+            timings.minTime = timings.frameNum == 0
+                                  ? frameTime
+                                  : nk::utils::min(timings.minTime, frameTime);
+            timings.maxTime = nk::utils::max(timings.maxTime, frameTime);
+            timings.totalTime += frameTime;
+            timings.frameNum++;
+            break;
+        }
+        }
+    }
+
+    for (NkImage* image : images) {
+        if (image) {
+            nk::canvas::destroyImage(canvas, image);
+        }
+    }
+    reader.close();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: nk_replay <capture file> [loop count]\n");
+        return 1;
+    }
+    uint32_t loopNum = argc > 2 ? (uint32_t)atoi(argv[2]) : 1;
+
+    NkApp* app = nk::app::create({960, 640, "nk_replay"});
+    ReplayTimings timings{};
+    for (uint32_t loop = 0; loop < loopNum && !nk::app::shouldQuit(app);
+         ++loop) {
+        if (!replay(app, argv[1], loop, timings)) {
+            nk::app::destroy(app);
+            return 1;
+        }
+    }
+    nk::app::destroy(app);
+
+    if (timings.frameNum > 0) {
+        printf("%u frames: avg %.3f ms, min %.3f ms, max %.3f ms\n",
+               timings.frameNum, timings.totalTime / timings.frameNum,
+               timings.minTime, timings.maxTime);
+    }
+    return 0;
+}